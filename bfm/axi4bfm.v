@@ -4,9 +4,25 @@
 //
 // Copyright (c) 2024 Simon Southwell.
 //
-// Implements minimal compliant manager interface at 32-bits wide.
-// Also has a 32-bit vectored irq input. Does not (yet) utilise
-// VProc's burst capabilities.
+// Implements a manager interface at 32-bits wide, with VProc bursts
+// mapped to AXI INCR bursts, and multiple outstanding transactions.
+// Also has a 32-bit vectored irq input.
+//
+// Writes are posted: each VProc write beat is acknowledged once
+// buffered, and is split into AXI bursts of at most 256 beats that
+// do not cross a 4Kbyte boundary. Up to MAX_OUTSTANDING write bursts
+// may be awaiting a response. All writes use ID 0, so they complete
+// in order.
+//
+// A VProc burst read is issued as up to MAX_OUTSTANDING AXI bursts at
+// once (split as for writes), each with its own ID, and the read data
+// reassembled in order, so a slave may return bursts out of order. A
+// read waits for all outstanding writes to complete, so that it
+// returns written data.
+//
+// For AXI bursts, VProc must be compiled with VPROC_BURST_IF defined,
+// and BURST_ADDR_INCR be 4 (byte addressing), else every access is a
+// single beat. Byte enables (wstrb) need VPROC_BYTE_ENABLE defined.
 //
 // This file is part of VProc.
 //
@@ -29,7 +45,10 @@ module axi4bfm
 #(parameter ADDRWIDTH           = 32,       // For future proofing. Do not change
             DATAWIDTH           = 32,       // For future proofing. Do not change
             IRQWIDTH            = 32,       // Valid ranges => 1 to 32
-            BURST_ADDR_INCR     = 1,        // Valid values => 1, 2, 4
+            BURST_ADDR_INCR     = 4,        // Valid values => 1, 2, 4 (4 for AXI bursts)
+            ID_WIDTH            = 4,        // Valid ranges => 1 to 8
+            MAX_OUTSTANDING     = 4,        // Valid ranges => 1 to 2**ID_WIDTH
+            WR_BUF_LOG2         = 9,        // Write buffer depth (log2). Valid ranges => 1 to 12
             NODE                = 0
 )
 (
@@ -40,92 +59,214 @@ module axi4bfm
   output                        awvalid,
   input                         awready,
   output               [2:0]    awprot,
+  output      [ID_WIDTH-1:0]    awid,
+  output               [7:0]    awlen,
+  output               [2:0]    awsize,
+  output               [1:0]    awburst,
 
   // Write Data channel
   output     [DATAWIDTH-1:0]    wdata,
   output                        wvalid,
   input                         wready,
   output                        wlast,
+  output               [3:0]    wstrb,
 
   // Write response channel
   input                         bvalid,
   output                        bready,
+  input       [ID_WIDTH-1:0]    bid,
 
   // Read address channel
   output     [ADDRWIDTH-1:0]    araddr,
   output                        arvalid,
   input                         arready,
   output               [2:0]    arprot,
+  output      [ID_WIDTH-1:0]    arid,
+  output               [7:0]    arlen,
+  output               [2:0]    arsize,
+  output               [1:0]    arburst,
 
   // Read data/response channel
   input      [DATAWIDTH-1:0]    rdata,
   input                         rvalid,
   output                        rready,
+  input                         rlast,
+  input       [ID_WIDTH-1:0]    rid,
 
   // Interrupt request (non-AXI side bus)
   input       [IRQWIDTH-1:0]    irq
 );
 
+// ---------------------------------------------------------
+// Local parameters
+// ---------------------------------------------------------
+
+localparam AXI_MAX_LEN          = 256;
+localparam AXI_BOUNDARY         = 4096;
+localparam AXI_SIZE_WORD        = 3'b010;
+localparam AXI_BURST_INCR       = 2'b01;
+localparam NUM_IDS              = 1 << ID_WIDTH;
+localparam WR_BUF_DEPTH         = 1 << WR_BUF_LOG2;
+localparam RD_BUF_DEPTH         = 4096;     // Maximum VProc burst length
+
 // ---------------------------------------------------------
 // Signal and register declarations
 // ---------------------------------------------------------
 
 // Virtual processor memory mapped address port signals
 wire                     [31:0] vpdataout;
+wire                     [31:0] vpdatain;
 wire                     [31:0] vpaddr;
 wire                            vpwe;
 wire                            vprd;
 wire                            vpwrack;
 wire                            vprdack;
+wire                      [3:0] vpbe;
+wire                     [11:0] vpburst;
+wire                     [12:0] vpbeats;
 
 // Delta cycle signals
 wire                            update;
 reg                             updateresponse;
 
-// Internal state to flag an AXI channel has been acknowleged,
-// but transaction is still pending
-reg                             awacked;
-reg                             wacked;
-reg                             aracked;
+// Write state. The beats remaining in the current VProc burst and AXI
+// burst, and the number of AXI write bursts queued or awaiting response.
+reg                             wr_active;
+reg                      [12:0] wr_remain;
+reg                       [8:0] wr_seg_remain;
+reg                [ID_WIDTH:0] wr_out;
+
+// Write address queue (never more than MAX_OUTSTANDING entries)
+reg             [ADDRWIDTH-1:0] awq_addr  [0:NUM_IDS-1];
+reg                       [7:0] awq_len   [0:NUM_IDS-1];
+reg              [ID_WIDTH-1:0] awq_wr;
+reg              [ID_WIDTH-1:0] awq_rd;
+reg                [ID_WIDTH:0] awq_count;
+
+// Write data buffer
+reg             [DATAWIDTH-1:0] wb_data   [0:WR_BUF_DEPTH-1];
+reg                       [3:0] wb_strb   [0:WR_BUF_DEPTH-1];
+reg                             wb_last   [0:WR_BUF_DEPTH-1];
+reg           [WR_BUF_LOG2-1:0] wb_wr;
+reg           [WR_BUF_LOG2-1:0] wb_rd;
+reg             [WR_BUF_LOG2:0] wb_count;
+
+// Read state. The VProc burst length and next beat to return, the next
+// AXI burst to issue, and the bursts outstanding.
+reg                             rd_active;
+reg                      [12:0] rd_total;
+reg                      [12:0] rd_idx;
+reg             [ADDRWIDTH-1:0] rd_issue_addr;
+reg                      [12:0] rd_issue_left;
+reg                      [12:0] rd_issued;
+reg                [ID_WIDTH:0] rd_out;
+reg              [ID_WIDTH-1:0] rd_id;
+
+// Registered read address channel
+reg                             arvalid_r;
+reg             [ADDRWIDTH-1:0] araddr_r;
+reg                       [7:0] arlen_r;
+reg              [ID_WIDTH-1:0] arid_r;
+
+// Per ID read burst state: outstanding flag, offset of the burst's first
+// beat in the VProc burst, and the number of beats received
+reg               [NUM_IDS-1:0] rd_busy;
+reg                      [11:0] rd_base   [0:NUM_IDS-1];
+reg                       [8:0] rd_cnt    [0:NUM_IDS-1];
+
+// Read data reassembly buffer, with a valid flag per beat
+reg             [DATAWIDTH-1:0] rd_buf    [0:RD_BUF_DEPTH-1];
+reg          [RD_BUF_DEPTH-1:0] rd_vld;
+
+integer                         idx;
+
+// ---------------------------------------------------------
+// Length of the next AXI burst, of at most remain beats, not
+// exceeding the AXI maximum nor crossing a 4Kbyte boundary
+// ---------------------------------------------------------
+
+function integer seglen (input integer addr, input integer remain);
+  integer to_boundary;
+begin
+  to_boundary                   = (AXI_BOUNDARY - (addr & (AXI_BOUNDARY-1))) / 4;
+
+  seglen                        = remain;
+  seglen                        = (seglen > AXI_MAX_LEN) ? AXI_MAX_LEN : seglen;
+  seglen                        = (seglen > to_boundary) ? to_boundary : seglen;
+  seglen                        = (seglen < 1 || BURST_ADDR_INCR != 4) ? 1 : seglen;
+end
+endfunction
 
 // ---------------------------------------------------------
 // Combinatorial logic
 // ---------------------------------------------------------
 
-// Default signalling (no protection, and write response always acknowleged)
+// Number of beats in a new VProc access (a non-burst access has a count of 0)
+assign vpbeats                  = (vpburst == 12'd0) ? 13'd1 : {1'b0, vpburst};
+
+// Default signalling (no protection, INCR word bursts, and responses always acknowledged)
 assign awprot                   = 3'b000;
 assign arprot                   = 3'b000;
+assign awsize                   = AXI_SIZE_WORD;
+assign arsize                   = AXI_SIZE_WORD;
+assign awburst                  = AXI_BURST_INCR;
+assign arburst                  = AXI_BURST_INCR;
 assign bready                   = bvalid;
+assign rready                   = rvalid;
+
+// --- Write ---
+
+// Beats remaining in the VProc burst (including the current beat), whether the
+// current beat starts a new AXI burst, and that burst's length
+wire                     [12:0] wr_remain_now = wr_active ? wr_remain : vpbeats;
+wire                            wr_seg_start  = (wr_seg_remain == 9'd0);
+wire                      [8:0] wr_seg_len    = seglen(vpaddr, wr_remain_now);
+
+// A write beat is acknowledged once buffered, as long as there is space,
+// and if it starts a new AXI burst, the outstanding limit isn't reached.
+assign vpwrack                  = (wb_count < WR_BUF_DEPTH) & (~wr_seg_start | (wr_out < MAX_OUTSTANDING));
+
+wire                            w_push        = vpwe & vpwrack;
+wire                            aw_push       = w_push & wr_seg_start;
+wire                            aw_pop        = awvalid & awready;
+wire                            w_pop         = wvalid & wready;
+wire                            b_done        = bvalid & bready;
 
 // The address/write data ports are only valid when their valid signals active,
 // else driven X. This ensures external IP does not use invalid held values.
-assign awaddr                   = awvalid ? vpaddr    : {ADDRWIDTH{1'bx}};
-assign araddr                   = arvalid ? vpaddr    : {ADDRWIDTH{1'bx}};
-assign wdata                    = wvalid  ? vpdataout : {DATAWIDTH{1'bx}};
+assign awvalid                  = (awq_count != 0);
+assign awaddr                   = awvalid ? awq_addr[awq_rd] : {ADDRWIDTH{1'bx}};
+assign awlen                    = awq_len[awq_rd];
+assign awid                     = {ID_WIDTH{1'b0}};
 
-// The write address and valid signals active when VProc writing,
-// but only until they have been acknowledged.
-assign awvalid                  = vpwe & ~awacked;
-assign wvalid                   = vpwe & ~wacked;
+assign wvalid                   = (wb_count != 0);
+assign wdata                    = wvalid  ? wb_data[wb_rd] : {DATAWIDTH{1'bx}};
+assign wstrb                    = wb_strb[wb_rd];
+assign wlast                    = wvalid & wb_last[wb_rd];
 
-// VProc write acknowledged only once both address and write channels have
-// been acknowledged. This could be if both channels acknowledged together,
-// if write address acknowledged first then write data, or write data acknowledged
-// first and then write address.
-assign vpwrack                  = (awready & wready) | (awacked & wready) | (awready & wacked);
+// --- Read ---
 
-// Write Last always signalled when data valid as only one word at a time.
-assign wlast                    = wvalid;
+// A read starts once all writes are complete
+wire                            wr_idle       = ~wr_active & (wr_out == 0) & (wb_count == 0);
+wire                            rd_start      = vprd & ~rd_active & wr_idle;
 
-// The read address is valid when VProc RD strobe active until it has
-// been acknowledged.
-assign arvalid                  = vprd & ~aracked;
+// Issue the next AXI read burst when the channel is free, an ID is free and
+// the outstanding limit isn't reached
+wire                      [8:0] rd_seg_len    = seglen(rd_issue_addr, rd_issue_left);
+wire                            ar_issue      = rd_active & (rd_issue_left != 0) & ~arvalid_r & ~rd_busy[rd_id] & (rd_out < MAX_OUTSTANDING);
 
-// Read data always accepted.
-assign rready                   = rvalid;
+wire                            r_beat        = rvalid & rready;
+wire                            r_done        = r_beat & rlast;
+wire                     [11:0] r_idx         = rd_base[rid] + rd_cnt[rid];
 
-// The VProc read acknowlege comes straight from the AXI read data bus valid.
-assign vprdack                  = rvalid;
+assign arvalid                  = arvalid_r;
+assign araddr                   = arvalid ? araddr_r : {ADDRWIDTH{1'bx}};
+assign arlen                    = arlen_r;
+assign arid                     = arid_r;
+
+// A VProc read beat is acknowledged when its data has arrived
+assign vprdack                  = rd_active & rd_vld[rd_idx[11:0]];
+assign vpdatain                 = rd_buf[rd_idx[11:0]];
 
 // ---------------------------------------------------------
 // Initialise the internal state.
@@ -133,33 +274,150 @@ assign vprdack                  = rvalid;
 
 initial
 begin
-  aracked                       = 1'b0;
-  awacked                       = 1'b0;
-  wacked                        = 1'b0;
   updateresponse                = 1'b1;
+
+  wr_active                     = 1'b0;
+  wr_remain                     = 0;
+  wr_seg_remain                 = 0;
+  wr_out                        = 0;
+  awq_wr                        = 0;
+  awq_rd                        = 0;
+  awq_count                     = 0;
+  wb_wr                         = 0;
+  wb_rd                         = 0;
+  wb_count                      = 0;
+
+  rd_active                     = 1'b0;
+  rd_total                      = 0;
+  rd_idx                        = 0;
+  rd_issue_addr                 = 0;
+  rd_issue_left                 = 0;
+  rd_issued                     = 0;
+  rd_out                        = 0;
+  rd_id                         = 0;
+  arvalid_r                     = 1'b0;
+  araddr_r                      = 0;
+  arlen_r                       = 0;
+  arid_r                        = 0;
+  rd_busy                       = 0;
+  rd_vld                        = 0;
+
+  for (idx = 0; idx < NUM_IDS; idx = idx + 1)
+  begin
+    awq_addr[idx]               = 0;
+    awq_len[idx]                = 0;
+    rd_base[idx]                = 0;
+    rd_cnt[idx]                 = 0;
+  end
 end
 
 // ---------------------------------------------------------
-// Synchronous process to generate state to indicate acknowledged
-// a channel has been acknowledged whilst the transaction is
-// incomplete.
+// Synchronous write process. VProc write beats are buffered,
+// with a write address queued at the start of each AXI burst.
 // ---------------------------------------------------------
 
 always @(posedge clk)
 begin
-  // A channel is flagged as acknowledged if the VProc strobe active and the AXI
-  // ready signal is active. This state is held until The entire transaction
-  // is acknowledged back to VProc.
-
-  // Read address channel
-  aracked                       <= (aracked | (vprd & arready)) & ~vprdack;
-
-  // Write address channel
-  awacked                       <= (awacked | (vpwe & awready)) & ~vpwrack;
+  if (w_push)
+  begin
+    wb_data[wb_wr]              <= vpdataout;
+    wb_strb[wb_wr]              <= vpbe;
+    wb_last[wb_wr]              <= wr_seg_start ? (wr_seg_len == 9'd1) : (wr_seg_remain == 9'd1);
+    wb_wr                       <= wb_wr + 1;
+
+    wr_seg_remain               <= (wr_seg_start ? wr_seg_len : wr_seg_remain) - 9'd1;
+    wr_remain                   <= wr_remain_now - 13'd1;
+    wr_active                   <= (wr_remain_now != 13'd1);
+  end
+
+  if (aw_push)
+  begin
+    awq_addr[awq_wr]            <= vpaddr;
+    awq_len[awq_wr]             <= wr_seg_len - 9'd1;
+    awq_wr                      <= awq_wr + 1;
+  end
+
+  if (w_pop)
+  begin
+    wb_rd                       <= wb_rd + 1;
+  end
+
+  if (aw_pop)
+  begin
+    awq_rd                      <= awq_rd + 1;
+  end
+
+  wb_count                      <= wb_count  + w_push  - w_pop;
+  awq_count                     <= awq_count + aw_push - aw_pop;
+  wr_out                        <= wr_out    + aw_push - b_done;
+end
 
-  // Write data channel
-  wacked                        <= (wacked  | (vpwe & wready))  & ~vpwrack;
+// ---------------------------------------------------------
+// Synchronous read process. A VProc read is issued as AXI
+// bursts, each with its own ID, and the returned data placed
+// in order in the reassembly buffer.
+// ---------------------------------------------------------
 
+always @(posedge clk)
+begin
+  if (rd_start)
+  begin
+    rd_active                   <= 1'b1;
+    rd_total                    <= vpbeats;
+    rd_idx                      <= 13'd0;
+    rd_issue_addr               <= vpaddr;
+    rd_issue_left               <= vpbeats;
+    rd_issued                   <= 13'd0;
+  end
+
+  // Issue a read burst, noting where its data goes in the buffer
+  if (ar_issue)
+  begin
+    arvalid_r                   <= 1'b1;
+    araddr_r                    <= rd_issue_addr;
+    arlen_r                     <= rd_seg_len - 9'd1;
+    arid_r                      <= rd_id;
+
+    rd_busy[rd_id]              <= 1'b1;
+    rd_base[rd_id]              <= rd_issued[11:0];
+    rd_cnt[rd_id]               <= 9'd0;
+    rd_id                       <= rd_id + 1;
+
+    rd_issue_addr               <= rd_issue_addr + {rd_seg_len, 2'b00};
+    rd_issue_left               <= rd_issue_left - rd_seg_len;
+    rd_issued                   <= rd_issued     + rd_seg_len;
+  end
+  else if (arvalid & arready)
+  begin
+    arvalid_r                   <= 1'b0;
+  end
+
+  // Store returned read data
+  if (r_beat)
+  begin
+    rd_buf[r_idx]               <= rdata;
+    rd_vld[r_idx]               <= 1'b1;
+    rd_cnt[rid]                 <= rd_cnt[rid] + 9'd1;
+  end
+
+  if (r_done)
+  begin
+    rd_busy[rid]                <= 1'b0;
+  end
+
+  rd_out                        <= rd_out + ar_issue - r_done;
+
+  // Return data to VProc in order
+  if (vprd & vprdack)
+  begin
+    rd_vld[rd_idx[11:0]]        <= 1'b0;
+    rd_idx                      <= rd_idx + 13'd1;
+
+    if (rd_idx == rd_total - 13'd1)
+    begin
+      rd_active                 <= 1'b0;
+    end
+  end
 end
 
 // ---------------------------------------------------------
@@ -177,18 +435,28 @@ end
 // Virtual Processor
 // ---------------------------------------------------------
 
+`ifndef VPROC_BURST_IF
+assign vpburst                  = 12'd0;
+`endif
+
+`ifndef VPROC_BYTE_ENABLE
+assign vpbe                     = 4'hf;
+`endif
+
   VProc    #(.INT_WIDTH         (IRQWIDTH),
              .BURST_ADDR_INCR   (BURST_ADDR_INCR)
             ) vp
             (.Clk               (clk),
 
              .Addr              (vpaddr),
-
+`ifdef VPROC_BYTE_ENABLE
+             .BE                (vpbe),
+`endif
              .DataOut           (vpdataout),
              .WE                (vpwe),
              .WRAck             (vpwrack),
 
-             .DataIn            (rdata),
+             .DataIn            (vpdatain),
              .RD                (vprd),
              .RDAck             (vprdack),
 
@@ -196,7 +464,12 @@ end
 
              .Update            (update),
              .UpdateResponse    (updateresponse),
+`ifdef VPROC_BURST_IF
+             .Burst             (vpburst),
+             .BurstFirst        (),
+             .BurstLast         (),
+`endif
              .Node              (NODE[3:0])
             );
 
-endmodule
\ No newline at end of file
+endmodule
@@ -0,0 +1,221 @@
+// ====================================================================
+//
+// Verilog AXI subordinate memory model, for use with the VProc AXI
+// BFM.
+//
+// Copyright (c) 2024 Simon Southwell.
+//
+// A 32-bit wide memory supporting INCR bursts. Read addresses are
+// queued (up to 2**QUEUE_LOG2) while earlier bursts are returning
+// data, with each burst's data starting RD_LATENCY cycles after its
+// address was accepted, so that reads are pipelined. Read bursts are
+// returned in order. Write bursts are processed one at a time, with
+// a response after the last beat.
+//
+// This file is part of VProc.
+//
+// VProc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VProc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VProc. If not, see <http://www.gnu.org/licenses/>.
+//
+// ====================================================================
+
+module axi4mem
+#(parameter ADDRWIDTH           = 32,       // For future proofing. Do not change
+            DATAWIDTH           = 32,       // For future proofing. Do not change
+            ID_WIDTH            = 4,        // Valid ranges => 1 to 8
+            MEM_LOG2            = 16,       // Memory size in words (log2)
+            RD_LATENCY          = 4,        // Valid ranges => 1 upwards
+            QUEUE_LOG2          = 2         // Read address queue depth (log2)
+)
+(
+  input                         clk,
+
+  // Write address channel
+  input      [ADDRWIDTH-1:0]    awaddr,
+  input                         awvalid,
+  output                        awready,
+  input       [ID_WIDTH-1:0]    awid,
+  input                [7:0]    awlen,
+
+  // Write Data channel
+  input      [DATAWIDTH-1:0]    wdata,
+  input                         wvalid,
+  output                        wready,
+  input                         wlast,
+  input                [3:0]    wstrb,
+
+  // Write response channel
+  output reg                    bvalid,
+  input                         bready,
+  output reg  [ID_WIDTH-1:0]    bid,
+
+  // Read address channel
+  input      [ADDRWIDTH-1:0]    araddr,
+  input                         arvalid,
+  output                        arready,
+  input       [ID_WIDTH-1:0]    arid,
+  input                [7:0]    arlen,
+
+  // Read data/response channel
+  output     [DATAWIDTH-1:0]    rdata,
+  output                        rvalid,
+  input                         rready,
+  output                        rlast,
+  output      [ID_WIDTH-1:0]    rid
+);
+
+localparam QUEUE_DEPTH          = 1 << QUEUE_LOG2;
+
+// ---------------------------------------------------------
+// Signal and register declarations
+// ---------------------------------------------------------
+
+reg             [DATAWIDTH-1:0] mem       [0:(1 << MEM_LOG2)-1];
+
+// Write burst state
+reg                             wr_busy;
+reg              [MEM_LOG2-1:0] wr_addr;
+
+// Read address queue, with the cycle each burst may start returning data
+reg              [MEM_LOG2-1:0] arq_addr  [0:QUEUE_DEPTH-1];
+reg                       [7:0] arq_len   [0:QUEUE_DEPTH-1];
+reg              [ID_WIDTH-1:0] arq_id    [0:QUEUE_DEPTH-1];
+reg                      [31:0] arq_time  [0:QUEUE_DEPTH-1];
+reg            [QUEUE_LOG2-1:0] arq_wr;
+reg            [QUEUE_LOG2-1:0] arq_rd;
+reg              [QUEUE_LOG2:0] arq_count;
+
+// Current read burst state
+reg                             rd_active;
+reg              [MEM_LOG2-1:0] rd_addr;
+reg                       [7:0] rd_left;
+reg              [ID_WIDTH-1:0] rd_id;
+
+reg                      [31:0] cycle;
+
+// ---------------------------------------------------------
+// Combinatorial logic
+// ---------------------------------------------------------
+
+assign awready                  = ~wr_busy;
+assign wready                   = wr_busy & ~bvalid;
+
+assign arready                  = (arq_count != QUEUE_DEPTH);
+
+wire                            ar_push   = arvalid & arready;
+wire                            r_beat    = rvalid & rready;
+wire                            r_done    = r_beat & rlast;
+
+// Start the next queued burst when its latency has expired, and no burst
+// is returning data (or the current one is completing)
+wire                            ar_pop    = (arq_count != 0) & (cycle >= arq_time[arq_rd]) & (~rd_active | r_done);
+
+assign rvalid                   = rd_active;
+assign rdata                    = mem[rd_addr];
+assign rlast                    = rd_active & (rd_left == 8'd0);
+assign rid                      = rd_id;
+
+// ---------------------------------------------------------
+// Initialise the internal state.
+// ---------------------------------------------------------
+
+initial
+begin
+  wr_busy                       = 1'b0;
+  wr_addr                       = 0;
+  bvalid                        = 1'b0;
+  bid                           = 0;
+  arq_wr                        = 0;
+  arq_rd                        = 0;
+  arq_count                     = 0;
+  rd_active                     = 1'b0;
+  rd_addr                       = 0;
+  rd_left                       = 0;
+  rd_id                         = 0;
+  cycle                         = 0;
+end
+
+// ---------------------------------------------------------
+// Synchronous write process
+// ---------------------------------------------------------
+
+always @(posedge clk)
+begin
+  if (awvalid & awready)
+  begin
+    wr_busy                     <= 1'b1;
+    wr_addr                     <= awaddr[MEM_LOG2+1:2];
+    bid                         <= awid;
+  end
+
+  if (wvalid & wready)
+  begin
+    if (wstrb[0]) mem[wr_addr][7:0]   <= wdata[7:0];
+    if (wstrb[1]) mem[wr_addr][15:8]  <= wdata[15:8];
+    if (wstrb[2]) mem[wr_addr][23:16] <= wdata[23:16];
+    if (wstrb[3]) mem[wr_addr][31:24] <= wdata[31:24];
+
+    wr_addr                     <= wr_addr + 1;
+
+    if (wlast)
+    begin
+      bvalid                    <= 1'b1;
+    end
+  end
+
+  if (bvalid & bready)
+  begin
+    bvalid                      <= 1'b0;
+    wr_busy                     <= 1'b0;
+  end
+end
+
+// ---------------------------------------------------------
+// Synchronous read process
+// ---------------------------------------------------------
+
+always @(posedge clk)
+begin
+  cycle                         <= cycle + 1;
+
+  if (ar_push)
+  begin
+    arq_addr[arq_wr]            <= araddr[MEM_LOG2+1:2];
+    arq_len[arq_wr]             <= arlen;
+    arq_id[arq_wr]              <= arid;
+    arq_time[arq_wr]            <= cycle + RD_LATENCY;
+    arq_wr                      <= arq_wr + 1;
+  end
+
+  if (ar_pop)
+  begin
+    rd_active                   <= 1'b1;
+    rd_addr                     <= arq_addr[arq_rd];
+    rd_left                     <= arq_len[arq_rd];
+    rd_id                       <= arq_id[arq_rd];
+    arq_rd                      <= arq_rd + 1;
+  end
+  else if (r_done)
+  begin
+    rd_active                   <= 1'b0;
+  end
+  else if (r_beat)
+  begin
+    rd_addr                     <= rd_addr + 1;
+    rd_left                     <= rd_left - 8'd1;
+  end
+
+  arq_count                     <= arq_count + ar_push - ar_pop;
+end
+
+endmodule
@@ -0,0 +1,326 @@
+// ====================================================================
+//
+// Verilog AXI4-Stream bus functional model (BFM) wrapper for VProc.
+//
+// Copyright (c) 2024 Simon Southwell.
+//
+// Implements a 32-bit stream source (tx_*) and sink (rx_*), driven
+// by whole frames from the VStreamSend() and VStreamRecv() API
+// functions, so that a frame is transferred in a single VProc burst
+// exchange, rather than an exchange per beat. Also has a 32-bit
+// vectored irq input.
+//
+// Transmit: a VProc burst write to an address with bit 31 clear is a
+// frame (or, with bit 30 set, part of a frame not yet complete). Each
+// beat is acknowledged once buffered in a FIFO, so backpressure on
+// tx_tready stalls VProc only when the FIFO is full. tlast is
+// generated on the burst's last beat, tkeep from the byte enables
+// (the last beat's being partial for frames not a multiple of 4
+// bytes) and tuser from address bits [15:8].
+//
+// Receive: frames are buffered, with rx_tready deasserted when either
+// the data or frame FIFOs are full. A read of the status register
+// (0x80000000) returns 0 if there is no complete frame, or pops the
+// next frame's length, tuser and a valid bit. The frame's data is
+// then returned by a burst read of the data register (0x80000004).
+// Received frames are expected to be packed, with only the last beat
+// having null bytes in tkeep.
+//
+// VProc must be compiled with VPROC_BURST_IF defined (else every beat
+// is a frame), and with VPROC_BYTE_ENABLE defined for frames that are
+// not a multiple of 4 bytes.
+//
+// This file is part of VProc.
+//
+// VProc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VProc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VProc. If not, see <http://www.gnu.org/licenses/>.
+//
+// ====================================================================
+
+module axisbfm
+#(parameter DATAWIDTH           = 32,       // For future proofing. Do not change
+            IRQWIDTH            = 32,       // Valid ranges => 1 to 32
+            TUSER_WIDTH         = 8,        // Valid ranges => 1 to 8
+            TX_FIFO_LOG2        = 4,        // Transmit FIFO depth in beats (log2)
+            RX_FIFO_LOG2        = 12,       // Receive FIFO depth in beats (log2). Must hold the largest frame
+            RX_FRAMES_LOG2      = 4,        // Receive frame FIFO depth (log2)
+            NODE                = 0
+)
+(
+  input                         clk,
+
+  // Transmit stream (source)
+  output     [DATAWIDTH-1:0]    tx_tdata,
+  output                        tx_tvalid,
+  input                         tx_tready,
+  output                        tx_tlast,
+  output               [3:0]    tx_tkeep,
+  output   [TUSER_WIDTH-1:0]    tx_tuser,
+
+  // Receive stream (sink)
+  input      [DATAWIDTH-1:0]    rx_tdata,
+  input                         rx_tvalid,
+  output                        rx_tready,
+  input                         rx_tlast,
+  input                [3:0]    rx_tkeep,
+  input    [TUSER_WIDTH-1:0]    rx_tuser,
+
+  // Interrupt request
+  input       [IRQWIDTH-1:0]    irq
+);
+
+// ---------------------------------------------------------
+// Local parameters
+// ---------------------------------------------------------
+
+localparam TX_FIFO_DEPTH        = 1 << TX_FIFO_LOG2;
+localparam RX_FIFO_DEPTH        = 1 << RX_FIFO_LOG2;
+localparam RX_FRAMES_DEPTH      = 1 << RX_FRAMES_LOG2;
+
+localparam RX_SEL_BIT           = 31;
+localparam TX_NOLAST_BIT        = 30;
+localparam TUSER_LSB            = 8;
+localparam RX_DATA_BIT          = 2;
+
+// ---------------------------------------------------------
+// Signal and register declarations
+// ---------------------------------------------------------
+
+// Virtual processor memory mapped address port signals
+wire                     [31:0] vpdataout;
+wire                     [31:0] vpdatain;
+wire                     [31:0] vpaddr;
+wire                            vpwe;
+wire                            vprd;
+wire                            vpwrack;
+wire                            vprdack;
+wire                      [3:0] vpbe;
+wire                            vpburstlast;
+
+// Delta cycle signals
+wire                            update;
+reg                             updateresponse;
+
+// Transmit FIFO
+reg             [DATAWIDTH-1:0] txf_data  [0:TX_FIFO_DEPTH-1];
+reg                       [3:0] txf_keep  [0:TX_FIFO_DEPTH-1];
+reg                             txf_last  [0:TX_FIFO_DEPTH-1];
+reg           [TUSER_WIDTH-1:0] txf_user  [0:TX_FIFO_DEPTH-1];
+reg          [TX_FIFO_LOG2-1:0] txf_wr;
+reg          [TX_FIFO_LOG2-1:0] txf_rd;
+reg            [TX_FIFO_LOG2:0] txf_count;
+
+// Receive data FIFO
+reg             [DATAWIDTH-1:0] rxf_data  [0:RX_FIFO_DEPTH-1];
+reg          [RX_FIFO_LOG2-1:0] rxf_wr;
+reg          [RX_FIFO_LOG2-1:0] rxf_rd;
+reg            [RX_FIFO_LOG2:0] rxf_count;
+
+// Receive frame FIFO (byte length and tuser of each complete frame),
+// and the byte count of the frame being received
+reg                      [15:0] rxq_len   [0:RX_FRAMES_DEPTH-1];
+reg           [TUSER_WIDTH-1:0] rxq_user  [0:RX_FRAMES_DEPTH-1];
+reg        [RX_FRAMES_LOG2-1:0] rxq_wr;
+reg        [RX_FRAMES_LOG2-1:0] rxq_rd;
+reg          [RX_FRAMES_LOG2:0] rxq_count;
+reg                      [15:0] rx_len;
+
+// ---------------------------------------------------------
+// Number of valid bytes in a packed tkeep
+// ---------------------------------------------------------
+
+function [2:0] keepbytes (input [3:0] keep);
+begin
+  keepbytes                     = keep[0] + keep[1] + keep[2] + keep[3];
+end
+endfunction
+
+// ---------------------------------------------------------
+// Combinatorial logic
+// ---------------------------------------------------------
+
+wire                            vp_rx     = vpaddr[RX_SEL_BIT];
+
+// --- Transmit ---
+
+// A write beat is acknowledged once buffered. Writes to the receive
+// registers are ignored.
+wire                            tx_push   = vpwe & ~vp_rx & (txf_count != TX_FIFO_DEPTH);
+wire                            tx_pop    = tx_tvalid & tx_tready;
+
+assign tx_tvalid                = (txf_count != 0);
+assign tx_tdata                 = tx_tvalid ? txf_data[txf_rd] : {DATAWIDTH{1'bx}};
+assign tx_tkeep                 = txf_keep[txf_rd];
+assign tx_tlast                 = tx_tvalid & txf_last[txf_rd];
+assign tx_tuser                 = txf_user[txf_rd];
+
+// --- Receive ---
+
+wire                            rx_beat   = rx_tvalid & rx_tready;
+wire                            rx_end    = rx_beat & rx_tlast;
+
+assign rx_tready                = (rxf_count != RX_FIFO_DEPTH) & (rxq_count != RX_FRAMES_DEPTH);
+
+wire                            rxq_vld   = (rxq_count != 0);
+wire                            rd_status = vprd & vp_rx & ~vpaddr[RX_DATA_BIT];
+wire                            rd_data   = vprd & vp_rx &  vpaddr[RX_DATA_BIT];
+
+// A status read pops a frame if there is one. A data read beat is
+// acknowledged when the FIFO has data. Reads from the transmit
+// addresses return 0.
+wire                            rxq_pop   = rd_status & rxq_vld;
+wire                            rxf_pop   = rd_data   & (rxf_count != 0);
+
+wire                      [7:0] rxq_user8 = rxq_user[rxq_rd];
+wire                     [31:0] rx_status = rxq_vld ? {1'b1, 7'd0, rxq_user8, rxq_len[rxq_rd]} : 32'h0;
+
+assign vpwrack                  = vp_rx | (txf_count != TX_FIFO_DEPTH);
+assign vprdack                  = ~vp_rx | rd_status | (rxf_count != 0);
+assign vpdatain                 = ~vp_rx     ? 32'h0     :
+                                  rd_status  ? rx_status :
+                                               rxf_data[rxf_rd];
+
+// ---------------------------------------------------------
+// Initialise the internal state.
+// ---------------------------------------------------------
+
+initial
+begin
+  updateresponse                = 1'b1;
+
+  txf_wr                        = 0;
+  txf_rd                        = 0;
+  txf_count                     = 0;
+
+  rxf_wr                        = 0;
+  rxf_rd                        = 0;
+  rxf_count                     = 0;
+  rxq_wr                        = 0;
+  rxq_rd                        = 0;
+  rxq_count                     = 0;
+  rx_len                        = 0;
+end
+
+// ---------------------------------------------------------
+// Synchronous transmit process. VProc write beats are
+// buffered, marked with tlast on the last beat of a frame.
+// ---------------------------------------------------------
+
+always @(posedge clk)
+begin
+  if (tx_push)
+  begin
+    txf_data[txf_wr]            <= vpdataout;
+    txf_keep[txf_wr]            <= vpbe;
+    txf_last[txf_wr]            <= vpburstlast & ~vpaddr[TX_NOLAST_BIT];
+    txf_user[txf_wr]            <= vpaddr[TUSER_LSB +: TUSER_WIDTH];
+    txf_wr                      <= txf_wr + 1;
+  end
+
+  if (tx_pop)
+  begin
+    txf_rd                      <= txf_rd + 1;
+  end
+
+  txf_count                     <= txf_count + tx_push - tx_pop;
+end
+
+// ---------------------------------------------------------
+// Synchronous receive process. Stream beats are buffered,
+// with a frame's length and tuser queued on its last beat.
+// ---------------------------------------------------------
+
+always @(posedge clk)
+begin
+  if (rx_beat)
+  begin
+    rxf_data[rxf_wr]            <= rx_tdata;
+    rxf_wr                      <= rxf_wr + 1;
+    rx_len                      <= rx_tlast ? 16'd0 : rx_len + keepbytes(rx_tkeep);
+  end
+
+  if (rx_end)
+  begin
+    rxq_len[rxq_wr]             <= rx_len + keepbytes(rx_tkeep);
+    rxq_user[rxq_wr]            <= rx_tuser;
+    rxq_wr                      <= rxq_wr + 1;
+  end
+
+  if (rxf_pop)
+  begin
+    rxf_rd                      <= rxf_rd + 1;
+  end
+
+  if (rxq_pop)
+  begin
+    rxq_rd                      <= rxq_rd + 1;
+  end
+
+  rxf_count                     <= rxf_count + rx_beat - rxf_pop;
+  rxq_count                     <= rxq_count + rx_end  - rxq_pop;
+end
+
+// ---------------------------------------------------------
+// Delta cycle update process. Currently unused, but
+// functionality can be added here, such as upgrade
+// for wider bus architecture.
+// ---------------------------------------------------------
+
+always @(update)
+begin
+  updateresponse                <= ~updateresponse;
+end
+
+// ---------------------------------------------------------
+// Virtual Processor. The address is not incremented over a
+// burst, so that the frame's tuser and flags are held.
+// ---------------------------------------------------------
+
+`ifndef VPROC_BURST_IF
+assign vpburstlast              = 1'b1;
+`endif
+
+`ifndef VPROC_BYTE_ENABLE
+assign vpbe                     = 4'hf;
+`endif
+
+  VProc    #(.INT_WIDTH         (IRQWIDTH),
+             .BURST_ADDR_INCR   (0)
+            ) vp
+            (.Clk               (clk),
+
+             .Addr              (vpaddr),
+`ifdef VPROC_BYTE_ENABLE
+             .BE                (vpbe),
+`endif
+             .DataOut           (vpdataout),
+             .WE                (vpwe),
+             .WRAck             (vpwrack),
+
+             .DataIn            (vpdatain),
+             .RD                (vprd),
+             .RDAck             (vprdack),
+
+             .Interrupt         (irq),
+
+             .Update            (update),
+             .UpdateResponse    (updateresponse),
+`ifdef VPROC_BURST_IF
+             .Burst             (),
+             .BurstFirst        (),
+             .BurstLast         (vpburstlast),
+`endif
+             .Node              (NODE[3:0])
+            );
+
+endmodule
@@ -0,0 +1,187 @@
+// ====================================================================
+//
+// Verilog partition bridge target for VProc.
+//
+// Copyright (c) 2024 Simon Southwell.
+//
+// The simulation side of a bridge between two partitions of a test
+// bench, each in its own simulator process. Accesses on the target
+// port (the same request/acknowledge protocol as the VProc bus
+// interface) are forwarded by the VProc node's user code, running
+// VBridgeMaster(), to the other partition, where a VProc node running
+// VBridgeSlave() replays them. The request is held until the response
+// comes back. The other partition's interrupt state is reflected on
+// irq_out.
+//
+// The VProc node's user code sees the request through registers:
+//
+//   0x00 R : status (bit 0 request pending, bit 1 write)
+//   0x04 R : request address
+//   0x08 R : request write data
+//   0x0c R : request byte enables
+//   0x10 W : complete request, with read data
+//   0x14 W : irq_out
+//
+// with the first four read as a single burst. The VProc interrupt
+// input is the pending flag, so that an interruptible tick ends when
+// a request arrives.
+//
+// This file is part of VProc.
+//
+// VProc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VProc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VProc. If not, see <http://www.gnu.org/licenses/>.
+//
+// ====================================================================
+
+module bridgetgt
+#(parameter IRQWIDTH            = 32,       // Valid ranges => 1 to 32
+            NODE                = 0
+)
+(
+  input                         clk,
+
+  // Target port
+  input                  [31:0] addr,
+  input                  [31:0] wdata,
+  input                   [3:0] be,
+  input                         we,
+  input                         rd,
+  output reg                    ack,
+  output reg             [31:0] rdata,
+
+  // Interrupt state of the other partition
+  output reg     [IRQWIDTH-1:0] irq_out
+);
+
+// ---------------------------------------------------------
+// Local parameters
+// ---------------------------------------------------------
+
+localparam REG_STATUS           = 3'd0;
+localparam REG_ADDR             = 3'd1;
+localparam REG_WDATA            = 3'd2;
+localparam REG_BE               = 3'd3;
+localparam REG_COMPLETE         = 3'd4;
+localparam REG_IRQ              = 3'd5;
+
+// ---------------------------------------------------------
+// Signal and register declarations
+// ---------------------------------------------------------
+
+// Virtual processor memory mapped address port signals
+wire                     [31:0] vpdataout;
+wire                     [31:0] vpaddr;
+wire                            vpwe;
+wire                            vprd;
+reg                      [31:0] vpdatain;
+
+// Delta cycle signals
+wire                            update;
+reg                             updateresponse;
+
+// ---------------------------------------------------------
+// Combinatorial logic
+// ---------------------------------------------------------
+
+// A request is pending until its acknowledge
+wire                            pending   = (we | rd) & ~ack;
+
+wire                      [2:0] vpreg     = vpaddr[4:2];
+
+always @(*)
+begin
+  case (vpreg)
+  REG_STATUS: vpdatain          = {30'd0, we, pending};
+  REG_ADDR:   vpdatain          = addr;
+  REG_WDATA:  vpdatain          = wdata;
+  REG_BE:     vpdatain          = {28'd0, be};
+  default:    vpdatain          = 32'd0;
+  endcase
+end
+
+// ---------------------------------------------------------
+// Initialise the internal state.
+// ---------------------------------------------------------
+
+initial
+begin
+  updateresponse                = 1'b1;
+  ack                           = 1'b0;
+  rdata                         = 32'd0;
+  irq_out                       = {IRQWIDTH{1'b0}};
+end
+
+// ---------------------------------------------------------
+// Synchronous process. Completing a request pulses the
+// acknowledge for a cycle.
+// ---------------------------------------------------------
+
+always @(posedge clk)
+begin
+  ack                           <= 1'b0;
+
+  if (vpwe && vpreg == REG_COMPLETE)
+  begin
+    ack                         <= 1'b1;
+    rdata                       <= vpdataout;
+  end
+
+  if (vpwe && vpreg == REG_IRQ)
+  begin
+    irq_out                     <= vpdataout[IRQWIDTH-1:0];
+  end
+end
+
+// ---------------------------------------------------------
+// Delta cycle update process. Currently unused.
+// ---------------------------------------------------------
+
+always @(update)
+begin
+  updateresponse                <= ~updateresponse;
+end
+
+// ---------------------------------------------------------
+// Virtual Processor
+// ---------------------------------------------------------
+
+  VProc    #(.INT_WIDTH         (1),
+             .BURST_ADDR_INCR   (4)
+            ) vp
+            (.Clk               (clk),
+
+             .Addr              (vpaddr),
+`ifdef VPROC_BYTE_ENABLE
+             .BE                (),
+`endif
+             .DataOut           (vpdataout),
+             .WE                (vpwe),
+             .WRAck             (1'b1),
+
+             .DataIn            (vpdatain),
+             .RD                (vprd),
+             .RDAck             (1'b1),
+
+             .Interrupt         (pending),
+
+             .Update            (update),
+             .UpdateResponse    (updateresponse),
+`ifdef VPROC_BURST_IF
+             .Burst             (),
+             .BurstFirst        (),
+             .BurstLast         (),
+`endif
+             .Node              (NODE[3:0])
+            );
+
+endmodule
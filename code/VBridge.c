@@ -0,0 +1,437 @@
+//=====================================================================
+//
+// VBridge.c                                          Date: 2024/07/08
+//
+// Copyright (c) 2024 Simon Southwell.
+//
+// This file is part of VProc.
+//
+// VProc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VProc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VProc. If not, see <http://www.gnu.org/licenses/>.
+//
+//=====================================================================
+//
+// Partition bridge user code. Time is synchronised conservatively in
+// windows of lookahead cycles. The master side runs a window, sending
+// any request made in it, with its cycle offset, followed by a sync.
+// The slave side waits for a window's messages before simulating that
+// window, replaying each request at its offset, and so never receives
+// a request in its past. It then returns the responses, and a sync
+// with its interrupt state.
+//
+// The master doesn't wait for these before running its next window,
+// so the two partitions run a window apart, in parallel. A response
+// to a request made in one window completes it at the end of the
+// next, so the lookahead should not exceed the minimum latency
+// expected of an access crossing the bridge.
+//
+// Both sides time windows and offsets with the node's cycle count
+// (VGetCycle()), so every access is charged its real duration. A
+// window on the master side that an access runs past ends when the
+// access does, and its sync carries its length, so that the slave
+// side's windows stay the same length. The slave side's window
+// boundaries and replay cycles are absolute, so a replayed access
+// that takes longer on a slow bus delays the slave side only until
+// it next idles, and the two sides don't drift apart.
+//
+//=====================================================================
+
+#include <string.h>
+#include "VBridge.h"
+
+#ifndef WIN32
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Latest interrupt state of each slave side node
+static uint32_t vbridge_irq[VP_MAX_NODES];
+
+// -------------------------------------------------------------------------
+// VBridgeSend()
+//
+// Sends a message to the other side. Returns non-zero on error.
+// -------------------------------------------------------------------------
+
+static int VBridgeSend (const int fd, const uint32_t type, const uint32_t addr, const uint32_t data,
+                        const uint32_t be, const uint32_t offset)
+{
+    vbridge_msg_t msg   = {type, addr, data, be, offset};
+    const char*   p_msg = (const char*)&msg;
+    size_t        sent  = 0;
+
+    while (sent < sizeof(msg))
+    {
+        ssize_t len = send(fd, p_msg + sent, sizeof(msg) - sent, 0);
+
+        if (len < 0 && errno != EINTR)
+        {
+            VPrint("***Error: VBridge failed to send message (%s)\n", strerror(errno));
+            return 1;
+        }
+
+        sent += (len > 0) ? len : 0;
+    }
+
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// VBridgeRecv()
+//
+// Receives a message from the other side. Returns non-zero if the
+// connection has closed.
+// -------------------------------------------------------------------------
+
+static int VBridgeRecv (const int fd, vbridge_msg_t* msg)
+{
+    ssize_t len;
+
+    do
+    {
+        len = recv(fd, msg, sizeof(vbridge_msg_t), MSG_WAITALL);
+    }
+    while (len < 0 && errno == EINTR);
+
+    if (len != sizeof(vbridge_msg_t))
+    {
+        VPrint("VBridge: connection closed\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// VBridgeAddr()
+//
+// Fills in a Unix domain socket address. Returns non-zero if the name
+// is too long.
+// -------------------------------------------------------------------------
+
+static int VBridgeAddr (struct sockaddr_un* sa, const char* sockname)
+{
+    memset(sa, 0, sizeof(struct sockaddr_un));
+    sa->sun_family = AF_UNIX;
+
+    if (strlen(sockname) >= sizeof(sa->sun_path))
+    {
+        VPrint("***Error: VBridge socket name %s too long\n", sockname);
+        return 1;
+    }
+
+    strcpy(sa->sun_path, sockname);
+
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// Vectored IRQ callbacks. The master side's interrupt is the bridgetgt
+// pending flag, only used to end interruptible ticks, but a callback
+// is registered so that it isn't treated as a level interrupt.
+// -------------------------------------------------------------------------
+
+static int VBridgeIrqIgnore (int irq)
+{
+    (void)irq;
+
+    return 0;
+}
+
+// The slave side's callbacks record the interrupt state for the next
+// sync. Callbacks have no node argument, so there is one per node, for
+// the nodes a Verilog VProc can have.
+#define VBRIDGE_IRQ_NODES       16
+#define VBRIDGE_IRQ_CB(_n)      static int VBridgeIrqSlave##_n (int irq) { vbridge_irq[_n] = irq; return 0; }
+
+VBRIDGE_IRQ_CB(0)  VBRIDGE_IRQ_CB(1)  VBRIDGE_IRQ_CB(2)  VBRIDGE_IRQ_CB(3)
+VBRIDGE_IRQ_CB(4)  VBRIDGE_IRQ_CB(5)  VBRIDGE_IRQ_CB(6)  VBRIDGE_IRQ_CB(7)
+VBRIDGE_IRQ_CB(8)  VBRIDGE_IRQ_CB(9)  VBRIDGE_IRQ_CB(10) VBRIDGE_IRQ_CB(11)
+VBRIDGE_IRQ_CB(12) VBRIDGE_IRQ_CB(13) VBRIDGE_IRQ_CB(14) VBRIDGE_IRQ_CB(15)
+
+static const pVUserIrqCB_t vbridge_irq_cb[VBRIDGE_IRQ_NODES] = {
+    VBridgeIrqSlave0,  VBridgeIrqSlave1,  VBridgeIrqSlave2,  VBridgeIrqSlave3,
+    VBridgeIrqSlave4,  VBridgeIrqSlave5,  VBridgeIrqSlave6,  VBridgeIrqSlave7,
+    VBridgeIrqSlave8,  VBridgeIrqSlave9,  VBridgeIrqSlave10, VBridgeIrqSlave11,
+    VBridgeIrqSlave12, VBridgeIrqSlave13, VBridgeIrqSlave14, VBridgeIrqSlave15
+};
+
+// -------------------------------------------------------------------------
+// VBridgeMaster()
+//
+// Runs the master side of a bridge on a bridgetgt node, connecting to
+// the slave side listening on sockname. Returns when the connection
+// closes, or non-zero on error.
+// -------------------------------------------------------------------------
+
+int VBridgeMaster (const char* sockname, const unsigned lookahead, const unsigned node)
+{
+    struct sockaddr_un sa;
+    vbridge_msg_t      msg;
+    uint32_t           regs[3];
+    uint32_t           status;
+    uint32_t           irq         = 0;
+    int                outstanding = 0;
+    int                waiting     = 0;
+    uint64_t           start;
+    uint64_t           end;
+    uint64_t           now;
+    int                fd;
+
+    if (lookahead == 0 || VBridgeAddr(&sa, sockname))
+    {
+        return 1;
+    }
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+    {
+        VPrint("***Error: VBridgeMaster() failed to create socket (%s)\n", strerror(errno));
+        return 1;
+    }
+
+    // Wait for the slave side to be listening
+    while (connect(fd, (struct sockaddr*)&sa, sizeof(sa)) < 0)
+    {
+        if (!waiting)
+        {
+            VPrint("VBridgeMaster(): node %d waiting for slave side on %s\n", node, sockname);
+            waiting = 1;
+        }
+
+        usleep(10000);
+    }
+
+    VRegIrq(VBridgeIrqIgnore, node);
+
+    if (VBridgeSend(fd, VBRIDGE_MSG_HELLO, 0, lookahead, 0, 0))
+    {
+        close(fd);
+        return 1;
+    }
+
+    start = VGetCycle(node);
+
+    while (1)
+    {
+        end = start + lookahead;
+
+        // Run a window, forwarding any new request with its offset into
+        // the window. The accesses made completing the previous window's
+        // requests, below, count towards this window.
+        while ((now = VGetCycle(node)) < end)
+        {
+            if (!outstanding)
+            {
+                VRead(VBRIDGE_REG_STATUS, &status, 0, node);
+
+                if (status & VBRIDGE_STATUS_PENDING)
+                {
+                    VBurstRead(VBRIDGE_REG_ADDR, regs, 3, node);
+
+                    if (VBridgeSend(fd, (status & VBRIDGE_STATUS_WRITE) ? VBRIDGE_MSG_WRITE : VBRIDGE_MSG_READ,
+                                    regs[0], regs[1], regs[2], (uint32_t)(VGetCycle(node) - start)))
+                    {
+                        close(fd);
+                        return 1;
+                    }
+
+                    outstanding = 1;
+                }
+
+                if ((now = VGetCycle(node)) >= end)
+                {
+                    break;
+                }
+            }
+
+            VTickIrq((unsigned)(end - now), node);
+        }
+
+        // The window ends at the current cycle, if an access ran past its end
+        if (VBridgeSend(fd, VBRIDGE_MSG_SYNC, 0, 0, 0, (uint32_t)(now - start)))
+        {
+            close(fd);
+            return 1;
+        }
+
+        start = now;
+
+        // Process the slave side's messages for the previous window
+        do
+        {
+            if (VBridgeRecv(fd, &msg))
+            {
+                close(fd);
+                return 0;
+            }
+
+            if (msg.type == VBRIDGE_MSG_RESP && outstanding)
+            {
+                VWrite(VBRIDGE_REG_COMPLETE, msg.data, 0, node);
+                outstanding = 0;
+            }
+        }
+        while (msg.type != VBRIDGE_MSG_SYNC);
+
+        if (msg.data != irq)
+        {
+            irq = msg.data;
+            VWrite(VBRIDGE_REG_IRQ, irq, 0, node);
+        }
+    }
+
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// VBridgeSlave()
+//
+// Runs the slave side of a bridge, listening on sockname for the
+// master side, and replaying its requests on this node's bus. Returns
+// when the connection closes, or non-zero on error.
+// -------------------------------------------------------------------------
+
+int VBridgeSlave (const char* sockname, const unsigned lookahead, const unsigned node)
+{
+    struct sockaddr_un sa;
+    vbridge_msg_t      msg;
+    unsigned           data;
+    uint64_t           start;
+    uint64_t           now;
+    int                lfd;
+    int                fd;
+
+    if (VBridgeAddr(&sa, sockname))
+    {
+        return 1;
+    }
+
+    unlink(sockname);
+
+    if ((lfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+        bind(lfd, (struct sockaddr*)&sa, sizeof(sa)) < 0 || listen(lfd, 1) < 0)
+    {
+        VPrint("***Error: VBridgeSlave() failed to listen on %s (%s)\n", sockname, strerror(errno));
+        return 1;
+    }
+
+    VPrint("VBridgeSlave(): node %d waiting for master side on %s\n", node, sockname);
+
+    fd = accept(lfd, NULL, NULL);
+
+    close(lfd);
+    unlink(sockname);
+
+    if (fd < 0 || VBridgeRecv(fd, &msg) || msg.type != VBRIDGE_MSG_HELLO)
+    {
+        VPrint("***Error: VBridgeSlave() failed to connect to master side\n");
+        return 1;
+    }
+
+    if (msg.data != lookahead)
+    {
+        VPrint("***Error: VBridgeSlave() lookahead %d does not match master side's %d\n", lookahead, msg.data);
+        close(fd);
+        return 1;
+    }
+
+    vbridge_irq[node] = 0;
+
+    if (node < VBRIDGE_IRQ_NODES)
+    {
+        VRegIrq(vbridge_irq_cb[node], node);
+    }
+
+    // The first sync stands in for the window before the first
+    if (VBridgeSend(fd, VBRIDGE_MSG_SYNC, 0, 0, 0, 0))
+    {
+        close(fd);
+        return 1;
+    }
+
+    start = VGetCycle(node);
+
+    while (1)
+    {
+        // Replay the master side's requests for this window at their offsets,
+        // or as soon after as a slow bus allows
+        do
+        {
+            if (VBridgeRecv(fd, &msg))
+            {
+                close(fd);
+                return 0;
+            }
+
+            if (msg.type == VBRIDGE_MSG_WRITE || msg.type == VBRIDGE_MSG_READ)
+            {
+                if ((now = VGetCycle(node)) < start + msg.offset)
+                {
+                    VTick((unsigned)(start + msg.offset - now), node);
+                }
+
+                data = 0;
+
+                if (msg.type == VBRIDGE_MSG_WRITE)
+                {
+                    VWriteBE(msg.addr, msg.data, msg.be, 0, node);
+                }
+                else
+                {
+                    VRead(msg.addr, &data, 0, node);
+                }
+
+                if (VBridgeSend(fd, VBRIDGE_MSG_RESP, msg.addr, data, 0, (uint32_t)(VGetCycle(node) - start)))
+                {
+                    close(fd);
+                    return 1;
+                }
+            }
+        }
+        while (msg.type != VBRIDGE_MSG_SYNC);
+
+        // End the window after the master side's window length, from its start
+        start += msg.offset;
+
+        if ((now = VGetCycle(node)) < start)
+        {
+            VTick((unsigned)(start - now), node);
+        }
+
+        if (VBridgeSend(fd, VBRIDGE_MSG_SYNC, 0, vbridge_irq[node], 0, msg.offset))
+        {
+            close(fd);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+#else
+
+int VBridgeMaster (const char* sockname, const unsigned lookahead, const unsigned node)
+{
+    VPrint("***Error: VBridge not supported on this host\n");
+    return 1;
+}
+
+int VBridgeSlave (const char* sockname, const unsigned lookahead, const unsigned node)
+{
+    VPrint("***Error: VBridge not supported on this host\n");
+    return 1;
+}
+
+#endif
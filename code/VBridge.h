@@ -0,0 +1,71 @@
+//=====================================================================
+//
+// VBridge.h                                          Date: 2024/07/08
+//
+// Copyright (c) 2024 Simon Southwell.
+//
+// This file is part of VProc.
+//
+// VProc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VProc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VProc. If not, see <http://www.gnu.org/licenses/>.
+//
+//=====================================================================
+//
+// Bridge between two partitions of a test bench, each in its own
+// simulator process, connected by a Unix domain socket. The master
+// side runs on a node in a bridgetgt component (bfm/bridgetgt.v),
+// forwarding its target port's accesses. The slave side runs on a
+// node in the other simulation, replaying them on its bus.
+//
+//=====================================================================
+
+#ifndef _VBRIDGE_H_
+#define _VBRIDGE_H_
+
+#include "VUser.h"
+
+// bridgetgt register map
+#define VBRIDGE_REG_STATUS      0x00
+#define VBRIDGE_REG_ADDR        0x04
+#define VBRIDGE_REG_WDATA       0x08
+#define VBRIDGE_REG_BE          0x0c
+#define VBRIDGE_REG_COMPLETE    0x10
+#define VBRIDGE_REG_IRQ         0x14
+
+#define VBRIDGE_STATUS_PENDING  0x1
+#define VBRIDGE_STATUS_WRITE    0x2
+
+// Message types
+#define VBRIDGE_MSG_HELLO       0
+#define VBRIDGE_MSG_WRITE       1
+#define VBRIDGE_MSG_READ        2
+#define VBRIDGE_MSG_RESP        3
+#define VBRIDGE_MSG_SYNC        4
+
+// Message between the two sides. The offset is the cycle within the
+// window that a request was made, or a response returned. A sync
+// message's offset is the length of the window it ends, and the
+// slave side's sync carries its interrupt state in its data. A hello
+// carries the lookahead.
+typedef struct {
+    uint32_t            type;
+    uint32_t            addr;
+    uint32_t            data;
+    uint32_t            be;
+    uint32_t            offset;
+} vbridge_msg_t;
+
+extern int VBridgeMaster (const char* sockname, const unsigned lookahead, const unsigned node);
+extern int VBridgeSlave  (const char* sockname, const unsigned lookahead, const unsigned node);
+
+#endif
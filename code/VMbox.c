@@ -0,0 +1,373 @@
+//=====================================================================
+//
+// VMbox.c                                            Date: 2024/07/22
+//
+// Copyright (c) 2024 Simon Southwell.
+//
+// This file is part of VProc.
+//
+// VProc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VProc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VProc. If not, see <http://www.gnu.org/licenses/>.
+//
+//=====================================================================
+//
+// Mailboxes and barriers. Messages are stamped with the sender's
+// simulation time, and are only received by a node once its own time
+// is later. All messages sent before that time were sent before the
+// simulator reached it, so what a node receives doesn't depend on
+// the order in which nodes are scheduled within a time step.
+//
+// A node that has to wait does so with VWaitCond(), so that its user
+// thread is only woken once the message has arrived, or the barrier
+// is released. Waiting nodes are listed on the mailbox or barrier, and
+// woken with VWaitWake() by the node sending to the mailbox, or the
+// last to arrive at the barrier, rather than testing at every clock
+// edge (where the simulator supports it).
+//
+//=====================================================================
+
+#include <string.h>
+#include "VMbox.h"
+
+// Node waiting on a mailbox or barrier, listed on it until woken
+typedef struct vmbox_waiter_s {
+    struct vmbox_waiter_s* next;
+    unsigned            node;
+    int                 listed;
+} vmbox_waiter_t;
+
+// Message queued on a mailbox
+typedef struct vmbox_msg_s {
+    struct vmbox_msg_s* next;
+    uint64_t            time;       // Simulation time the message was sent
+    unsigned            len;
+    uint8_t             data[];
+} vmbox_msg_t;
+
+typedef struct {
+    pthread_mutex_t     lock;
+    vmbox_msg_t*        head;
+    vmbox_msg_t*        tail;
+    vmbox_waiter_t*     waiters;
+} vmbox_t;
+
+typedef struct {
+    pthread_mutex_t     lock;
+    unsigned            arrived;    // Nodes arrived since the last release
+    uint32_t            gen;        // Count of releases
+    uint64_t            time;       // Simulation time of the last release
+    vmbox_waiter_t*     waiters;
+} vbarrier_t;
+
+// Argument of a node's wait on a mailbox, with the message received
+typedef struct {
+    vmbox_t*            mbox;
+    vmbox_msg_t*        msg;
+    vmbox_waiter_t      waiter;
+} vmbox_wait_t;
+
+// Argument of a node's wait on a barrier
+typedef struct {
+    vbarrier_t*         barrier;
+    uint32_t            gen;
+    vmbox_waiter_t      waiter;
+} vbarrier_wait_t;
+
+static vmbox_t          mboxes[VP_MAX_MBOXES];
+static vbarrier_t       barriers[VP_MAX_BARRIERS];
+static pthread_once_t   vmbox_once = PTHREAD_ONCE_INIT;
+
+// -------------------------------------------------------------------------
+// VMboxInit()
+//
+// Initialises the mailbox and barrier locks, once, on first use
+// -------------------------------------------------------------------------
+
+static void VMboxInit (void)
+{
+    int idx;
+
+    for (idx = 0; idx < VP_MAX_MBOXES; idx++)
+    {
+        pthread_mutex_init(&mboxes[idx].lock, NULL);
+    }
+
+    for (idx = 0; idx < VP_MAX_BARRIERS; idx++)
+    {
+        pthread_mutex_init(&barriers[idx].lock, NULL);
+    }
+}
+
+// -------------------------------------------------------------------------
+// VMboxList()
+//
+// Adds a node's waiter to a list. Called with the list's lock held.
+// -------------------------------------------------------------------------
+
+static void VMboxList (vmbox_waiter_t** list, vmbox_waiter_t* waiter, const unsigned node)
+{
+    waiter->node   = node;
+    waiter->listed = 1;
+    waiter->next   = *list;
+    *list          = waiter;
+}
+
+// -------------------------------------------------------------------------
+// VMboxUnlist()
+//
+// Removes a waiter from a list, if it's still on it. Called with the
+// list's lock held.
+// -------------------------------------------------------------------------
+
+static void VMboxUnlist (vmbox_waiter_t** list, vmbox_waiter_t* waiter)
+{
+    for (; waiter->listed && *list != NULL; list = &(*list)->next)
+    {
+        if (*list == waiter)
+        {
+            *list          = waiter->next;
+            waiter->listed = 0;
+        }
+    }
+}
+
+// -------------------------------------------------------------------------
+// VMboxWake()
+//
+// Wakes all the waiters on a list, and empties it. Called with the
+// list's lock held.
+// -------------------------------------------------------------------------
+
+static void VMboxWake (vmbox_waiter_t** list, const unsigned node)
+{
+    vmbox_waiter_t* waiter;
+
+    for (waiter = *list; waiter != NULL; waiter = waiter->next)
+    {
+        waiter->listed = 0;
+        VWaitWake(waiter->node, node);
+    }
+
+    *list = NULL;
+}
+
+// -------------------------------------------------------------------------
+// VMboxGet()
+//
+// Removes the message at the head of a mailbox, if sent before the
+// given time. Returns NULL if there is none.
+// -------------------------------------------------------------------------
+
+static vmbox_msg_t* VMboxGet (vmbox_t* mbox, const uint64_t time)
+{
+    vmbox_msg_t* msg;
+
+    pthread_mutex_lock(&mbox->lock);
+
+    if ((msg = mbox->head) != NULL && msg->time < time)
+    {
+        if ((mbox->head = msg->next) == NULL)
+        {
+            mbox->tail = NULL;
+        }
+    }
+    else
+    {
+        msg = NULL;
+    }
+
+    pthread_mutex_unlock(&mbox->lock);
+
+    return msg;
+}
+
+// -------------------------------------------------------------------------
+// VMboxCond()
+//
+// Mailbox wait condition, called by the scheduler with the node's
+// current time
+// -------------------------------------------------------------------------
+
+static int VMboxCond (void* arg, const unsigned node)
+{
+    vmbox_wait_t* wait = (vmbox_wait_t*)arg;
+
+    wait->msg = VMboxGet(wait->mbox, VGetSimTime(node));
+
+    return wait->msg != NULL;
+}
+
+// -------------------------------------------------------------------------
+// VBarrierCond()
+//
+// Barrier wait condition, met at the first of the node's clock edges
+// after the barrier's release
+// -------------------------------------------------------------------------
+
+static int VBarrierCond (void* arg, const unsigned node)
+{
+    vbarrier_wait_t* wait = (vbarrier_wait_t*)arg;
+    int              released;
+
+    pthread_mutex_lock(&wait->barrier->lock);
+    released = wait->barrier->gen != wait->gen && VGetSimTime(node) > wait->barrier->time;
+    pthread_mutex_unlock(&wait->barrier->lock);
+
+    return released;
+}
+
+// -------------------------------------------------------------------------
+// VMboxSend()
+//
+// Sends a message of len bytes to a mailbox, stamped with the node's
+// current simulation time. Doesn't block. Returns non-zero on error.
+// -------------------------------------------------------------------------
+
+int VMboxSend (const unsigned mbox, const void* data, const unsigned len, const unsigned node)
+{
+    vmbox_msg_t* msg;
+
+    if (mbox >= VP_MAX_MBOXES)
+    {
+        VPrint("***Error: out of range mailbox %d at node %d (VMboxSend)\n", mbox, node);
+        return 1;
+    }
+
+    if ((msg = (vmbox_msg_t*)malloc(sizeof(vmbox_msg_t) + len)) == NULL)
+    {
+        VPrint("***Error: failed to allocate message at node %d (VMboxSend)\n", node);
+        return 1;
+    }
+
+    msg->next = NULL;
+    msg->time = VGetSimTime(node);
+    msg->len  = len;
+    memcpy(msg->data, data, len);
+
+    pthread_once(&vmbox_once, VMboxInit);
+
+    pthread_mutex_lock(&mboxes[mbox].lock);
+
+    if (mboxes[mbox].tail != NULL)
+    {
+        mboxes[mbox].tail->next = msg;
+    }
+    else
+    {
+        mboxes[mbox].head = msg;
+    }
+
+    mboxes[mbox].tail = msg;
+
+    VMboxWake(&mboxes[mbox].waiters, node);
+
+    pthread_mutex_unlock(&mboxes[mbox].lock);
+
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// VMboxRecv()
+//
+// Receives the next message from a mailbox, sent before the node's
+// current simulation time, waiting for one if none has been. Up to
+// maxlen bytes are copied to data. Returns the message length, or
+// -1 on error.
+// -------------------------------------------------------------------------
+
+int VMboxRecv (const unsigned mbox, void* data, const unsigned maxlen, const unsigned node)
+{
+    vmbox_wait_t wait;
+    unsigned     len;
+
+    if (mbox >= VP_MAX_MBOXES)
+    {
+        VPrint("***Error: out of range mailbox %d at node %d (VMboxRecv)\n", mbox, node);
+        return -1;
+    }
+
+    pthread_once(&vmbox_once, VMboxInit);
+
+    wait.mbox = &mboxes[mbox];
+
+    if ((wait.msg = VMboxGet(wait.mbox, VGetSimTime(node))) == NULL)
+    {
+        pthread_mutex_lock(&wait.mbox->lock);
+        VMboxList(&wait.mbox->waiters, &wait.waiter, node);
+        pthread_mutex_unlock(&wait.mbox->lock);
+
+        VWaitCond(VMboxCond, &wait, node);
+
+        pthread_mutex_lock(&wait.mbox->lock);
+        VMboxUnlist(&wait.mbox->waiters, &wait.waiter);
+        pthread_mutex_unlock(&wait.mbox->lock);
+    }
+
+    len = wait.msg->len;
+    memcpy(data, wait.msg->data, (len < maxlen) ? len : maxlen);
+
+    free(wait.msg);
+
+    return (int)len;
+}
+
+// -------------------------------------------------------------------------
+// VBarrier()
+//
+// Waits at a barrier until count nodes have arrived at it. All of them
+// leave at their first clock edge after the simulation time the last
+// arrived. Returns non-zero on error.
+// -------------------------------------------------------------------------
+
+int VBarrier (const unsigned barrier, const unsigned count, const unsigned node)
+{
+    vbarrier_wait_t wait;
+
+    if (barrier >= VP_MAX_BARRIERS)
+    {
+        VPrint("***Error: out of range barrier %d at node %d (VBarrier)\n", barrier, node);
+        return 1;
+    }
+
+    pthread_once(&vmbox_once, VMboxInit);
+
+    wait.barrier       = &barriers[barrier];
+    wait.waiter.listed = 0;
+
+    pthread_mutex_lock(&wait.barrier->lock);
+
+    wait.gen = wait.barrier->gen;
+
+    if (++wait.barrier->arrived >= count)
+    {
+        wait.barrier->arrived = 0;
+        wait.barrier->time    = VGetSimTime(node);
+        wait.barrier->gen++;
+
+        VMboxWake(&wait.barrier->waiters, node);
+    }
+    else
+    {
+        VMboxList(&wait.barrier->waiters, &wait.waiter, node);
+    }
+
+    pthread_mutex_unlock(&wait.barrier->lock);
+
+    VWaitCond(VBarrierCond, &wait, node);
+
+    pthread_mutex_lock(&wait.barrier->lock);
+    VMboxUnlist(&wait.barrier->waiters, &wait.waiter);
+    pthread_mutex_unlock(&wait.barrier->lock);
+
+    return 0;
+}
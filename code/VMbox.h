@@ -0,0 +1,48 @@
+//=====================================================================
+//
+// VMbox.h                                            Date: 2024/07/22
+//
+// Copyright (c) 2024 Simon Southwell.
+//
+// This file is part of VProc.
+//
+// VProc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VProc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VProc. If not, see <http://www.gnu.org/licenses/>.
+//
+//=====================================================================
+//
+// Mailboxes and barriers between nodes' user code, with blocking in
+// simulation time. A message is received, and a barrier released, at
+// the first clock edge of the waiting node after the simulation time
+// it was sent, or the last node arrived.
+//
+//=====================================================================
+
+#ifndef _VMBOX_H_
+#define _VMBOX_H_
+
+#include "VUser.h"
+
+#ifndef VP_MAX_MBOXES
+#define VP_MAX_MBOXES           16
+#endif
+
+#ifndef VP_MAX_BARRIERS
+#define VP_MAX_BARRIERS         16
+#endif
+
+extern int VMboxSend (const unsigned mbox,    const void     *data,  const unsigned len,    const unsigned node);
+extern int VMboxRecv (const unsigned mbox,    void           *data,  const unsigned maxlen, const unsigned node);
+extern int VBarrier  (const unsigned barrier, const unsigned  count, const unsigned node);
+
+#endif
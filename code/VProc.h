@@ -41,6 +41,17 @@
 #define VP_MAX_NODES            64
 #endif
 
+#ifndef VP_MAX_GROUPS
+#define VP_MAX_GROUPS           16
+#endif
+
+// Node state is allocated on cache line boundaries, and padded to a
+// whole number of lines, so that nodes called concurrently from
+// different simulator threads do not share lines
+#ifndef VP_CACHE_LINE
+#define VP_CACHE_LINE           64
+#endif
+
 // Definitions for accesses
 #define V_IDLE                  0
 #define V_WRITE                 1
@@ -49,6 +60,7 @@
 #define BURSTLENLOBIT           2
 #define BEFIRSTLOBIT            14
 #define BELASTLOBIT             18
+#define IRQBRKBIT               22
 
 // Error types
 #define VP_USER_ERR             1
@@ -62,7 +74,30 @@
 #define VPADDR_ARG              5
 #define VPRW_ARG                6
 #define VPTICKS_ARG             7
-#define VPRESTORE_ARG           8
+
+// Indexes for VSched time arguments, following the outputs
+#define VPCYCLE_ARG             8
+#define VPTIMELO_ARG            9
+#define VPTIMEHI_ARG            10
+
+// Indexes for VSchedPost time arguments
+#define VPPOST_CYCLE_ARG        4
+#define VPPOST_TIMELO_ARG       5
+#define VPPOST_TIMEHI_ARG       6
+
+// Simulation time is passed as two 31 bit halves
+#define VPTIMEHI_SHIFT          31
+
+// Indexes for VSchedCollect arguments
+#define VPCOLLECT_DATAOUT_ARG   2
+#define VPCOLLECT_ADDR_ARG      3
+#define VPCOLLECT_RW_ARG        4
+#define VPCOLLECT_TICKS_ARG     5
+
+// Node scheduler exchange states, between VSchedPost and VSchedCollect
+#define VP_SCHED_IDLE           0   // No command due
+#define VP_SCHED_DUE            1   // Command due from cycle model
+#define VP_SCHED_POSTED         2   // Command due from user thread, released with inputs
 
 // A default string buffer size
 #define DEFAULT_STR_BUF_SIZE    32
@@ -83,7 +118,8 @@ typedef struct {
     uint32_t burstlen : 12;
     uint32_t fbe      : 4;
     uint32_t lbe      : 4;
-    uint32_t rsvd     : 10;
+    uint32_t irqbrk   : 1;
+    uint32_t rsvd     : 9;
 } rw_t;
 
 
@@ -100,6 +136,8 @@ typedef struct {
 typedef struct {
     unsigned int        data_in;
     unsigned int        interrupt;
+    uint64_t            cycle;      // Clock cycle count of the node
+    uint64_t            time;       // Simulation time (VProc time units)
 } rcv_buf_t, *prcv_buf_t;
 
 // Shared object handle typedef
@@ -111,12 +149,41 @@ typedef int  (*pVUserIrqCB_t)    (int);
 typedef int  (*pPyIrqCB_t)       (int, int);
 typedef int  (*pVUserCB_t)       (int);
 
+// Cycle model, called on the simulation thread with the result of the
+// previous command (read data or remaining ticks, and interrupt) to set
+// the next command, in place of a user thread making blocking calls
+typedef struct VUserCycleModel_s {
+    void (*next_command) (struct VUserCycleModel_s* model, const rcv_buf_t* prev, send_buf_t* cmd);
+} VUserCycleModel_t, *pVUserCycleModel_t;
+
+// Condition a node's user thread is waiting on (e.g. a mailbox message),
+// tested on the simulation thread each time the node is scheduled. It
+// returns non-zero once met, when the user thread is woken. Where the
+// HDL can be woken from C, the node is parked on a long interruptible
+// tick between tests, until another node's user code wakes it.
+typedef int (*pVUserWaitCond_t) (void* arg, const unsigned node);
+
 typedef struct {
     uint32_t eventPtr;
     uint32_t eventPopPtr;
     uint32_t eventQueue [MAX_QUEUED_VEC_IRQ];
 } vecIrqState_t;
 
+// Node group state, for nodes driven together from one user thread
+// by VGroupIssue(). The last node to complete an issue's command wakes
+// the thread, and advances the generation, so that every node of the
+// group waits for the next issue at its next VSchedCollect() call.
+typedef struct {
+    sem_t               join;       // Posted as each node joins the group
+    sem_t               done;       // Posted when all of an issue's commands are complete
+    int                 pending;    // Number of the issue's commands still to complete
+    unsigned            members;    // Number of nodes joined to the group
+    unsigned            size;       // Number of nodes in every issue, set by the first
+    uint32_t            gen;        // Count of completed issues
+    uint64_t            cycle;      // Clock cycle count when the last issue completed
+    uint64_t            time;       // Simulation time when the last issue completed
+} VGroupState_t, *pVGroupState_t;
+
 // Scheduler node state structure
 typedef struct {
     sem_t               snd;
@@ -128,6 +195,25 @@ typedef struct {
     pPyIrqCB_t          PyIrqCB;
     vecIrqState_t       irqState;
     pVUserCB_t          VUserCB;
+    pVUserCycleModel_t  VUserCycleModel;
+    struct vshm_s*      shm;        // Shared memory transport, if user code out-of-process
+    uint32_t            shm_seq;    // Last sequence number seen on shm transport
+    int                 shm_dead;   // Other side of shm transport has exited
+    int                 sched;      // Scheduler exchange state (VP_SCHED_xxx)
+    int                 two_phase;  // Scheduled by VSchedPost() and VSchedCollect()
+    pVGroupState_t      group;      // Node group, if driven by VGroupIssue()
+    uint32_t            group_gen;  // Group generation when the node's last command was issued
+    int                 group_busy; // A command of the group's current issue is in progress
+    send_buf_t          group_cmd;  // Next command, from VGroupIssue()
+    rcv_buf_t           group_rcv;  // Result of the node's last group command
+    pVUserWaitCond_t    wait_cond;  // Condition the user thread is waiting on, if any
+    void*               wait_arg;   // Argument for the wait condition
+    int                 wait_parked; // Node parked on an interruptible tick while waiting
+    int                 wait_woken; // Node woken since the wait condition was last tested
+    void*               wake_hdl;   // Handle to wake the HDL from a parked wait, or NULL if unsupported
+    unsigned            wake_count; // Number of nodes to wake when the node's next command is collected
+    unsigned            wake_nodes[VP_MAX_NODES]; // Nodes to wake
+    uint64_t            trace_ts;   // Host time the user thread last resumed, when tracing
 } SchedState_t, *pSchedState_t;
 
 // Reference to node state array
@@ -26,6 +26,7 @@
 extern "C"
 {
 #include "VUser.h"
+#include "VMbox.h"
 }
 
 class VProc
@@ -59,7 +60,18 @@ public:
 
     int  burstWrite      (const unsigned   addr,           void    *data, const unsigned wordlen)    {return VBurstWrite     (addr,      data, wordlen, node);};
     int  burstRead       (const unsigned   addr,           void    *data, const unsigned wordlen)    {return VBurstRead      (addr,      data, wordlen, node);};
+    int  streamSend      (const void      *buf,     const unsigned  len,    const unsigned tuser=0) {return VStreamSend     (buf,       len,   tuser,  node);};
+    int  streamRecv      (void            *buf,     const unsigned  maxlen,       unsigned *tuser=NULL) {return VStreamRecv  (buf,       maxlen, tuser, node);};
     int  tick            (const unsigned   ticks)                                                    {return VTick           (ticks,                    node);};
+    int  tickIrq         (const unsigned   ticks)                                                    {return VTickIrq        (ticks,                    node);};
+    int  waitUntil       (const uint64_t   cycle)                                                    {return VWaitUntil      (cycle,                    node);};
+    uint64_t getCycle    (void)                                                                      {return VGetCycle       (                          node);};
+    uint64_t getSimTime  (void)                                                                      {return VGetSimTime     (                          node);};
+    int  groupJoin       (const unsigned   group)                                                    {return VGroupJoin      (group,                    node);};
+    int  groupIssue      (const unsigned   group,        VGroupCmd_t cmds[], const unsigned num)     {return VGroupIssue     (group,     cmds, num);};
+    int  mboxSend        (const unsigned   mbox,     const void     *data, const unsigned len)       {return VMboxSend       (mbox,      data, len,     node);};
+    int  mboxRecv        (const unsigned   mbox,           void     *data, const unsigned maxlen)    {return VMboxRecv       (mbox,      data, maxlen,  node);};
+    int  barrier         (const unsigned   barrier,  const unsigned  count)                          {return VBarrier        (barrier,   count,         node);};
     void regIrq          (const pVUserIrqCB_t func)                                                  {       VRegIrq         (func,                     node);};
     void regInterrupt    (const int        level,  const pVUserInt_t func)                           {       VRegInterrupt   (level,     func,          node);};
     void regUser         (const pVUserCB_t func)                                                     {       VRegUser        (func,                     node);};
@@ -102,4 +114,72 @@ private:
         int      diffoff = loff - foff;
         return bytelen/4 + ((diffoff < 0) ? 1 : 0) + ((bytelen%4) ? 1 : 0);
     };
-};
\ No newline at end of file
+};
+
+// ---------------------------------------------------------------------
+// Base class for a cycle model: a user model that runs on the simulation
+// thread, without a thread of its own. A derived class implements
+// nextCommand(), which is called with the result of the previous
+// command (read data, or remaining ticks of an interruptible tick) and
+// sets the next using the command methods, without blocking. The model
+// is registered from VUserMain<node>, which then returns:
+//
+//   void VUserMain0() { static MyModel model(0); model.regModel(); }
+//
+// ---------------------------------------------------------------------
+
+class VProcCycleModel : public VUserCycleModel_t
+{
+public:
+         // Constructor
+         VProcCycleModel (const unsigned nodeIn) : node(nodeIn), cmd(NULL) {next_command = nextCommandCB;};
+
+    void regModel        (void)                                                                      {VRegCycleModel(this, node);};
+
+    // Called for the next command. Interrupt is non-zero for a level interrupt,
+    // when the current command is left set, to be reissued or replaced.
+    virtual void nextCommand (const unsigned data_in, const unsigned interrupt) = 0;
+
+protected:
+
+    // Command methods, setting the next command
+    void write           (const unsigned   addr,     const unsigned    data, const int      delta=0)    {writeBE(addr, data, 0xf, delta);};
+    void writeBE         (const unsigned   addr,     const unsigned    data, const unsigned be, const int delta=0)
+                                                                                                     {setCmd(addr, data, V_WRITE, be, 0xf, 0, delta ? DELTA_CYCLE : 0, NULL);};
+    void read            (const unsigned   addr,     const int         delta=0)                      {setCmd(addr, 0,    V_READ,  0xf, 0xf, 0, delta ? DELTA_CYCLE : 0, NULL);};
+    void burstWrite      (const unsigned   addr,           void       *data, const unsigned wordlen) {setCmd(addr, 0,    V_WRITE, 0xf, 0xf, wordlen, 0, data);};
+    void burstRead       (const unsigned   addr,           void       *data, const unsigned wordlen) {setCmd(addr, 0,    V_READ,  0xf, 0xf, wordlen, 0, data);};
+    void tick            (const unsigned   ticks)                                                    {setCmd(0,    0,    V_IDLE,  0,   0,   0, ticks, NULL);};
+    void tickIrq         (const unsigned   ticks)                                                    {setCmd(0,    0,    V_IDLE,  0,   0,   0, ticks, NULL); ((rw_t*)&cmd->rw)->irqbrk = 1;};
+
+    // VProc node number of this model
+    unsigned node;
+
+private:
+
+    send_buf_t* cmd;
+
+    void setCmd (const unsigned addr, const unsigned data, const unsigned access, const unsigned fbe, const unsigned lbe,
+                 const unsigned wordlen, const int ticks, void* data_p) {
+        rw_t* p_rw     = (rw_t*)&cmd->rw;
+
+        cmd->addr      = addr;
+        cmd->data_out  = data;
+        cmd->data_p    = data_p;
+        cmd->ticks     = ticks;
+
+        cmd->rw        = 0;
+        p_rw->write    = (access == V_WRITE);
+        p_rw->read     = (access == V_READ);
+        p_rw->burstlen = wordlen & 0xfff;
+        p_rw->fbe      = fbe & 0xf;
+        p_rw->lbe      = lbe & 0xf;
+    };
+
+    static void nextCommandCB (VUserCycleModel_s* model, const rcv_buf_t* prev, send_buf_t* cmd) {
+        VProcCycleModel* p_model = static_cast<VProcCycleModel*>(model);
+
+        p_model->cmd = cmd;
+        p_model->nextCommand(prev->data_in, prev->interrupt);
+    };
+};
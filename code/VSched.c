@@ -42,8 +42,29 @@
 #include "VProc.h"
 #include "VUser.h"
 #include "VSched_pli.h"
-
-#define ARGS_ARRAY_SIZE     10
+#include "VShm.h"
+#include "VTrace.h"
+
+#define ARGS_ARRAY_SIZE     12
+
+// A node parked while waiting (see VWaitCond()) is woken by setting the
+// VProc module's Wake register. This can be done through VPI, or with a
+// DPI-C export on event driven simulators. Verilator may evaluate nodes
+// on separate threads, so there, and with other interfaces, a waiting
+// node is tested at each of its clock edges instead.
+#if !defined(VPROC_VHDL) && !defined(VPROC_SV) && defined(VPROC_PLI_VPI)
+# define VPROC_WAKE_VPI
+#elif defined(VPROC_SV) && !defined(VPROC_VHDL) && !defined(VERILATOR)
+# define VPROC_WAKE_DPI
+
+// From svdpi.h, which not every simulator puts on the include path
+typedef void* svScope;
+extern svScope svGetScope (void);
+extern svScope svSetScope (const svScope scope);
+
+// Exported by the VProc module
+extern void VWake (void);
+#endif
 
 // Pointers to state for each node (up to VP_MAX_NODES)
 pSchedState_t ns[VP_MAX_NODES];
@@ -63,6 +84,8 @@ static VPROC_RTN_TYPE reg_foreign_procs() {
     vhpiForeignDataT foreignDataArray[] = {
         {vhpiProcF, (char*)"VProc", (char*)"VInit",           NULL, VInit},
         {vhpiProcF, (char*)"VProc", (char*)"VSched",          NULL, VSched},
+        {vhpiProcF, (char*)"VProc", (char*)"VSchedPost",      NULL, VSchedPost},
+        {vhpiProcF, (char*)"VProc", (char*)"VSchedCollect",   NULL, VSchedCollect},
         {vhpiProcF, (char*)"VProc", (char*)"VProcUser",       NULL, VProcUser},
         {vhpiProcF, (char*)"VProc", (char*)"VIrq",            NULL, VIrq},
         {vhpiProcF, (char*)"VProc", (char*)"VAccess",         NULL, VAccess},
@@ -158,6 +181,8 @@ static void register_vpi_tasks()
     s_vpi_systf_data data[] =
       {{vpiSysTask, 0, "$vinit",     VInit,     0, 0, 0},
        {vpiSysTask, 0, "$vsched",    VSched,    0, 0, 0},
+       {vpiSysTask, 0, "$vschedpost",    VSchedPost,    0, 0, 0},
+       {vpiSysTask, 0, "$vschedcollect", VSchedCollect, 0, 0, 0},
        {vpiSysTask, 0, "$vaccess",   VAccess,   0, 0, 0},
        {vpiSysTask, 0, "$vprocuser", VProcUser, 0, 0, 0},
        {vpiSysTask, 0, "$virq",      VIrq,      0, 0, 0},
@@ -236,6 +261,295 @@ static int updateArgs (vpiHandle taskHdl, int value[])
 
 #endif
 
+// =========================================================================
+// Waking parked nodes
+// =========================================================================
+
+// -------------------------------------------------------------------------
+// VSchedGetWake()
+//
+// Returns a handle to wake the VProc module instance calling VInit from
+// a parked wait, or NULL if this isn't supported
+// -------------------------------------------------------------------------
+
+static void* VSchedGetWake (void)
+{
+#if defined(VPROC_WAKE_VPI)
+    vpiHandle scope = vpi_handle(vpiScope, vpi_handle(vpiSysTfCall, NULL));
+
+    return (scope != NULL) ? (void*)vpi_handle_by_name("Wake", scope) : NULL;
+#elif defined(VPROC_WAKE_DPI)
+    return (void*)svGetScope();
+#else
+    return NULL;
+#endif
+}
+
+// -------------------------------------------------------------------------
+// VSchedWakeHdl()
+//
+// Sets the Wake register of a node's VProc module instance, ending its
+// parked tick
+// -------------------------------------------------------------------------
+
+static void VSchedWakeHdl (const int node)
+{
+#if defined(VPROC_WAKE_VPI)
+    struct t_vpi_value value;
+
+    value.format        = vpiIntVal;
+    value.value.integer = 1;
+
+    vpi_put_value((vpiHandle)ns[node]->wake_hdl, &value, NULL, vpiNoDelay);
+#elif defined(VPROC_WAKE_DPI)
+    svScope scope = svSetScope((svScope)ns[node]->wake_hdl);
+
+    VWake();
+
+    svSetScope(scope);
+#endif
+}
+
+// -------------------------------------------------------------------------
+// VSchedWake()
+//
+// Wakes the nodes that the given node's user code has asked to be woken
+// since its last command, now that its next command has been collected.
+// A parked node has its tick ended by the HDL, at its next clock edge
+// (or this one, if not yet reached), and a node that isn't parked yet
+// will idle a cycle instead of parking.
+// -------------------------------------------------------------------------
+
+static void VSchedWake (const int node)
+{
+    unsigned idx;
+    int      waiter;
+
+    for (idx = 0; idx < ns[node]->wake_count; idx++)
+    {
+        waiter = ns[node]->wake_nodes[idx];
+
+        __atomic_store_n(&ns[waiter]->wait_woken, 1, __ATOMIC_RELEASE);
+
+        if (ns[waiter]->wait_parked)
+        {
+            debug_io_printf("VSchedWake(): node %d waking node %d\n", node, waiter);
+
+            ns[waiter]->wait_parked = 0;
+
+            VSchedWakeHdl(waiter);
+        }
+    }
+
+    ns[node]->wake_count = 0;
+}
+
+// =========================================================================
+// Scheduler exchange with user thread
+// =========================================================================
+
+// -------------------------------------------------------------------------
+// VSchedSend()
+//
+// Samples the scheduler inputs into the node's state and releases its
+// user thread with them. The HDL's 32 bit cycle count is extended to 64
+// bits across wraps, and the time reassembled from its halves. Returns
+// 0 if no command is due, as the call was for an interrupt which is
+// discarded here.
+// -------------------------------------------------------------------------
+
+static int VSchedSend (const int node, const int Interrupt, const int VPDataIn,
+                       const int VPCycle, const int VPTimeLo, const int VPTimeHi)
+{
+    // Sample inputs and update node state
+    ns[node]->rcv_buf.data_in   = VPDataIn;
+    ns[node]->rcv_buf.interrupt = Interrupt;
+    ns[node]->rcv_buf.cycle    += (uint32_t)((uint32_t)VPCycle - (uint32_t)ns[node]->rcv_buf.cycle);
+    ns[node]->rcv_buf.time      = ((uint64_t)(uint32_t)VPTimeHi << VPTIMEHI_SHIFT) | (uint32_t)VPTimeLo;
+
+    // If call is for interrupt and vector IRQ enabled (with C or Python callback registered)
+    // don't process here with the level interrupt code.
+    if (Interrupt && (ns[node]->VUserIrqCB != NULL || ns[node]->PyIrqCB != NULL || (ns[node]->shm != NULL && ns[node]->shm->irq_cb)))
+    {
+        ns[node]->sched = VP_SCHED_IDLE;
+        return 0;
+    }
+
+    // A user thread waiting on a condition is only woken once it is met.
+    // Until then the node is parked on an interruptible tick, where it can
+    // be woken, else idles a cycle at a time. Having been woken, it idles
+    // a cycle before parking again, as the condition may not be met until
+    // the next clock edge.
+    if (!Interrupt && ns[node]->wait_cond != NULL)
+    {
+        if (!ns[node]->wait_cond(ns[node]->wait_arg, node))
+        {
+            rw_t* p_rw = (rw_t*)&ns[node]->send_buf.rw;
+
+            ns[node]->send_buf.addr     = 0;
+            ns[node]->send_buf.data_out = 0;
+            ns[node]->send_buf.rw       = V_IDLE;
+            ns[node]->send_buf.ticks    = 0;
+
+            if (ns[node]->wake_hdl != NULL && !__atomic_exchange_n(&ns[node]->wait_woken, 0, __ATOMIC_ACQ_REL))
+            {
+                debug_io_printf("VSchedSend(): node %d parked\n", node);
+
+                ns[node]->send_buf.ticks = GO_TO_SLEEP;
+                p_rw->irqbrk             = 1;
+                ns[node]->wait_parked    = 1;
+            }
+            else
+            {
+                __atomic_store_n(&ns[node]->wait_woken, 0, __ATOMIC_RELEASE);
+            }
+
+            ns[node]->sched = VP_SCHED_DUE;
+            return 1;
+        }
+
+        ns[node]->wait_cond   = NULL;
+        ns[node]->wait_parked = 0;
+        __atomic_store_n(&ns[node]->wait_woken, 0, __ATOMIC_RELEASE);
+    }
+
+    // A node in a group completes its command towards the group's issue,
+    // with the last of them to complete waking the group's thread. Level
+    // interrupts are not delivered to grouped nodes.
+    if (ns[node]->group != NULL)
+    {
+        if (Interrupt)
+        {
+            ns[node]->sched = VP_SCHED_IDLE;
+            return 0;
+        }
+
+        if (ns[node]->group_busy)
+        {
+            ns[node]->group_busy = 0;
+            ns[node]->group_rcv  = ns[node]->rcv_buf;
+
+            if (__atomic_sub_fetch(&ns[node]->group->pending, 1, __ATOMIC_ACQ_REL) == 0)
+            {
+                debug_io_printf("VSchedSend(): node %d completing group issue\n", node);
+
+                ns[node]->group->cycle = ns[node]->rcv_buf.cycle;
+                ns[node]->group->time  = ns[node]->rcv_buf.time;
+
+                __atomic_add_fetch(&ns[node]->group->gen, 1, __ATOMIC_RELEASE);
+                sem_post(&ns[node]->group->done);
+            }
+        }
+
+        ns[node]->sched = VP_SCHED_POSTED;
+        return 1;
+    }
+
+    // A node with a cycle model has no user thread to exchange with
+    if (ns[node]->VUserCycleModel != NULL)
+    {
+        ns[node]->sched = VP_SCHED_DUE;
+        return 1;
+    }
+
+    // Send message to VUser with VPDataIn value
+    debug_io_printf("VSchedSend(): setting rcv[%d] semaphore\n", node);
+    ns[node]->sched = VP_SCHED_POSTED;
+
+    if (ns[node]->shm != NULL)
+    {
+        VShmServerSend(node);
+    }
+    else
+    {
+        sem_post(&(ns[node]->rcv));
+    }
+
+    return 1;
+}
+
+// -------------------------------------------------------------------------
+// VSchedRecv()
+//
+// Gets the command due from VSchedSend() into the node's send_buf,
+// waiting for the user thread to send it. Returns 0 if none due.
+// -------------------------------------------------------------------------
+
+static int VSchedRecv (const int node)
+{
+    int sched       = ns[node]->sched;
+    ns[node]->sched = VP_SCHED_IDLE;
+
+    if (sched == VP_SCHED_IDLE)
+    {
+        return 0;
+    }
+
+    // Wait for a message from VUser process with output data
+    if (sched == VP_SCHED_POSTED)
+    {
+        uint64_t start = vtrace_on ? VTraceNow() : 0;
+
+        // The node's own thread may be joining a group, concurrently
+        pVGroupState_t group = __atomic_load_n(&ns[node]->group, __ATOMIC_ACQUIRE);
+
+        // A grouped node that has completed its command idles for a cycle,
+        // until the group's issue is complete, when it waits for the next
+        if (group != NULL && ns[node]->group_gen == __atomic_load_n(&group->gen, __ATOMIC_ACQUIRE))
+        {
+            ns[node]->send_buf.addr     = 0;
+            ns[node]->send_buf.data_out = 0;
+            ns[node]->send_buf.rw       = V_IDLE;
+            ns[node]->send_buf.ticks    = 0;
+
+            return 1;
+        }
+
+        debug_io_printf("VSchedRecv(): waiting for snd[%d] semaphore\n", node);
+        if (ns[node]->shm != NULL)
+        {
+            VShmServerRecv(node);
+        }
+        else
+        {
+            sem_wait(&(ns[node]->snd));
+        }
+
+        if (vtrace_on)
+        {
+            VTraceSpan(VTRACE_PID_SIM, node, "wait user", "sched", start, NULL, 0, ns[node]->rcv_buf.cycle);
+        }
+    }
+
+    // A grouped node (which the user thread may have just joined to the
+    // group) takes its command from the group's issue
+    if (ns[node]->group != NULL)
+    {
+        ns[node]->group_gen  = __atomic_load_n(&ns[node]->group->gen, __ATOMIC_ACQUIRE);
+        ns[node]->group_busy = 1;
+        ns[node]->send_buf   = ns[node]->group_cmd;
+
+        return 1;
+    }
+
+    // A cycle model (which the user thread may have just registered before
+    // finishing) is called for the next command directly. On an interrupt,
+    // the current command is left in send_buf, to be reissued or replaced.
+    if (ns[node]->VUserCycleModel != NULL)
+    {
+        ns[node]->VUserCycleModel->next_command(ns[node]->VUserCycleModel, &ns[node]->rcv_buf, &ns[node]->send_buf);
+    }
+
+    // Wake any nodes waiting on mailboxes or barriers that the user code
+    // has since sent to or released
+    if (ns[node]->wake_count)
+    {
+        VSchedWake(node);
+    }
+
+    return 1;
+}
+
 // =========================================================================
 // Foreign procedure C functions
 // =========================================================================
@@ -294,6 +608,9 @@ VPROC_RTN_TYPE VInit (VINIT_PARAMS)
         exit(VP_USER_ERR);
     }
 
+    // Enable tracing, if requested, on the first node
+    VTraceInit();
+
     // Print message displaying node number, programming interface, and VProc version
     VPrint("VInit(%d): initialising %s interface\n  %s\n", node, PLI_STRING, VERSION_STRING);
 
@@ -302,7 +619,14 @@ VPROC_RTN_TYPE VInit (VINIT_PARAMS)
     //----------------------------------------------
 
     // Allocate some space for the node state and update pointer
-    ns[node] = (pSchedState_t) calloc(1, sizeof(SchedState_t));
+    if ((ns[node] = VAllocState()) == NULL)
+    {
+        VPrint("***Error: VInit() failed to allocate state for node %d\n", node);
+        exit(VP_USER_ERR);
+    }
+
+    // Get the handle to wake the node from a parked wait, if supported
+    ns[node]->wake_hdl = VSchedGetWake();
 
     // Set up semaphores for this node
     debug_io_printf("VInit(): initialising semaphores for node %d\n", node);
@@ -321,10 +645,14 @@ VPROC_RTN_TYPE VInit (VINIT_PARAMS)
     debug_io_printf("VInit(): initialising semaphores for node %d---Done\n", node);
 
     //----------------------------------------------
-    // Issue a new thread to run the user code
+    // Issue a new thread to run the user code, unless
+    // it is to run in a separate process
     //----------------------------------------------
 
-    VUser(node);
+    if (VShmServerInit(node))
+    {
+        VUser(node);
+    }
 
 #if !defined(VPROC_VHDL) && !defined(VPROC_SV)
     return 0;
@@ -350,11 +678,15 @@ VPROC_RTN_TYPE VSched (VSCHED_PARAMS)
 #if !defined(VPROC_VHDL) && !defined(VPROC_SV)
     int node;
     int Interrupt, VPDataIn;
+    int VPCycle, VPTimeLo, VPTimeHi;
 # ifndef VPROC_PLI_VPI
     // Get the input argument values of $vsched
     node         = tf_getp (VPNODENUM_ARG);
     Interrupt    = tf_getp (VPINTERRUPT_ARG);
     VPDataIn     = tf_getp (VPDATAIN_ARG);
+    VPCycle      = tf_getp (VPCYCLE_ARG);
+    VPTimeLo     = tf_getp (VPTIMELO_ARG);
+    VPTimeHi     = tf_getp (VPTIMEHI_ARG);
 # else
     vpiHandle    taskHdl;
 
@@ -367,6 +699,7 @@ VPROC_RTN_TYPE VSched (VSCHED_PARAMS)
 # ifdef VPROC_VHDL_VHPI
     int node;
     int Interrupt, VPDataIn;
+    int VPCycle, VPTimeLo, VPTimeHi;
 
     getVhpiParams(cb, &args[1], VSCHED_NUM_ARGS);
 # endif
@@ -380,20 +713,18 @@ VPROC_RTN_TYPE VSched (VSCHED_PARAMS)
     node         = args[VPNODENUM_ARG];
     Interrupt    = args[VPINTERRUPT_ARG];
     VPDataIn     = args[VPDATAIN_ARG];
+    VPCycle      = args[VPCYCLE_ARG];
+    VPTimeLo     = args[VPTIMELO_ARG];
+    VPTimeHi     = args[VPTIMEHI_ARG];
 #endif
 
-    // Sample inputs and update node state
-    ns[node]->rcv_buf.data_in   = VPDataIn;
-    ns[node]->rcv_buf.interrupt = Interrupt;
-
     //----------------------------------------------
-    // Discard any level interrupt when vectored
-    // IRQ enabled
+    // Send inputs to user thread and get updates
+    // from it
     //----------------------------------------------
 
-    // If call to VSched is for interrupt and vector IRQ enabled (with C or Python callback registered)
-    // don't process here with the level interrupt code and just return.
-    if (Interrupt && (ns[node]->VUserIrqCB != NULL || ns[node]->PyIrqCB != NULL))
+    // If the interrupt was discarded, with vector IRQ enabled, just return.
+    if (!VSchedSend(node, Interrupt, VPDataIn, VPCycle, VPTimeLo, VPTimeHi))
     {
 #if !defined(VPROC_VHDL) && !defined(VPROC_SV)
         return 0;
@@ -406,21 +737,7 @@ VPROC_RTN_TYPE VSched (VSCHED_PARAMS)
 #endif
     }
 
-    //----------------------------------------------
-    // Send inputs to user thread
-    //----------------------------------------------
-
-    // Send message to VUser with VPDataIn value
-    debug_io_printf("VSched(): setting rcv[%d] semaphore\n", node);
-    sem_post(&(ns[node]->rcv));
-
-    //----------------------------------------------
-    // Get get updates from user thread
-    //----------------------------------------------
-
-    // Wait for a message from VUser process with output data
-    debug_io_printf("VSched(): waiting for snd[%d] semaphore\n", node);
-    sem_wait(&(ns[node]->snd));
+    VSchedRecv(node);
 
     // Update outputs of $vsched task
     if (ns[node]->send_buf.ticks >= DELTA_CYCLE)
@@ -456,7 +773,7 @@ VPROC_RTN_TYPE VSched (VSCHED_PARAMS)
     *VPTicks            = VPTicks_int;
 # else
     // Update VHPI procedure outputs from argument array
-    setVhpiParams(cb, &args[1], VPDATAOUT_ARG-1, VSCHED_NUM_ARGS);
+    setVhpiParams(cb, &args[1], VPDATAOUT_ARG-1, VPTICKS_ARG);
 # endif
 #else
 # ifndef VPROC_PLI_VPI
@@ -474,6 +791,156 @@ VPROC_RTN_TYPE VSched (VSCHED_PARAMS)
 
 }
 
+// -------------------------------------------------------------------------
+// VSchedPost()
+//
+// First phase of a two-phase alternative to VSched(), called whenever
+// $vschedpost task invoked. Releases the node's user thread with the
+// inputs, without waiting for its next command, so that the user code
+// of all the nodes posted in a time step runs concurrently.
+// -------------------------------------------------------------------------
+
+VPROC_RTN_TYPE VSchedPost (VSCHEDPOST_PARAMS)
+{
+    int args[ARGS_ARRAY_SIZE];
+
+    //----------------------------------------------
+    // Get input arguments
+    //----------------------------------------------
+
+#if !defined(VPROC_VHDL) && !defined(VPROC_SV)
+    int node;
+    int Interrupt, VPDataIn;
+    int VPCycle, VPTimeLo, VPTimeHi;
+# ifndef VPROC_PLI_VPI
+    // Get the input argument values of $vschedpost
+    node         = tf_getp (VPNODENUM_ARG);
+    Interrupt    = tf_getp (VPINTERRUPT_ARG);
+    VPDataIn     = tf_getp (VPDATAIN_ARG);
+    VPCycle      = tf_getp (VPPOST_CYCLE_ARG);
+    VPTimeLo     = tf_getp (VPPOST_TIMELO_ARG);
+    VPTimeHi     = tf_getp (VPPOST_TIMEHI_ARG);
+# else
+    getArgs(vpi_handle(vpiSysTfCall, NULL), &args[1]);
+# endif
+#else
+# ifdef VPROC_VHDL_VHPI
+    int node;
+    int Interrupt, VPDataIn;
+    int VPCycle, VPTimeLo, VPTimeHi;
+
+    getVhpiParams(cb, &args[1], VSCHEDPOST_NUM_ARGS);
+# endif
+#endif
+
+    // When VHDL with VHPI, or Verilog with VPI, extract input values from argument array
+#if ( defined(VPROC_VHDL) &&  defined(VPROC_VHDL_VHPI)) || \
+    (!defined(VPROC_VHDL) && !defined(VPROC_SV) && defined(VPROC_PLI_VPI))
+
+    node         = args[VPNODENUM_ARG];
+    Interrupt    = args[VPINTERRUPT_ARG];
+    VPDataIn     = args[VPDATAIN_ARG];
+    VPCycle      = args[VPPOST_CYCLE_ARG];
+    VPTimeLo     = args[VPPOST_TIMELO_ARG];
+    VPTimeHi     = args[VPPOST_TIMEHI_ARG];
+#endif
+
+    ns[node]->two_phase = 1;
+
+    VSchedSend(node, Interrupt, VPDataIn, VPCycle, VPTimeLo, VPTimeHi);
+
+#if !defined(VPROC_VHDL) && !defined(VPROC_SV)
+    return 0;
+#endif
+}
+
+// -------------------------------------------------------------------------
+// VSchedCollect()
+//
+// Second phase of a two-phase alternative to VSched(), called whenever
+// $vschedcollect task invoked. Waits for the node's next command from
+// its user thread, released by VSchedPost(). If none was due, the
+// returned ticks are a delta cycle, with no access.
+// -------------------------------------------------------------------------
+
+VPROC_RTN_TYPE VSchedCollect (VSCHEDCOLLECT_PARAMS)
+{
+    int VPDataOut_int = 0, VPAddr_int = 0, VPRw_int = 0, VPTicks_int = DELTA_CYCLE;
+    int args[ARGS_ARRAY_SIZE];
+
+    //----------------------------------------------
+    // Get input arguments
+    //----------------------------------------------
+
+#if !defined(VPROC_VHDL) && !defined(VPROC_SV)
+    int node;
+# ifndef VPROC_PLI_VPI
+    node         = tf_getp (VPNODENUM_ARG);
+# else
+    vpiHandle    taskHdl;
+
+    // Obtain a handle to the argument list
+    taskHdl      = vpi_handle(vpiSysTfCall, NULL);
+
+    getArgs(taskHdl, &args[1]);
+    node         = args[VPNODENUM_ARG];
+# endif
+#else
+# ifdef VPROC_VHDL_VHPI
+    int node;
+
+    getVhpiParams(cb, &args[1], VSCHEDCOLLECT_NUM_ARGS);
+    node         = args[VPNODENUM_ARG];
+# endif
+#endif
+
+    //----------------------------------------------
+    // Get updates from user thread
+    //----------------------------------------------
+
+    if (VSchedRecv(node) && ns[node]->send_buf.ticks >= DELTA_CYCLE)
+    {
+        VPDataOut_int = ns[node]->send_buf.data_out;
+        VPAddr_int    = ns[node]->send_buf.addr;
+        VPRw_int      = ns[node]->send_buf.rw;
+        VPTicks_int   = ns[node]->send_buf.ticks;
+        debug_io_printf("VSchedCollect(): VPTicks=%08x\n", VPTicks_int);
+    }
+
+    //----------------------------------------------
+    // Update outputs in simulation
+    //----------------------------------------------
+
+#if (defined(VPROC_VHDL)  &&  defined(VPROC_VHDL_VHPI)) || \
+    (!defined(VPROC_VHDL) && !defined(VPROC_SV)  && defined(VPROC_PLI_VPI))
+    args[VPCOLLECT_DATAOUT_ARG] = VPDataOut_int;
+    args[VPCOLLECT_ADDR_ARG]    = VPAddr_int;
+    args[VPCOLLECT_RW_ARG]      = VPRw_int;
+    args[VPCOLLECT_TICKS_ARG]   = VPTicks_int;
+#endif
+
+#if defined(VPROC_VHDL) || defined(VPROC_SV)
+# ifndef VPROC_VHDL_VHPI
+    *VPDataOut          = VPDataOut_int;
+    *VPAddr             = VPAddr_int;
+    *VPRw               = VPRw_int;
+    *VPTicks            = VPTicks_int;
+# else
+    setVhpiParams(cb, &args[1], VPCOLLECT_DATAOUT_ARG-1, VSCHEDCOLLECT_NUM_ARGS);
+# endif
+#else
+# ifndef VPROC_PLI_VPI
+    tf_putp (VPCOLLECT_DATAOUT_ARG, VPDataOut_int);
+    tf_putp (VPCOLLECT_ADDR_ARG,    VPAddr_int);
+    tf_putp (VPCOLLECT_RW_ARG,      VPRw_int);
+    tf_putp (VPCOLLECT_TICKS_ARG,   VPTicks_int);
+# else
+    updateArgs(taskHdl, &args[1]);
+# endif
+    return 0;
+#endif
+}
+
 // -------------------------------------------------------------------------
 // VProcUser()
 //
@@ -522,8 +989,13 @@ VPROC_RTN_TYPE VProcUser(VPROCUSER_PARAMS)
 # endif
 #endif
 
-    // Call any registered user callback function
-    if (ns[node]->VUserCB != NULL)
+    // Call any registered user callback function, or queue it for an
+    // out-of-process user
+    if (ns[node]->shm != NULL)
+    {
+        VShmServerEvent(node, VSHM_EVT_USER, value);
+    }
+    else if (ns[node]->VUserCB != NULL)
     {
         (*(ns[node]->VUserCB))(value);
     }
@@ -575,8 +1047,18 @@ VPROC_RTN_TYPE VIrq(VIRQ_PARAMS)
 # endif
 #endif
 
-    // Call any registered callback function. VUserIrqCB and PyIrqCB are mutually exclusive.
-    if (ns[node]->VUserIrqCB != NULL)
+    if (vtrace_on)
+    {
+        VTraceInstant(VTRACE_PID_SIM, node, "irq", "irq", "vector", value, ns[node]->rcv_buf.cycle);
+    }
+
+    // Call any registered callback function (or queue it for an out-of-process
+    // user). VUserIrqCB and PyIrqCB are mutually exclusive.
+    if (ns[node]->shm != NULL)
+    {
+        VShmServerEvent(node, VSHM_EVT_IRQ, value);
+    }
+    else if (ns[node]->VUserIrqCB != NULL)
     {
         (*(ns[node]->VUserIrqCB))(value);
     }
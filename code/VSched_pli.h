@@ -99,13 +99,17 @@
 
 #define VINIT_PARAMS       const struct vhpiCbDataS* cb
 #define VSCHED_PARAMS      const struct vhpiCbDataS* cb
+#define VSCHEDPOST_PARAMS  const struct vhpiCbDataS* cb
+#define VSCHEDCOLLECT_PARAMS const struct vhpiCbDataS* cb
 #define VPROCUSER_PARAMS   const struct vhpiCbDataS* cb
 #define VIRQ_PARAMS        const struct vhpiCbDataS* cb
 #define VACCESS_PARAMS     const struct vhpiCbDataS* cb
 #define VHALT_PARAMS       int, int
 
 #define VINIT_NUM_ARGS     1
-#define VSCHED_NUM_ARGS    7
+#define VSCHED_NUM_ARGS    10
+#define VSCHEDPOST_NUM_ARGS 6
+#define VSCHEDCOLLECT_NUM_ARGS 5
 #define VPROCUSER_NUM_ARGS 2
 #define VIRQ_NUM_ARGS      2
 #define VACCESS_NUM_ARGS   4
@@ -125,7 +129,9 @@
 #   endif
 
 #define VINIT_PARAMS       int  node
-#define VSCHED_PARAMS      int  node, int Interrupt, int VPDataIn, int* VPDataOut, int* VPAddr, int* VPRw, int* VPTicks
+#define VSCHED_PARAMS      int  node, int Interrupt, int VPDataIn, int* VPDataOut, int* VPAddr, int* VPRw, int* VPTicks, int VPCycle, int VPTimeLo, int VPTimeHi
+#define VSCHEDPOST_PARAMS  int  node, int Interrupt, int VPDataIn, int VPCycle, int VPTimeLo, int VPTimeHi
+#define VSCHEDCOLLECT_PARAMS int node, int* VPDataOut, int* VPAddr, int* VPRw, int* VPTicks
 #define VPROCUSER_PARAMS   int  node, int value
 #define VIRQ_PARAMS        int  node, int value
 #define VACCESS_PARAMS     int  node, int idx, int VPDataIn, int* VPDataOut
@@ -147,14 +153,18 @@
 #define VPROC_TF_TBL \
     {usertask, 0, NULL, 0, VInit,     NULL,  "$vinit",     1}, \
     {usertask, 0, NULL, 0, VSched,    NULL,  "$vsched",    1}, \
+    {usertask, 0, NULL, 0, VSchedPost,    NULL,  "$vschedpost",    1}, \
+    {usertask, 0, NULL, 0, VSchedCollect, NULL,  "$vschedcollect", 1}, \
     {usertask, 0, NULL, 0, VAccess,   NULL,  "$vaccess",   1}, \
     {usertask, 0, NULL, 0, VProcUser, NULL,  "$vprocuser", 1}, \
     {usertask, 0, NULL, 0, VIrq,      NULL,  "$virq",      1}
 
-#define VPROC_TF_TBL_SIZE 5
+#define VPROC_TF_TBL_SIZE 7
 
 #define VINIT_PARAMS      void
 #define VSCHED_PARAMS     void
+#define VSCHEDPOST_PARAMS void
+#define VSCHEDCOLLECT_PARAMS void
 #define VPROCUSER_PARAMS  void
 #define VIRQ_PARAMS       void
 #define VACCESS_PARAMS    void
@@ -175,6 +185,8 @@
 
 #define VINIT_PARAMS      char* userdata
 #define VSCHED_PARAMS     char* userdata
+#define VSCHEDPOST_PARAMS char* userdata
+#define VSCHEDCOLLECT_PARAMS char* userdata
 #define VPROCUSER_PARAMS  char* userdata
 #define VIRQ_PARAMS       char* userdata
 #define VACCESS_PARAMS    char* userdata
@@ -187,6 +199,8 @@
 
 extern VPROC_RTN_TYPE VInit     (VINIT_PARAMS);
 extern VPROC_RTN_TYPE VSched    (VSCHED_PARAMS);
+extern VPROC_RTN_TYPE VSchedPost    (VSCHEDPOST_PARAMS);
+extern VPROC_RTN_TYPE VSchedCollect (VSCHEDCOLLECT_PARAMS);
 extern VPROC_RTN_TYPE VProcUser (VPROCUSER_PARAMS);
 extern VPROC_RTN_TYPE VIrq      (VIRQ_PARAMS);
 extern VPROC_RTN_TYPE VAccess   (VACCESS_PARAMS);
@@ -0,0 +1,416 @@
+//=====================================================================
+//
+// VShm.c                                             Date: 2024/07/01
+//
+// Copyright (c) 2024 Simon Southwell.
+//
+// This file is part of VProc.
+//
+// VProc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VProc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VProc. If not, see <http://www.gnu.org/licenses/>.
+//
+//=====================================================================
+//
+// Shared memory transport for user code in a separate process. The
+// simulator (server) side creates a segment for each selected node
+// in VInit, and the client side (VShmClient.c) maps it. Messages are
+// handed over with a sequence counter per direction, polled briefly
+// before sleeping on it as a futex. A timed out wait checks that the
+// other process is still running, so that a crashed user process
+// puts its node to sleep rather than hanging the simulation.
+//
+// Linux only. Elsewhere the transport is never selected.
+//
+//=====================================================================
+
+#include <string.h>
+#include "VProc.h"
+#include "VUser.h"
+#include "VShm.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// -------------------------------------------------------------------------
+// VShmName()
+//
+// Constructs the shared memory object name for a node
+// -------------------------------------------------------------------------
+
+static void VShmName (char* name, const size_t len, const char* prefix, const unsigned node)
+{
+    snprintf(name, len, "/%s.%d", prefix, node);
+}
+
+// -------------------------------------------------------------------------
+// VShmWake()
+//
+// Marks a message as valid by incrementing its sequence counter, and
+// wakes any waiter
+// -------------------------------------------------------------------------
+
+static void VShmWake (uint32_t* seq)
+{
+    __atomic_add_fetch(seq, 1, __ATOMIC_RELEASE);
+
+    syscall(SYS_futex, seq, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+// -------------------------------------------------------------------------
+// VShmWait()
+//
+// Waits for a sequence counter to move on from its last seen value.
+// Returns non-zero if the process pid has gone away while waiting.
+// -------------------------------------------------------------------------
+
+static int VShmWait (uint32_t* seq, const unsigned node, const int32_t* pid)
+{
+    struct timespec timeout = {0, VSHM_TIMEOUT_MS * 1000000L};
+    uint32_t        last    = ns[node]->shm_seq;
+    int             spin;
+
+    for (spin = 0; spin < VSHM_SPIN_COUNT; spin++)
+    {
+        if (__atomic_load_n(seq, __ATOMIC_ACQUIRE) != last)
+        {
+            ns[node]->shm_seq++;
+            return 0;
+        }
+    }
+
+    while (__atomic_load_n(seq, __ATOMIC_ACQUIRE) == last)
+    {
+        if (syscall(SYS_futex, seq, FUTEX_WAIT, last, &timeout, NULL, 0) == -1 && errno == ETIMEDOUT)
+        {
+            int32_t other = __atomic_load_n(pid, __ATOMIC_ACQUIRE);
+
+            // Only a process that has connected can have gone
+            if (other != 0 && kill(other, 0) == -1 && errno == ESRCH)
+            {
+                return 1;
+            }
+        }
+    }
+
+    ns[node]->shm_seq++;
+
+    return 0;
+}
+
+// =========================================================================
+// Simulator side
+// =========================================================================
+
+// -------------------------------------------------------------------------
+// VShmServerInit()
+//
+// Creates the shared memory segment for a node if the transport is
+// selected for it, by VPROC_SHM being set to a name prefix and, if
+// VPROC_SHM_NODES is set, its bit being set in that mask. Returns
+// non-zero if the node's user code is to run in-process.
+// -------------------------------------------------------------------------
+
+int VShmServerInit (const unsigned node)
+{
+    const char* prefix = getenv(VSHM_ENV_NAME);
+    const char* nodes  = getenv(VSHM_ENV_NODES);
+    char        name[DEFAULT_STR_BUF_SIZE*2];
+    vshm_t*     shm;
+    int         fd;
+
+    if (prefix == NULL || (nodes != NULL && !((strtoull(nodes, NULL, 0) >> node) & 1ULL)))
+    {
+        return 1;
+    }
+
+    VShmName(name, sizeof(name), prefix, node);
+
+    // Remove any segment left from an earlier run
+    shm_unlink(name);
+
+    if ((fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600)) == -1 || ftruncate(fd, sizeof(vshm_t)) == -1)
+    {
+        VPrint("***Error: VInit() failed to create shared memory %s (%s)\n", name, strerror(errno));
+        exit(1);
+    }
+
+    shm = (vshm_t*) mmap(NULL, sizeof(vshm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (shm == MAP_FAILED)
+    {
+        VPrint("***Error: VInit() failed to map shared memory %s (%s)\n", name, strerror(errno));
+        exit(1);
+    }
+
+    memset(shm, 0, sizeof(vshm_t));
+
+    shm->version    = VSHM_VERSION;
+    shm->server_pid = getpid();
+
+    // Publish the segment as ready
+    __atomic_store_n(&shm->magic, VSHM_MAGIC, __ATOMIC_RELEASE);
+
+    ns[node]->shm_seq  = 0;
+    ns[node]->shm_dead = 0;
+    ns[node]->shm   = shm;
+
+    VPrint("VInit(%d): user code connects through shared memory %s\n", node, name);
+
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// VShmServerSend()
+//
+// Sends the node's rcv_buf to the client
+// -------------------------------------------------------------------------
+
+void VShmServerSend (const unsigned node)
+{
+    vshm_t* shm = ns[node]->shm;
+
+    if (ns[node]->shm_dead)
+    {
+        return;
+    }
+
+    shm->rcv = ns[node]->rcv_buf;
+
+    VShmWake(&shm->rcv_seq);
+}
+
+// -------------------------------------------------------------------------
+// VShmServerRecv()
+//
+// Waits for the client's next message, updating the node's send_buf,
+// with burst data accessed in the segment. If the client process has
+// gone, the node is put to sleep.
+// -------------------------------------------------------------------------
+
+void VShmServerRecv (const unsigned node)
+{
+    vshm_t* shm = ns[node]->shm;
+
+    ns[node]->send_buf.data_p = shm->burst;
+
+    if (!ns[node]->shm_dead && VShmWait(&shm->snd_seq, node, &shm->client_pid))
+    {
+        VPrint("***Warning: user process for node %d has exited. Node halted\n", node);
+        ns[node]->shm_dead = 1;
+    }
+
+    if (ns[node]->shm_dead)
+    {
+        ns[node]->send_buf.addr     = 0;
+        ns[node]->send_buf.data_out = 0;
+        ns[node]->send_buf.rw       = V_IDLE;
+        ns[node]->send_buf.ticks    = GO_TO_SLEEP;
+        return;
+    }
+
+    ns[node]->send_buf.addr     = shm->send.addr;
+    ns[node]->send_buf.data_out = shm->send.data_out;
+    ns[node]->send_buf.rw       = shm->send.rw;
+    ns[node]->send_buf.ticks    = shm->send.ticks;
+}
+
+// -------------------------------------------------------------------------
+// VShmServerEvent()
+//
+// Queues a callback event for the client
+// -------------------------------------------------------------------------
+
+void VShmServerEvent (const unsigned node, const uint32_t type, const uint32_t value)
+{
+    vshm_t*  shm = ns[node]->shm;
+    uint32_t wr  = shm->evt_wr;
+
+    if (wr - __atomic_load_n(&shm->evt_rd, __ATOMIC_ACQUIRE) >= VSHM_EVT_QUEUE_SIZE)
+    {
+        VPrint("***Warning: callback event queue full on node %d. Event discarded\n", node);
+        return;
+    }
+
+    shm->evt[wr % VSHM_EVT_QUEUE_SIZE].type  = type;
+    shm->evt[wr % VSHM_EVT_QUEUE_SIZE].value = value;
+
+    __atomic_store_n(&shm->evt_wr, wr + 1, __ATOMIC_RELEASE);
+}
+
+// =========================================================================
+// Client side
+// =========================================================================
+
+// -------------------------------------------------------------------------
+// VShmClientInit()
+//
+// Maps the node's shared memory segment, waiting for the simulator to
+// create it. The name is then unlinked, as it is no longer needed.
+// Returns non-zero on error.
+// -------------------------------------------------------------------------
+
+int VShmClientInit (const unsigned node)
+{
+    const char* prefix = getenv(VSHM_ENV_NAME);
+    char        name[DEFAULT_STR_BUF_SIZE*2];
+    vshm_t*     shm;
+    int         fd;
+    int         waiting = 0;
+
+    VShmName(name, sizeof(name), prefix != NULL ? prefix : "vproc", node);
+
+    while (1)
+    {
+        if ((fd = shm_open(name, O_RDWR, 0)) != -1)
+        {
+            shm = (vshm_t*) mmap(NULL, sizeof(vshm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+
+            if (shm == MAP_FAILED)
+            {
+                VPrint("***Error: failed to map shared memory %s (%s)\n", name, strerror(errno));
+                return 1;
+            }
+
+            if (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) == VSHM_MAGIC)
+            {
+                break;
+            }
+
+            munmap(shm, sizeof(vshm_t));
+        }
+
+        if (!waiting)
+        {
+            VPrint("Waiting for simulation to create shared memory %s\n", name);
+            waiting = 1;
+        }
+
+        usleep(10000);
+    }
+
+    if (shm->version != VSHM_VERSION)
+    {
+        VPrint("***Error: shared memory %s is version %d, expected %d\n", name, shm->version, VSHM_VERSION);
+        return 1;
+    }
+
+    shm_unlink(name);
+
+    __atomic_store_n(&shm->client_pid, getpid(), __ATOMIC_RELEASE);
+
+    ns[node]->shm_seq = 0;
+    ns[node]->shm  = shm;
+
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// VShmClientSend()
+//
+// Sends the node's send_buf to the simulator, copying any burst data
+// into the segment
+// -------------------------------------------------------------------------
+
+void VShmClientSend (const unsigned node)
+{
+    vshm_t*  shm      = ns[node]->shm;
+    rw_t*    p_rw     = (rw_t*)&ns[node]->send_buf.rw;
+    unsigned burstlen = p_rw->burstlen;
+
+    if (burstlen)
+    {
+        memcpy(shm->burst, ns[node]->send_buf.data_p, burstlen * sizeof(uint32_t));
+    }
+
+    shm->send.addr     = ns[node]->send_buf.addr;
+    shm->send.data_out = ns[node]->send_buf.data_out;
+    shm->send.rw       = ns[node]->send_buf.rw;
+    shm->send.ticks    = ns[node]->send_buf.ticks;
+
+    VShmWake(&shm->snd_seq);
+}
+
+// -------------------------------------------------------------------------
+// VShmClientRecv()
+//
+// Waits for the simulator's next message, updating the node's rcv_buf
+// and copying back any burst data. Queued callback events are then
+// called. Exits if the simulation has gone.
+// -------------------------------------------------------------------------
+
+void VShmClientRecv (const unsigned node)
+{
+    vshm_t*  shm      = ns[node]->shm;
+    rw_t*    p_rw     = (rw_t*)&ns[node]->send_buf.rw;
+    unsigned burstlen = p_rw->burstlen;
+    uint32_t rd;
+
+    if (VShmWait(&shm->rcv_seq, node, &shm->server_pid))
+    {
+        VPrint("***Error: simulation for node %d has exited\n", node);
+        exit(1);
+    }
+
+    ns[node]->rcv_buf = shm->rcv;
+
+    if (burstlen)
+    {
+        memcpy(ns[node]->send_buf.data_p, shm->burst, burstlen * sizeof(uint32_t));
+    }
+
+    for (rd = shm->evt_rd; rd != __atomic_load_n(&shm->evt_wr, __ATOMIC_ACQUIRE); rd++)
+    {
+        vshm_evt_t* evt = &shm->evt[rd % VSHM_EVT_QUEUE_SIZE];
+
+        if (evt->type == VSHM_EVT_IRQ && ns[node]->VUserIrqCB != NULL)
+        {
+            (*(ns[node]->VUserIrqCB))(evt->value);
+        }
+        else if (evt->type == VSHM_EVT_USER && ns[node]->VUserCB != NULL)
+        {
+            (*(ns[node]->VUserCB))(evt->value);
+        }
+
+        __atomic_store_n(&shm->evt_rd, rd + 1, __ATOMIC_RELEASE);
+    }
+}
+
+#else
+
+// Non-Linux hosts have no futexes, so the transport is never selected
+
+int  VShmServerInit  (const unsigned node) { return 1; }
+void VShmServerSend  (const unsigned node) {}
+void VShmServerRecv  (const unsigned node) {}
+void VShmServerEvent (const unsigned node, const uint32_t type, const uint32_t value) {}
+
+int  VShmClientInit  (const unsigned node)
+{
+    VPrint("***Error: shared memory transport not supported on this host\n");
+    return 1;
+}
+
+void VShmClientSend  (const unsigned node) {}
+void VShmClientRecv  (const unsigned node) {}
+
+#endif
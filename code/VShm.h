@@ -0,0 +1,103 @@
+//=====================================================================
+//
+// VShm.h                                             Date: 2024/07/01
+//
+// Copyright (c) 2024 Simon Southwell.
+//
+// This file is part of VProc.
+//
+// VProc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VProc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VProc. If not, see <http://www.gnu.org/licenses/>.
+//
+//=====================================================================
+//
+// Shared memory transport between the simulator and user code run in
+// a separate process. Each node using the transport has a POSIX
+// shared memory segment, named /<VPROC_SHM>.<node>, in place of the
+// semaphores and exchange buffers of an in-process user thread.
+//
+//=====================================================================
+
+#ifndef _VSHM_H_
+#define _VSHM_H_
+
+#include "VProc.h"
+
+#define VSHM_MAGIC              0x4d485356      // "VSHM"
+#define VSHM_VERSION            2
+
+// Environment variables selecting the transport, and the nodes using it
+#define VSHM_ENV_NAME           "VPROC_SHM"
+#define VSHM_ENV_NODES          "VPROC_SHM_NODES"
+
+// Polls of the sequence counters before sleeping on the futex, and the
+// sleep timeout (ms) after which the other process is checked as alive
+#define VSHM_SPIN_COUNT         2000
+#define VSHM_TIMEOUT_MS         100
+
+// Queued callback events (vectored IRQ and $vprocuser), called in the
+// client process when it next receives a message
+#define VSHM_EVT_IRQ            0
+#define VSHM_EVT_USER           1
+#define VSHM_EVT_QUEUE_SIZE     1024
+
+#define VSHM_MAX_BURST_WORDS    4096
+
+// User thread to simulation message (send_buf_t without the data pointer,
+// burst data being in the segment's burst buffer)
+typedef struct {
+    uint32_t            addr;
+    uint32_t            data_out;
+    uint32_t            rw;
+    int32_t             ticks;
+} vshm_send_t;
+
+typedef struct {
+    uint32_t            type;
+    uint32_t            value;
+} vshm_evt_t;
+
+// Shared memory segment layout. The sequence counters are futex words,
+// each incremented by its writer when its message is valid.
+typedef struct vshm_s {
+    uint32_t            magic;
+    uint32_t            version;
+    int32_t             server_pid;
+    int32_t             client_pid;
+
+    uint32_t            snd_seq;
+    uint32_t            rcv_seq;
+    uint32_t            irq_cb;
+
+    vshm_send_t         send;
+    rcv_buf_t           rcv;
+
+    uint32_t            evt_wr;
+    uint32_t            evt_rd;
+    vshm_evt_t          evt[VSHM_EVT_QUEUE_SIZE];
+
+    uint32_t            burst[VSHM_MAX_BURST_WORDS];
+} vshm_t;
+
+// Simulator side
+extern int  VShmServerInit  (const unsigned node);
+extern void VShmServerSend  (const unsigned node);
+extern void VShmServerRecv  (const unsigned node);
+extern void VShmServerEvent (const unsigned node, const uint32_t type, const uint32_t value);
+
+// Client (user code process) side
+extern int  VShmClientInit  (const unsigned node);
+extern void VShmClientSend  (const unsigned node);
+extern void VShmClientRecv  (const unsigned node);
+
+#endif
@@ -0,0 +1,86 @@
+//=====================================================================
+//
+// VShmClient.c                                       Date: 2024/07/01
+//
+// Copyright (c) 2024 Simon Southwell.
+//
+// This file is part of VProc.
+//
+// VProc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VProc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VProc. If not, see <http://www.gnu.org/licenses/>.
+//
+//=====================================================================
+//
+// Entry point for user code run in a separate process from the
+// simulator, over the shared memory transport. Linked (with VUser.c
+// and VShm.c) into libvprocclient.a, with user code linked against
+// it unchanged, using -rdynamic so that VUserMain<node> is found:
+//
+//   <exe> [<node> ...]
+//
+// runs VUserMain<node> for each node given (default 0), connecting to
+// the simulator's segment named by VPROC_SHM, which the simulation
+// must also have set.
+//
+//=====================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "VProc.h"
+#include "VUser.h"
+#include "VShm.h"
+
+// Pointers to state for each node (up to VP_MAX_NODES)
+pSchedState_t ns[VP_MAX_NODES];
+
+int main (int argc, char** argv)
+{
+    int nodes[VP_MAX_NODES];
+    int num_nodes = 0;
+    int idx;
+
+    for (idx = 1; idx < argc && num_nodes < VP_MAX_NODES; idx++)
+    {
+        nodes[num_nodes++] = (int)strtol(argv[idx], NULL, 0);
+    }
+
+    if (num_nodes == 0)
+    {
+        nodes[num_nodes++] = 0;
+    }
+
+    for (idx = 0; idx < num_nodes; idx++)
+    {
+        int node = nodes[idx];
+
+        if (node < 0 || node >= VP_MAX_NODES)
+        {
+            VPrint("***Error: out of range node number (%d)\n", node);
+            exit(VP_USER_ERR);
+        }
+
+        ns[node] = VAllocState();
+
+        if (ns[node] == NULL || VShmClientInit(node) || VUser(node))
+        {
+            exit(VP_USER_ERR);
+        }
+
+        VPrint("VUserMain%d: connected to simulation\n", node);
+    }
+
+    // Leave the user threads running
+    pthread_exit(NULL);
+
+    return 0;
+}
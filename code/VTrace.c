@@ -0,0 +1,292 @@
+//=====================================================================
+//
+// VTrace.c                                           Date: 2024/07/29
+//
+// Copyright (c) 2024 Simon Southwell.
+//
+// This file is part of VProc.
+//
+// VProc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VProc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VProc. If not, see <http://www.gnu.org/licenses/>.
+//
+//=====================================================================
+//
+// Trace recorder. Each thread records events into a buffer of its
+// own, a list of chunks, so recording takes no locks. A chunk's event
+// count is published after the event is written, so that the buffers
+// can be written out at exit while user threads are still blocked
+// part way through, or even recording.
+//
+//=====================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "VTrace.h"
+
+typedef struct vtrace_chunk_s {
+    struct vtrace_chunk_s* next;
+    uint32_t               count;
+    vtrace_event_t         events[VTRACE_CHUNK_EVENTS];
+} vtrace_chunk_t;
+
+typedef struct vtrace_buf_s {
+    struct vtrace_buf_s*   next;
+    vtrace_chunk_t*        head;
+    vtrace_chunk_t*        tail;
+} vtrace_buf_t;
+
+// Non-zero when tracing is enabled
+int                        vtrace_on    = 0;
+
+static const char*         vtrace_fname;
+static uint64_t            vtrace_start;
+static vtrace_buf_t*       vtrace_bufs  = NULL;
+static __thread vtrace_buf_t* vtrace_local = NULL;
+static pthread_once_t      vtrace_once  = PTHREAD_ONCE_INIT;
+
+// -------------------------------------------------------------------------
+// VTraceNow()
+//
+// Returns the host time, in nanoseconds
+// -------------------------------------------------------------------------
+
+uint64_t VTraceNow (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// -------------------------------------------------------------------------
+// VTraceAlloc()
+//
+// Allocates a new chunk, or a thread's buffer with its first chunk,
+// linking it on to the list of buffers. Returns the thread's buffer,
+// or NULL if out of memory.
+// -------------------------------------------------------------------------
+
+static vtrace_buf_t* VTraceAlloc (void)
+{
+    vtrace_chunk_t* chunk;
+
+    if ((chunk = (vtrace_chunk_t*)calloc(1, sizeof(vtrace_chunk_t))) == NULL)
+    {
+        return NULL;
+    }
+
+    if (vtrace_local == NULL)
+    {
+        if ((vtrace_local = (vtrace_buf_t*)calloc(1, sizeof(vtrace_buf_t))) == NULL)
+        {
+            free(chunk);
+            return NULL;
+        }
+
+        vtrace_local->head = vtrace_local->tail = chunk;
+
+        vtrace_local->next = __atomic_load_n(&vtrace_bufs, __ATOMIC_ACQUIRE);
+        while (!__atomic_compare_exchange_n(&vtrace_bufs, &vtrace_local->next, vtrace_local, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            ;
+    }
+    else
+    {
+        __atomic_store_n(&vtrace_local->tail->next, chunk, __ATOMIC_RELEASE);
+        vtrace_local->tail = chunk;
+    }
+
+    return vtrace_local;
+}
+
+// -------------------------------------------------------------------------
+// VTraceRecord()
+//
+// Records an event into the calling thread's buffer. Events are
+// dropped if out of memory.
+// -------------------------------------------------------------------------
+
+static void VTraceRecord (const vtrace_event_t* event)
+{
+    vtrace_chunk_t* chunk;
+
+    if ((vtrace_local == NULL || vtrace_local->tail->count == VTRACE_CHUNK_EVENTS) && VTraceAlloc() == NULL)
+    {
+        return;
+    }
+
+    chunk                        = vtrace_local->tail;
+    chunk->events[chunk->count]  = *event;
+
+    __atomic_store_n(&chunk->count, chunk->count + 1, __ATOMIC_RELEASE);
+}
+
+// -------------------------------------------------------------------------
+// VTraceWriteEvent()
+//
+// Writes an event as a Chrome Trace Event JSON object
+// -------------------------------------------------------------------------
+
+static void VTraceWriteEvent (FILE* fp, const vtrace_event_t* ev)
+{
+    fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f",
+            ev->name, ev->cat, ev->ph, ev->pid, ev->node, (ev->ts - vtrace_start) / 1000.0);
+
+    if (ev->ph == 'X')
+    {
+        fprintf(fp, ",\"dur\":%.3f", ev->dur / 1000.0);
+    }
+    else
+    {
+        fprintf(fp, ",\"s\":\"t\"");
+    }
+
+    fprintf(fp, ",\"args\":{\"cycle\":%llu", (unsigned long long)ev->cycle);
+
+    if (ev->argname != NULL)
+    {
+        fprintf(fp, ",\"%s\":%u", ev->argname, ev->arg);
+    }
+
+    fprintf(fp, "}}");
+}
+
+// -------------------------------------------------------------------------
+// VTraceFlush()
+//
+// Writes the recorded events to the trace file, at exit, with names
+// for the processes and for each node seen
+// -------------------------------------------------------------------------
+
+static void VTraceFlush (void)
+{
+    FILE*           fp;
+    vtrace_buf_t*   buf;
+    vtrace_chunk_t* chunk;
+    uint32_t        idx, count;
+    static uint8_t  seen[2][1 << 16];
+
+    if ((fp = fopen(vtrace_fname, "w")) == NULL)
+    {
+        fprintf(stderr, "***Error: failed to open trace file %s (VTraceFlush)\n", vtrace_fname);
+        return;
+    }
+
+    fprintf(fp, "{\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"simulator\"}}", VTRACE_PID_SIM);
+    fprintf(fp, ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"user threads\"}}", VTRACE_PID_USER);
+
+    for (buf = __atomic_load_n(&vtrace_bufs, __ATOMIC_ACQUIRE); buf != NULL; buf = buf->next)
+    {
+        for (chunk = buf->head; chunk != NULL; chunk = __atomic_load_n(&chunk->next, __ATOMIC_ACQUIRE))
+        {
+            count = __atomic_load_n(&chunk->count, __ATOMIC_ACQUIRE);
+
+            for (idx = 0; idx < count; idx++)
+            {
+                vtrace_event_t* ev = &chunk->events[idx];
+
+                if (!seen[ev->pid][ev->node])
+                {
+                    seen[ev->pid][ev->node] = 1;
+                    fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"node %d\"}}",
+                            ev->pid, ev->node, ev->node);
+                }
+
+                VTraceWriteEvent(fp, ev);
+            }
+        }
+    }
+
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+}
+
+// -------------------------------------------------------------------------
+// VTraceStart()
+//
+// Enables tracing if the trace file environment variable is set
+// -------------------------------------------------------------------------
+
+static void VTraceStart (void)
+{
+    if ((vtrace_fname = getenv(VTRACE_ENV_NAME)) != NULL && vtrace_fname[0] != '\0')
+    {
+        vtrace_start = VTraceNow();
+        atexit(VTraceFlush);
+        vtrace_on    = 1;
+    }
+}
+
+// -------------------------------------------------------------------------
+// VTraceInit()
+//
+// Called from VInit() for each node, enabling tracing on the first
+// -------------------------------------------------------------------------
+
+void VTraceInit (void)
+{
+    pthread_once(&vtrace_once, VTraceStart);
+}
+
+// -------------------------------------------------------------------------
+// VTraceSpan()
+//
+// Records a span for a node, from start to now
+// -------------------------------------------------------------------------
+
+void VTraceSpan (const int pid, const unsigned node, const char* name, const char* cat, const uint64_t start,
+                 const char* argname, const uint32_t arg, const uint64_t cycle)
+{
+    vtrace_event_t ev;
+
+    ev.name    = name;
+    ev.cat     = cat;
+    ev.argname = argname;
+    ev.ts      = start;
+    ev.dur     = VTraceNow() - start;
+    ev.cycle   = cycle;
+    ev.arg     = arg;
+    ev.node    = node;
+    ev.pid     = pid;
+    ev.ph      = 'X';
+
+    VTraceRecord(&ev);
+}
+
+// -------------------------------------------------------------------------
+// VTraceInstant()
+//
+// Records an instant event for a node
+// -------------------------------------------------------------------------
+
+void VTraceInstant (const int pid, const unsigned node, const char* name, const char* cat,
+                    const char* argname, const uint32_t arg, const uint64_t cycle)
+{
+    vtrace_event_t ev;
+
+    ev.name    = name;
+    ev.cat     = cat;
+    ev.argname = argname;
+    ev.ts      = VTraceNow();
+    ev.dur     = 0;
+    ev.cycle   = cycle;
+    ev.arg     = arg;
+    ev.node    = node;
+    ev.pid     = pid;
+    ev.ph      = 'i';
+
+    VTraceRecord(&ev);
+}
@@ -0,0 +1,72 @@
+//=====================================================================
+//
+// VTrace.h                                           Date: 2024/07/29
+//
+// Copyright (c) 2024 Simon Southwell.
+//
+// This file is part of VProc.
+//
+// VProc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VProc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VProc. If not, see <http://www.gnu.org/licenses/>.
+//
+//=====================================================================
+//
+// Trace recorder for node handoffs and transactions, enabled by
+// setting VPROC_TRACE to the name of a file, to which the trace is
+// written at exit in Chrome Trace Event JSON format (viewable with
+// Perfetto or chrome://tracing). When not enabled, each trace point
+// costs a test of vtrace_on.
+//
+//=====================================================================
+
+#ifndef _VTRACE_H_
+#define _VTRACE_H_
+
+#include <stdint.h>
+
+// Environment variable naming the trace file
+#define VTRACE_ENV_NAME         "VPROC_TRACE"
+
+// Events per buffer chunk
+#define VTRACE_CHUNK_EVENTS     4096
+
+// Trace process IDs, for events recorded by the simulator and by the
+// user threads, with each node a thread within them
+#define VTRACE_PID_SIM          0
+#define VTRACE_PID_USER         1
+
+// Trace event, a span ('X') or an instant ('i'), with an optional
+// argument and the node's clock cycle
+typedef struct {
+    const char*         name;
+    const char*         cat;
+    const char*         argname;
+    uint64_t            ts;         // Host time (ns)
+    uint64_t            dur;        // Duration of a span (ns)
+    uint64_t            cycle;
+    uint32_t            arg;
+    uint16_t            node;
+    uint8_t             pid;
+    char                ph;
+} vtrace_event_t;
+
+extern int      vtrace_on;
+
+extern void     VTraceInit    (void);
+extern uint64_t VTraceNow     (void);
+extern void     VTraceSpan    (const int pid, const unsigned node, const char* name, const char* cat, const uint64_t start,
+                               const char* argname, const uint32_t arg, const uint64_t cycle);
+extern void     VTraceInstant (const int pid, const unsigned node, const char* name, const char* cat,
+                               const char* argname, const uint32_t arg, const uint64_t cycle);
+
+#endif
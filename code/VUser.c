@@ -27,16 +27,108 @@
 //=====================================================================
 
 #include <errno.h>
+#include <string.h>
 #include "VProc.h"
 #include "VUser.h"
+#include "VShm.h"
+#include "VTrace.h"
 
 // Forward declaration
 static void VUserInit (const unsigned node);
 
+// Node group state
+static VGroupState_t  groups[VP_MAX_GROUPS];
+static pthread_once_t groups_once = PTHREAD_ONCE_INIT;
+
+// -------------------------------------------------------------------------
+// VUserPost()
+//
+// Signals a message to the simulator, through the shared memory
+// transport if the user code is out-of-process. Returns -1 on error.
+// -------------------------------------------------------------------------
+
+static int VUserPost (const unsigned node)
+{
+    if (ns[node]->shm != NULL)
+    {
+        VShmClientSend(node);
+        return 0;
+    }
+
+    return sem_post(&(ns[node]->snd));
+}
+
+// -------------------------------------------------------------------------
+// VUserWait()
+//
+// Waits for a message from the simulator, through the shared memory
+// transport if the user code is out-of-process. Returns -1 on error.
+// -------------------------------------------------------------------------
+
+static int VUserWait (const unsigned node)
+{
+    if (ns[node]->shm != NULL)
+    {
+        VShmClientRecv(node);
+        return 0;
+    }
+
+    return sem_wait(&(ns[node]->rcv));
+}
+
+// -------------------------------------------------------------------------
+// VGroupInit()
+//
+// Initialises the node group semaphores, once, on first use
+// -------------------------------------------------------------------------
+
+static void VGroupInit (void)
+{
+    int idx;
+
+    for (idx = 0; idx < VP_MAX_GROUPS; idx++)
+    {
+        if (sem_init(&groups[idx].join, 0, 0) == -1 || sem_init(&groups[idx].done, 0, 0) == -1)
+        {
+            VPrint("***Error: failed to initialise semaphore for group %d (VGroupInit)\n", idx);
+            exit(1);
+        }
+    }
+}
+
 // =========================================================================
 // Simulation interface functions
 // =========================================================================
 
+// -------------------------------------------------------------------------
+// VAllocState()
+//
+// Allocates zeroed state for a node, aligned and padded to whole cache
+// lines. Returns NULL on failure.
+// -------------------------------------------------------------------------
+
+pSchedState_t VAllocState (void)
+{
+    void*  state;
+    size_t size = (sizeof(SchedState_t) + VP_CACHE_LINE - 1) & ~((size_t)VP_CACHE_LINE - 1);
+
+#ifdef WIN32
+    state = _aligned_malloc(size, VP_CACHE_LINE);
+#else
+    if (posix_memalign(&state, VP_CACHE_LINE, size))
+    {
+        state = NULL;
+    }
+#endif
+
+    if (state != NULL)
+    {
+        memset(state, 0, size);
+    }
+
+    return (pSchedState_t)state;
+}
+
 // -------------------------------------------------------------------------
 // VUser()
 //
@@ -115,18 +207,58 @@ static void VUserInit (const unsigned node)
     // Wait for first message from simulator
     debug_io_printf("VUserInit(): waiting for first message semaphore rcv[%d]\n", node);
 
-    if ((status = sem_wait(&(ns[node]->rcv))) == -1)
+    if ((status = VUserWait(node)) == -1)
     {
         VPrint("***Error: bad sem_post status (%d) on node %d (VUserInit)\n", status, node);
         exit(1);
     }
 
+    if (vtrace_on)
+    {
+        ns[node]->trace_ts = VTraceNow();
+    }
+
     debug_io_printf("VUserInit(): calling user code for node %d\n", node);
 
     // Call user program
     debug_io_printf("VUserInit(): calling VUserMain%d\n", node);
 
     VUserMain_func();
+
+    // If the user program registered a cycle model, hand the first
+    // command over to it, and let this thread finish
+    if (ns[node]->VUserCycleModel != NULL)
+    {
+        debug_io_printf("VUserInit(): node %d running as a cycle model\n", node);
+
+        VUserPost(node);
+    }
+}
+
+// -------------------------------------------------------------------------
+// VExchTrace()
+//
+// Records the span of a transaction, from the sending of its message
+// to the reply, named for its type
+// -------------------------------------------------------------------------
+
+static void VExchTrace (const send_buf_t* psbuf, const rcv_buf_t* prbuf, const uint64_t start, const unsigned node)
+{
+    const rw_t* p_rw = (const rw_t*)&psbuf->rw;
+    const char* cat  = (psbuf->ticks == DELTA_CYCLE) ? "delta" : "access";
+
+    if (p_rw->write)
+    {
+        VTraceSpan(VTRACE_PID_USER, node, p_rw->burstlen ? "burst write" : "write", cat, start, "addr", psbuf->addr, prbuf->cycle);
+    }
+    else if (p_rw->read)
+    {
+        VTraceSpan(VTRACE_PID_USER, node, p_rw->burstlen ? "burst read" : "read", cat, start, "addr", psbuf->addr, prbuf->cycle);
+    }
+    else
+    {
+        VTraceSpan(VTRACE_PID_USER, node, p_rw->irqbrk ? "tick irq" : "tick", "tick", start, "ticks", psbuf->ticks, prbuf->cycle);
+    }
 }
 
 // -------------------------------------------------------------------------
@@ -140,13 +272,22 @@ static void VUserInit (const unsigned node)
 
 static void VExch (psend_buf_t psbuf, prcv_buf_t prbuf, const unsigned node)
 {
-    int status;
+    int      status;
+    uint64_t start = 0;
+
+    // Record the user code's run since the last reply
+    if (vtrace_on)
+    {
+        VTraceSpan(VTRACE_PID_USER, node, "user", "user", ns[node]->trace_ts, NULL, 0, ns[node]->rcv_buf.cycle);
+        start = VTraceNow();
+    }
+
     // Send message to simulator
     ns[node]->send_buf = *psbuf;
 
     debug_io_printf("VExch(): setting snd[%d] semaphore\n", node);
 
-    if ((status = sem_post(&(ns[node]->snd))) == -1)
+    if ((status = VUserPost(node)) == -1)
     {
         VPrint("***Error: bad sem_post status (%d) on node %d (VExch)\n", status, node);
         exit(1);
@@ -156,7 +297,7 @@ static void VExch (psend_buf_t psbuf, prcv_buf_t prbuf, const unsigned node)
     {
         // Wait for response message from simulator
         debug_io_printf("VExch(): waiting for rcv[%d] semaphore\n", node);
-        sem_wait(&(ns[node]->rcv));
+        VUserWait(node);
 
         *prbuf = ns[node]->rcv_buf;
 
@@ -165,6 +306,11 @@ static void VExch (psend_buf_t psbuf, prcv_buf_t prbuf, const unsigned node)
         {
             debug_io_printf("VExch(): node %d processing interrupt (%d)\n", node, prbuf->interrupt);
 
+            if (vtrace_on)
+            {
+                VTraceInstant(VTRACE_PID_USER, node, "interrupt", "irq", "level", prbuf->interrupt, prbuf->cycle);
+            }
+
             if (prbuf->interrupt > MAX_INTERRUPT_LEVEL)
             {
                 VPrint("***Error: invalid interrupt level %d (VExch)\n", prbuf->interrupt);
@@ -183,7 +329,7 @@ static void VExch (psend_buf_t psbuf, prcv_buf_t prbuf, const unsigned node)
             // Send new message to simulation
             debug_io_printf("VExch(): setting snd[%d] semaphore (interrupt)\n", node);
 
-            if ((status = sem_post(&(ns[node]->snd))) == -1)
+            if ((status = VUserPost(node)) == -1)
             {
                 VPrint("***Error: bad sem_post status (%d) on node %d (VExch)\n", status, node);
                 exit(1);
@@ -194,6 +340,12 @@ static void VExch (psend_buf_t psbuf, prcv_buf_t prbuf, const unsigned node)
     }
     while (prbuf->interrupt > 0);
 
+    if (vtrace_on)
+    {
+        VExchTrace(psbuf, prbuf, start, node);
+        ns[node]->trace_ts = VTraceNow();
+    }
+
     debug_io_printf("VExch(): returning to user code from node %d\n", node);
 
 }
@@ -349,6 +501,97 @@ int VBurstRead (const unsigned int addr, void *data, const unsigned wordlen, con
     return 0;
 }
 
+// -------------------------------------------------------------------------
+// VStreamSend()
+//
+// Sends a frame of len bytes, with the given tuser, to an AXI4-Stream
+// BFM, as burst writes of up to VSTREAM_BURST_WORDS. The last word's
+// byte enables mark the valid bytes of a frame that is not a multiple
+// of 4 bytes. The frame is copied a burst at a time, so buf needs no
+// particular alignment, nor padding. Returns -1 for an empty frame.
+// -------------------------------------------------------------------------
+
+int VStreamSend (const void *buf, const unsigned len, const unsigned tuser, const unsigned node)
+{
+    uint32_t       words[VSTREAM_BURST_WORDS];
+    const uint8_t* p_buf  = (const uint8_t*)buf;
+    unsigned       addr   = VSTREAM_TX_ADDR | ((tuser & VSTREAM_TUSER_MASK) << VSTREAM_TUSER_SHIFT);
+    unsigned       remain = len;
+
+    if (len == 0)
+    {
+        return -1;
+    }
+
+    while (remain)
+    {
+        unsigned bytes = (remain > VSTREAM_BURST_WORDS*4) ? VSTREAM_BURST_WORDS*4 : remain;
+        unsigned wlen  = (bytes + 3) / 4;
+        int      last  = (bytes == remain);
+        unsigned lbe   = (bytes & 3) ? ((1 << (bytes & 3)) - 1) : 0xf;
+
+        words[wlen-1] = 0;
+        memcpy(words, p_buf, bytes);
+
+        // A single word burst takes the first byte enables
+        VBurstWriteBE(addr | (last ? 0 : VSTREAM_TX_NOLAST), words, wlen, (wlen == 1) ? lbe : 0xf, lbe, node);
+
+        p_buf  += bytes;
+        remain -= bytes;
+    }
+
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// VStreamRecv()
+//
+// Receives a frame from an AXI4-Stream BFM, if one is available, copying
+// up to maxlen bytes to buf, and its tuser (if not NULL). Returns the
+// frame's length in bytes (which may exceed maxlen, with the remainder
+// discarded) or 0 if there was no frame.
+// -------------------------------------------------------------------------
+
+int VStreamRecv (void *buf, const unsigned maxlen, unsigned *tuser, const unsigned node)
+{
+    uint32_t words[VSTREAM_BURST_WORDS];
+    uint8_t* p_buf = (uint8_t*)buf;
+    unsigned status;
+    unsigned len;
+    unsigned remain;
+
+    VRead(VSTREAM_RX_STATUS_ADDR, &status, 0, node);
+
+    if (!(status & VSTREAM_RX_VALID))
+    {
+        return 0;
+    }
+
+    len = status & VSTREAM_RX_LEN_MASK;
+
+    if (tuser != NULL)
+    {
+        *tuser = (status >> VSTREAM_RX_TUSER_SHIFT) & VSTREAM_TUSER_MASK;
+    }
+
+    for (remain = len; remain; )
+    {
+        unsigned bytes  = (remain > VSTREAM_BURST_WORDS*4) ? VSTREAM_BURST_WORDS*4 : remain;
+        unsigned offset = len - remain;
+
+        VBurstRead(VSTREAM_RX_DATA_ADDR, words, (bytes + 3) / 4, node);
+
+        if (offset < maxlen)
+        {
+            memcpy(p_buf + offset, words, (offset + bytes > maxlen) ? maxlen - offset : bytes);
+        }
+
+        remain -= bytes;
+    }
+
+    return len;
+}
+
 // -------------------------------------------------------------------------
 // VTick()
 //
@@ -370,6 +613,334 @@ int VTick (const unsigned ticks, const unsigned node)
     return 0;
 }
 
+// -------------------------------------------------------------------------
+// VTickIrq()
+//
+// Invokes a tick message exchange that the simulation terminates
+// early if the interrupt input changes value (i.e. when a vectored
+// IRQ event is raised). Returns the number of ticks remaining, which
+// is 0 if the full count elapsed.
+// -------------------------------------------------------------------------
+
+int VTickIrq (const unsigned ticks, const unsigned node)
+{
+    rcv_buf_t  rbuf;
+    send_buf_t sbuf;
+    rw_t*      p_rw = (rw_t*)&sbuf.rw;
+
+    sbuf.addr     = 0;
+    sbuf.data_out = 0;
+    sbuf.ticks    = ticks;
+
+    sbuf.rw       = V_IDLE;
+    p_rw->irqbrk  = 1;
+
+    VExch(&sbuf, &rbuf, node);
+
+    return rbuf.data_in;
+}
+
+// -------------------------------------------------------------------------
+// VGetCycle()
+//
+// Returns the node's clock cycle count, as of the return of its last
+// access (or tick), or of its group's last issue
+// -------------------------------------------------------------------------
+
+uint64_t VGetCycle (const unsigned node)
+{
+    if (ns[node]->group != NULL)
+    {
+        return ns[node]->group->cycle;
+    }
+
+    return ns[node]->rcv_buf.cycle;
+}
+
+// -------------------------------------------------------------------------
+// VGetSimTime()
+//
+// Returns the simulation time, in the VProc component's time units, as
+// of the return of the node's last access (or tick), or of its group's
+// last issue
+// -------------------------------------------------------------------------
+
+uint64_t VGetSimTime (const unsigned node)
+{
+    if (ns[node]->group != NULL)
+    {
+        return ns[node]->group->time;
+    }
+
+    return ns[node]->rcv_buf.time;
+}
+
+// -------------------------------------------------------------------------
+// VWaitCond()
+//
+// Waits until a condition, tested on the simulation thread at the node's
+// next clock edge, is met. The node then idles, without its user thread
+// being woken, until the condition is met. Where the HDL can be woken
+// from C, the node is parked until another node calls VWaitWake() for
+// it, else the condition is tested at each of its clock edges.
+// -------------------------------------------------------------------------
+
+int VWaitCond (const pVUserWaitCond_t cond, void* arg, const unsigned node)
+{
+    if (ns[node]->shm != NULL || ns[node]->group != NULL)
+    {
+        VPrint("***Error: wait on out-of-process or grouped node %d (VWaitCond)\n", node);
+        exit(1);
+    }
+
+    ns[node]->wait_arg  = arg;
+    ns[node]->wait_cond = cond;
+
+    return VTick(0, node);
+}
+
+// -------------------------------------------------------------------------
+// VWaitWake()
+//
+// Wakes a node waiting in VWaitCond(), to test its condition again,
+// when this node's next command is collected by the simulator. Called
+// from this node's user code, once it has made the condition true (e.g.
+// by sending to the mailbox the waiter is waiting on). Returns non-zero
+// on error.
+// -------------------------------------------------------------------------
+
+int VWaitWake (const unsigned waiter, const unsigned node)
+{
+    if (waiter >= VP_MAX_NODES || ns[waiter] == NULL)
+    {
+        VPrint("***Error: wake of invalid node %d from node %d (VWaitWake)\n", waiter, node);
+        return 1;
+    }
+
+    if (ns[node]->wake_count < VP_MAX_NODES)
+    {
+        ns[node]->wake_nodes[ns[node]->wake_count++] = waiter;
+    }
+
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// VWaitUntil()
+//
+// Ticks until the node's clock cycle count reaches the given cycle,
+// as a single tick unless further away than the maximum tick. Returns
+// immediately if the cycle has already been reached.
+// -------------------------------------------------------------------------
+
+int VWaitUntil (const uint64_t cycle, const unsigned node)
+{
+    uint64_t now;
+
+    while ((now = VGetCycle(node)) < cycle)
+    {
+        VTick((cycle - now) > GO_TO_SLEEP ? GO_TO_SLEEP : (unsigned)(cycle - now), node);
+    }
+
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// VGroupJoin()
+//
+// Joins the node to a group, to be driven by VGroupIssue() from a
+// single user thread. Called from VUserMain<node>, which then returns
+// without making any accesses, except for the node whose thread is to
+// drive the group, which joins it and carries on. The nodes must be
+// scheduled in two phases (VPROC_TWO_PHASE), so not with Verilator.
+// -------------------------------------------------------------------------
+
+int VGroupJoin (const unsigned group, const unsigned node)
+{
+    unsigned members;
+    unsigned size;
+
+    debug_io_printf("VGroupJoin(): at node %d, joining group %d\n", node, group);
+
+    if (group >= VP_MAX_GROUPS)
+    {
+        VPrint("***Error: out of range group %d for node %d (VGroupJoin)\n", group, node);
+        exit(1);
+    }
+
+    if (ns[node]->shm != NULL)
+    {
+        VPrint("***Error: out-of-process node %d joined to group %d (VGroupJoin)\n", node, group);
+        exit(1);
+    }
+
+    // All the nodes of a group must be posted, before any collects its
+    // next command, so that they complete an issue in the same cycle.
+    // With Verilator the two calls are back to back.
+#ifndef VERILATOR
+    if (!ns[node]->two_phase)
+#endif
+    {
+        VPrint("***Error: node %d joined to group %d without VPROC_TWO_PHASE, or with Verilator (VGroupJoin)\n", node, group);
+        exit(1);
+    }
+
+    pthread_once(&groups_once, VGroupInit);
+
+    // Count the node in before it is seen to have joined, so that an issue
+    // which has waited for its nodes to join sees them all in the count.
+    // A node joining after the first issue must have been in it.
+    members = __atomic_add_fetch(&groups[group].members, 1, __ATOMIC_SEQ_CST);
+    size    = __atomic_load_n(&groups[group].size, __ATOMIC_SEQ_CST);
+
+    if (size != 0 && members > size)
+    {
+        VPrint("***Error: node %d joined group %d, but not in its first issue (VGroupJoin)\n", node, group);
+        exit(1);
+    }
+
+    // Start a generation behind, so the node waits for its first command
+    ns[node]->group_gen = __atomic_load_n(&groups[group].gen, __ATOMIC_ACQUIRE) - 1;
+
+    __atomic_store_n(&ns[node]->group, &groups[group], __ATOMIC_RELEASE);
+    sem_post(&groups[group].join);
+
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// VGroupIssue()
+//
+// Issues a command on each node of a group, and waits once for them
+// all to complete, with the read data and interrupt state of each
+// returned in its command. Every node of the group must have a command
+// in each issue, as a node left out would stall the simulation, and this
+// is checked. A node that completes early idles until the last
+// completes. The first issue waits for the nodes to join the group.
+// -------------------------------------------------------------------------
+
+int VGroupIssue (const unsigned group, VGroupCmd_t cmds[], const unsigned num)
+{
+    pVGroupState_t pgroup;
+    psend_buf_t    psbuf;
+    rw_t*          p_rw;
+    char           issued[VP_MAX_NODES];
+    unsigned       node;
+    unsigned       size;
+    unsigned       idx;
+
+    if (group >= VP_MAX_GROUPS)
+    {
+        VPrint("***Error: out of range group %d (VGroupIssue)\n", group);
+        exit(1);
+    }
+
+    pgroup = &groups[group];
+
+    memset(issued, 0, sizeof(issued));
+
+    for (idx = 0; idx < num; idx++)
+    {
+        node = cmds[idx].node;
+
+        if (node >= VP_MAX_NODES || ns[node] == NULL || issued[node])
+        {
+            VPrint("***Error: invalid or repeated node %d in group %d issue (VGroupIssue)\n", node, group);
+            exit(1);
+        }
+
+        issued[node] = 1;
+    }
+
+    if (num == 0)
+    {
+        return 0;
+    }
+
+    pthread_once(&groups_once, VGroupInit);
+
+    // The first issue sets the group's size, which later nodes joining the
+    // group are checked against
+    size = __atomic_load_n(&pgroup->size, __ATOMIC_SEQ_CST);
+
+    if (size == 0)
+    {
+        __atomic_store_n(&pgroup->size, num, __ATOMIC_SEQ_CST);
+    }
+    else if (size != num)
+    {
+        VPrint("***Error: issue of %d nodes to group %d of %d nodes (VGroupIssue)\n", num, group, size);
+        exit(1);
+    }
+
+    for (idx = 0; idx < num; idx++)
+    {
+        node = cmds[idx].node;
+
+        // On the first issue, wait for the node to join the group. After
+        // that, all the group's nodes have joined.
+        while (__atomic_load_n(&ns[node]->group, __ATOMIC_ACQUIRE) != pgroup)
+        {
+            if (size != 0)
+            {
+                VPrint("***Error: node %d is not in group %d (VGroupIssue)\n", node, group);
+                exit(1);
+            }
+
+            sem_wait(&pgroup->join);
+        }
+    }
+
+    // With all the issue's nodes joined, any other node joined to the group
+    // is left out of the issue
+    if (__atomic_load_n(&pgroup->members, __ATOMIC_SEQ_CST) != num)
+    {
+        VPrint("***Error: issue of %d nodes to group %d of %d nodes (VGroupIssue)\n",
+               num, group, __atomic_load_n(&pgroup->members, __ATOMIC_SEQ_CST));
+        exit(1);
+    }
+
+    __atomic_store_n(&pgroup->pending, num, __ATOMIC_RELEASE);
+
+    for (idx = 0; idx < num; idx++)
+    {
+        node  = cmds[idx].node;
+        psbuf = &ns[node]->group_cmd;
+        p_rw  = (rw_t*)&psbuf->rw;
+
+        psbuf->addr     = cmds[idx].addr;
+        psbuf->data_out = cmds[idx].data;
+        psbuf->data_p   = NULL;
+        psbuf->ticks    = cmds[idx].ticks;
+
+        psbuf->rw       = V_IDLE;
+        p_rw->write     = cmds[idx].rw == V_WRITE;
+        p_rw->read      = cmds[idx].rw == V_READ;
+        p_rw->fbe       = (cmds[idx].rw == V_IDLE) ? 0 : 0xf;
+
+        debug_io_printf("VGroupIssue(): setting snd[%d] semaphore\n", node);
+        VUserPost(node);
+    }
+
+    // Wait for the last of the nodes to complete
+    debug_io_printf("VGroupIssue(): waiting for group %d\n", group);
+    sem_wait(&pgroup->done);
+
+    for (idx = 0; idx < num; idx++)
+    {
+        node = cmds[idx].node;
+
+        if (cmds[idx].rw == V_READ)
+        {
+            cmds[idx].data = ns[node]->group_rcv.data_in;
+        }
+
+        cmds[idx].interrupt = ns[node]->group_rcv.interrupt;
+    }
+
+    return 0;
+}
+
 // -------------------------------------------------------------------------
 // VRegInterrupt()
 //
@@ -401,6 +972,34 @@ void VRegIrq (const pVUserIrqCB_t func, const unsigned node)
     debug_io_printf("VRegIrq(): at node %d, registering irq callback\n", node);
 
     ns[node]->VUserIrqCB = func;
+
+    // An out-of-process user's callbacks are called from VExch(), so let
+    // the simulator know to queue IRQ events for it
+    if (ns[node]->shm != NULL)
+    {
+        ns[node]->shm->irq_cb = (func != NULL);
+    }
+}
+
+// -------------------------------------------------------------------------
+// VRegCycleModel()
+//
+// Registers a cycle model to supply the node's commands from the
+// simulation thread. Called from VUserMain<node>, which then returns
+// without making any accesses.
+// -------------------------------------------------------------------------
+
+void VRegCycleModel (const pVUserCycleModel_t model, const unsigned node)
+{
+    debug_io_printf("VRegCycleModel(): at node %d, registering cycle model\n", node);
+
+    if (ns[node]->shm != NULL)
+    {
+        VPrint("***Error: cycle model registered for out-of-process node %d (VRegCycleModel)\n", node);
+        exit(1);
+    }
+
+    ns[node]->VUserCycleModel = model;
 }
 
 // -------------------------------------------------------------------------
@@ -35,6 +35,20 @@
 
 #define MAXBURSTLEN     4096
 
+// AXI4-Stream BFM (bfm/axisbfm.v) register map, used by VStreamSend()
+// and VStreamRecv(). A frame is sent as bursts of at most
+// VSTREAM_BURST_WORDS, all but the last marked as not ending the frame.
+#define VSTREAM_TX_ADDR         0x00000000
+#define VSTREAM_TX_NOLAST       0x40000000
+#define VSTREAM_TUSER_SHIFT     8
+#define VSTREAM_TUSER_MASK      0xff
+#define VSTREAM_RX_STATUS_ADDR  0x80000000
+#define VSTREAM_RX_DATA_ADDR    0x80000004
+#define VSTREAM_RX_VALID        0x80000000
+#define VSTREAM_RX_TUSER_SHIFT  16
+#define VSTREAM_RX_LEN_MASK     0xffff
+#define VSTREAM_BURST_WORDS     (MAXBURSTLEN/2)
+
 // When compiling in windows (32- or 64-bit) ...
 #ifdef WIN32
 # include <windows.h>
@@ -63,6 +77,19 @@ typedef long      nodecast_t;
 // Pointer to pthread_create compatible function
 typedef void *(*pThreadFunc_t)(void *);
 
+// Command for one node of a group, issued by VGroupIssue(). The rw is
+// one of V_WRITE, V_READ or V_IDLE, with ticks the idle count, or
+// DELTA_CYCLE for a delta cycle access. Read data and the interrupt
+// state are returned.
+typedef struct {
+    unsigned int        node;
+    unsigned int        rw;
+    unsigned int        addr;
+    unsigned int        data;
+    int                 ticks;
+    unsigned int        interrupt;
+} VGroupCmd_t;
+
 // VUser function prototypes for API
 
 extern int  VWrite        (const unsigned      addr,  const unsigned  data, const int      delta,   const unsigned node);
@@ -71,9 +98,18 @@ extern int  VRead         (const unsigned      addr,  unsigned       *data, cons
 extern int  VBurstWrite   (const unsigned      addr,  void           *data, const unsigned wordlen, const unsigned node);
 extern int  VBurstWriteBE (const unsigned      addr,  void           *data, const unsigned wordlen, const unsigned fbe, const unsigned lbe, const unsigned node);
 extern int  VBurstRead    (const unsigned      addr,  void           *data, const unsigned wordlen, const unsigned node);
+extern int  VStreamSend   (const void         *buf,   const unsigned  len,  const unsigned tuser,   const unsigned node);
+extern int  VStreamRecv   (void               *buf,   const unsigned  maxlen, unsigned    *tuser,   const unsigned node);
 extern int  VTick         (const unsigned      ticks, const unsigned  node);
+extern int  VTickIrq      (const unsigned      ticks, const unsigned  node);
+extern uint64_t VGetCycle   (const unsigned      node);
+extern uint64_t VGetSimTime (const unsigned      node);
+extern int  VWaitUntil    (const uint64_t      cycle, const unsigned  node);
 extern void VRegUser      (const pVUserCB_t    func,  const unsigned  node);
 extern void VRegIrq       (const pVUserIrqCB_t func,  const unsigned  node);
+extern void VRegCycleModel(const pVUserCycleModel_t model, const unsigned node);
+extern int  VGroupJoin    (const unsigned      group, const unsigned  node);
+extern int  VGroupIssue   (const unsigned      group, VGroupCmd_t     cmds[], const unsigned num);
 
 // *** Deprecated in favour of VRegIrq ***/
 extern void VRegInterrupt (const int           level, const pVUserInt_t  func, const unsigned node);
@@ -81,9 +117,16 @@ extern void VRegInterrupt (const int           level, const pVUserInt_t  func, c
 // Internal function for Python interface
 extern void VRegIrqPy     (const pPyIrqCB_t    func,  const unsigned  node);
 
+// Internal functions for mailboxes and barriers in VMbox.c
+extern int  VWaitCond     (const pVUserWaitCond_t cond, void *arg, const unsigned node);
+extern int  VWaitWake     (const unsigned      waiter, const unsigned  node);
+
 // VUser function prototype for VInit in VSched.c
 extern int  VUser         (const unsigned   node);
 
+// Node state allocation for VInit in VSched.c and the shared memory client
+extern pSchedState_t VAllocState (void);
+
 #if defined(VPROC_VHDL) || defined (ICARUS) || defined (VPROC_SV)
 # define VPrint(...) printf (__VA_ARGS__)
 #else
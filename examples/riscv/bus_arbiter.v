@@ -0,0 +1,130 @@
+// ====================================================================
+//
+// Round robin bus arbiter for multiple memory mapped masters sharing
+// a single slave bus. Non-granted masters see waitrequest asserted
+// for both reads and writes. A granted master may lock the bus, to
+// make a sequence of accesses atomic, by writing 1 to the lock
+// register at LOCK_ADDR, and unlock it by writing 0.
+//
+// Copyright (c) 2024 Simon Southwell.
+//
+// This file is part of VProc.
+//
+// VProc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VProc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VProc. If not, see <http://www.gnu.org/licenses/>.
+//
+// ====================================================================
+
+module bus_arbiter
+#(parameter                      NUM_MASTERS = 4,
+                                 IDX_WIDTH   = 3,
+                                 LOCK_ADDR   = 32'hAFFFFFF0
+)
+(
+  input                          clk,
+
+  // Master ports, concatenated
+  input  [NUM_MASTERS*32-1:0]    m_address,
+  input  [NUM_MASTERS-1:0]       m_write,
+  input  [NUM_MASTERS*32-1:0]    m_writedata,
+  input  [NUM_MASTERS*4-1:0]     m_byteenable,
+  input  [NUM_MASTERS-1:0]       m_read,
+  output [31:0]                  m_readdata,
+  output [NUM_MASTERS-1:0]       m_waitrequest,
+
+  // Slave port
+  output [31:0]                  s_address,
+  output                         s_write,
+  output [31:0]                  s_writedata,
+  output  [3:0]                  s_byteenable,
+  output                         s_read,
+  input  [31:0]                  s_readdata,
+  input                          s_waitrequest,
+
+  // Currently granted master
+  output reg [IDX_WIDTH-1:0]     owner
+);
+
+reg                              locked;
+reg  [IDX_WIDTH-1:0]             next_owner;
+reg                              found;
+integer                          idx;
+
+wire [NUM_MASTERS-1:0]           req       = m_read | m_write;
+wire                             owner_req = req[owner];
+wire                             done      = owner_req & ~s_waitrequest;
+wire                             lock_wr   = s_write & ~s_waitrequest && s_address == LOCK_ADDR;
+wire                             lock_next = lock_wr ? s_writedata[0] : locked;
+
+initial
+begin
+  owner                          = 0;
+  locked                         = 1'b0;
+end
+
+// -----------------------------------------------
+// Route the granted master to the slave port
+// -----------------------------------------------
+
+assign s_address                 = m_address   [owner*32 +: 32];
+assign s_writedata               = m_writedata [owner*32 +: 32];
+assign s_byteenable              = m_byteenable[owner*4  +: 4];
+assign s_write                   = m_write[owner];
+assign s_read                    = m_read[owner];
+
+assign m_readdata                = s_readdata;
+
+genvar m;
+generate
+  for (m = 0; m < NUM_MASTERS; m = m + 1)
+  begin : wait_gen
+    assign m_waitrequest[m]      = (owner == m) ? s_waitrequest : 1'b1;
+  end
+endgenerate
+
+// -----------------------------------------------
+// Select the next requesting master after the
+// current owner, wrapping back to the owner
+// -----------------------------------------------
+
+always @(*)
+begin
+  next_owner                     = owner;
+  found                          = 1'b0;
+
+  for (idx = 1; idx <= NUM_MASTERS; idx = idx + 1)
+  begin
+    if (!found && req[(owner + idx) % NUM_MASTERS])
+    begin
+      next_owner                 = (owner + idx) % NUM_MASTERS;
+      found                      = 1'b1;
+    end
+  end
+end
+
+// -----------------------------------------------
+// Re-arbitrate when the owner's access completes,
+// or it has nothing to do, unless locked
+// -----------------------------------------------
+
+always @(posedge clk)
+begin
+  locked                         <= lock_next;
+
+  if (!lock_next && (done || !owner_req))
+  begin
+    owner                        <= next_owner;
+  end
+end
+
+endmodule
@@ -71,7 +71,8 @@ assign      dread        = read_int && (instr_access == 1'b0 || USE_HARVARD == 0
 assign      rd_data      = dread ? dreaddata : ireaddata;
 assign      RDAck        = ((dread & ~dwaitrequest) == 1'b1 || (iread & ~iwaitrequest) == 1'b1) ? 1'b1 : 1'b0;
 
-  VProc   #(.DISABLE_DELTA           (DISABLE_DELTA)
+  VProc   #(.DISABLE_DELTA           (DISABLE_DELTA),
+            .BURST_ADDR_INCR         (4)
            ) vp
            (
             .Clk                     (clk),
@@ -81,7 +82,7 @@ assign      RDAck        = ((dread & ~dwaitrequest) == 1'b1 || (iread & ~iwaitre
             .RD                      (read_int),
             .DataOut                 (dwritedata),
             .DataIn                  (rd_data),
-            .WRAck                   (dwrite),
+            .WRAck                   (dwrite & ~dwaitrequest),
             .RDAck                   (RDAck),
             .Interrupt               (irq),
             .Update                  (Update),
@@ -28,29 +28,121 @@ extern "C" {
 
     extern int getopt(int nargc, char** nargv, const char* ostr);
     extern char* optarg;
+    extern int   optind;
 }
 #endif
 
 #include "VUserMain0.h"
 #include "mem_vproc_api.h"
-#include "rv32.h"
+#include "rv32_vproc.h"
 #include "rv32_cpu_gdb.h"
-
-// I'm node 0
-int node = 0;
-
-static uint32_t  irq                  = 0;
+#include "rv32trace.h"
+#include "rv32prof.h"
+#include "elf_load.h"
+#include "rv32snap.h"
+
+// Each hart runs on its own VProc node, in its own thread, and so the
+// per-hart state below is thread local. The exception is the interrupt
+// state, which is updated from the simulator thread, and is indexed by
+// node number.
+
+// Node number of the hart running in this thread
+thread_local int node = 0;
+
+// Interrupt state, updated from the VProc interrupt callback and
+// read by the ISS interrupt callback
+static std::atomic<uint32_t> irq          [MAX_HARTS];
+static std::atomic<bool>     irq_pending  [MAX_HARTS];
+
+// Pointer to the ISS's wakeup time for its interrupt callback, saved
+// on each call. Only this hart's thread updates it, bringing the next
+// call forward when it finds an interrupt pending (see ext_mem_access())
+static thread_local rv32i_time_t* iss_wakeup_p = NULL;
+static thread_local uint64_t iss_int_polls  = 0;
+static thread_local uint64_t iss_int_events = 0;
 
 static const int strbufsize = 256;
-static char      argstr[strbufsize];
-static rv32*     pCpu;
+static thread_local char      argstr[strbufsize];
+
+// Parsing the configuration uses the global state of strtok() and
+// getopt(), and harts may run concurrently, so they parse it in turn
+static std::mutex             parse_args_mutex;
+static thread_local rv32_vproc* pCpu;
+
+static thread_local double    tv_diff_usec;
+
+// Atomic instruction bus locking state. When enabled, the bus is locked
+// from the fetch of an AMO or LR instruction until the fetch of the
+// instruction following the AMO or SC (or AMO_LR_HOLD_INSTRS instructions
+// after an LR without an SC), so that atomics are coherent between harts
+static thread_local bool      amo_locking          = false;
+static thread_local bool      amo_locked           = false;
+static thread_local uint32_t  amo_hold             = 0;
+static thread_local uint64_t  amo_locks            = 0;
+
+// Binary instruction trace state. A record is started at the fetch of an
+// instruction, and completed at the fetch of the next.
+static thread_local bool            trace_en      = false;
+static thread_local bool            trace_pending = false;
+static thread_local rv32trace_rec_s trace_rec;
+
+// Guest profiling enable
+static thread_local bool            prof_en       = false;
+
+// Snapshot state. A snapshot is saved at the fetch of the instruction at
+// the snapshot PC, or once the given number of instructions has retired.
+static thread_local bool            snap_pending  = false;
+static thread_local const char*     snap_fname    = NULL;
+static thread_local uint64_t        snap_instrs   = 0;
+static thread_local uint32_t        snap_pc       = 0;
+static thread_local bool            snap_at_pc    = false;
+
+#ifdef USE_INTERNAL_MEMORY
+static const rv32snap_region_s      snap_regions[] = {{0, INT_MEM_TOP}};
+#else
+static const rv32snap_region_s      snap_regions[] = {{SNAP_IMEM_ADDR, SNAP_MEM_BYTES}, {SNAP_DMEM_ADDR, SNAP_MEM_BYTES}};
+#endif
 
-static double    tv_diff_usec;
+// HDL timer registers, written back on restore to resynchronise the timer
+static const uint32_t               snap_regs[]    = {rv32i_consts::RV32I_RTCLOCK_ADDRESS,     rv32i_consts::RV32I_RTCLOCK_ADDRESS + 4,
+                                                      rv32i_consts::RV32I_RTCLOCK_CMP_ADDRESS, rv32i_consts::RV32I_RTCLOCK_CMP_ADDRESS + 4};
+
+// Quantum keeper state. When the ISS executes without going to the bus
+// (internal memory, or instruction cache hits) it runs ahead of simulation
+// time, and is synchronised at least every quantum cycles, at the next
+// known timer interrupt deadline, and before any other bus access.
+static thread_local bool      qk_decoupled         = false;
+static thread_local uint32_t  qk_quantum           = DEFAULT_QUANTUM;
+static thread_local uint32_t  qk_cycles_per_tick   = DEFAULT_CLK_FREQ_MHZ;
+static thread_local uint64_t  qk_last_sync         = 0;
+static thread_local uint64_t  qk_deadline          = UINT64_MAX;
+static thread_local uint64_t  qk_syncs[QK_NUM_SYNC_REASONS];
+static thread_local uint64_t  qk_decoupled_cycles  = 0;
+static thread_local uint64_t  qk_max_lag           = 0;
+
+// Last seen values of the memory mapped timer registers, and the cycle at
+// which mtime was read, used to calculate the next timer deadline
+static thread_local uint64_t  timer_mtime          = 0;
+static thread_local uint64_t  timer_mtime_cycles   = 0;
+static thread_local uint64_t  timer_mtimecmp       = UINT64_MAX;
+
+// Local timer state. With the external timer, reads of mtime are served
+// from a local copy advanced by the ISS's cycle count, offset from the HDL
+// timer's value when last synchronised, and mtimecmp reads from its last
+// written value. The local copy is resynchronised every quantum cycles,
+// and after any write to the timer.
+static thread_local bool      ltimer_en            = false;
+static thread_local bool      ltimer_valid         = false;
+static thread_local uint64_t  ltimer_base_mtime    = 0;
+static thread_local uint64_t  ltimer_base_cycles   = 0;
+static thread_local uint64_t  ltimer_last_mtime    = 0;
+static thread_local uint64_t  ltimer_reads         = 0;
+static thread_local uint64_t  ltimer_syncs         = 0;
 
 #if (!(defined _WIN32) && !(defined _WIN64))
-static struct timeval tv_start, tv_stop;
+static thread_local struct timeval tv_start, tv_stop;
 #else
-LARGE_INTEGER freq, start, stop;
+static thread_local LARGE_INTEGER freq, start, stop;
 #endif
 
 // ---------------------------------------------
@@ -102,48 +194,471 @@ static void post_run_actions()
 #endif
 }
 
+// ---------------------------------------------
+// Quantum keeper synchronisation, bringing
+// simulation time up to the ISS's time
+// ---------------------------------------------
+
+static inline void qk_sync(const uint64_t curr_cycles, const int reason)
+{
+    uint64_t lag = curr_cycles - qk_last_sync;
+
+    if (lag)
+    {
+        VTick((uint32_t)lag, node);
+
+        qk_decoupled_cycles += lag;
+        qk_max_lag           = (lag > qk_max_lag) ? lag : qk_max_lag;
+    }
+
+    qk_syncs[reason]++;
+    qk_last_sync = curr_cycles;
+}
+
+// ---------------------------------------------
+// Snoop accesses to the memory mapped timer to
+// track the cycle at which the next timer
+// interrupt is due
+// ---------------------------------------------
+
+static void qk_timer_snoop(const uint32_t addr, const uint32_t data, const bool wr, const uint64_t curr_cycles)
+{
+    switch (addr & ~0x3)
+    {
+    case rv32i_consts::RV32I_RTCLOCK_ADDRESS:
+        timer_mtime        = (timer_mtime & 0xffffffff00000000ULL) | data;
+        timer_mtime_cycles = curr_cycles;
+        break;
+    case rv32i_consts::RV32I_RTCLOCK_ADDRESS + 4:
+        timer_mtime        = (timer_mtime & 0x00000000ffffffffULL) | ((uint64_t)data << 32);
+        timer_mtime_cycles = curr_cycles;
+        break;
+    case rv32i_consts::RV32I_RTCLOCK_CMP_ADDRESS:
+        timer_mtimecmp     = wr ? (timer_mtimecmp & 0xffffffff00000000ULL) | data : timer_mtimecmp;
+        break;
+    case rv32i_consts::RV32I_RTCLOCK_CMP_ADDRESS + 4:
+        timer_mtimecmp     = wr ? (timer_mtimecmp & 0x00000000ffffffffULL) | ((uint64_t)data << 32) : timer_mtimecmp;
+        break;
+    default:
+        return;
+    }
+
+    // The timer interrupts when mtime is greater than mtimecmp
+    if (timer_mtimecmp == UINT64_MAX)
+    {
+        qk_deadline = UINT64_MAX;
+    }
+    else if (timer_mtimecmp < timer_mtime)
+    {
+        qk_deadline = curr_cycles;
+    }
+    else
+    {
+        qk_deadline = timer_mtime_cycles + (timer_mtimecmp - timer_mtime + 1) * qk_cycles_per_tick;
+    }
+}
+
+// ---------------------------------------------
+// Display quantum keeper statistics
+// ---------------------------------------------
+
+static void qk_print_stats(void)
+{
+    if (qk_decoupled)
+    {
+        uint64_t syncs = qk_syncs[QK_SYNC_QUANTUM] + qk_syncs[QK_SYNC_DEADLINE] + qk_syncs[QK_SYNC_ACCESS];
+
+        VPrint("Quantum keeper (quantum %d cycles): %llu syncs (%llu quantum, %llu deadline, %llu access)\n",
+               qk_quantum, (unsigned long long)syncs,
+               (unsigned long long)qk_syncs[QK_SYNC_QUANTUM], (unsigned long long)qk_syncs[QK_SYNC_DEADLINE],
+               (unsigned long long)qk_syncs[QK_SYNC_ACCESS]);
+        VPrint("  %llu cycles decoupled, mean lag %.1f cycles, max lag %llu cycles\n",
+               (unsigned long long)qk_decoupled_cycles,
+               syncs ? (double)qk_decoupled_cycles / (double)syncs : 0.0,
+               (unsigned long long)qk_max_lag);
+    }
+}
+
+// ---------------------------------------------
+// Synchronise the local timer with the HDL
+// timer
+// ---------------------------------------------
+
+static void ltimer_sync(const uint64_t curr_cycles)
+{
+    uint32_t lo, hi;
+
+    // Bring the HDL timer up to the ISS's time first
+    if (qk_decoupled)
+    {
+        qk_sync(curr_cycles, QK_SYNC_ACCESS);
+    }
+
+    // Read the high word either side of the low word, in case of a carry
+    do
+    {
+        hi = read_word(rv32i_consts::RV32I_RTCLOCK_ADDRESS + 4);
+        lo = read_word(rv32i_consts::RV32I_RTCLOCK_ADDRESS);
+    }
+    while (hi != read_word(rv32i_consts::RV32I_RTCLOCK_ADDRESS + 4));
+
+    qk_timer_snoop(rv32i_consts::RV32I_RTCLOCK_ADDRESS,     lo, false, curr_cycles);
+    qk_timer_snoop(rv32i_consts::RV32I_RTCLOCK_ADDRESS + 4, hi, false, curr_cycles);
+
+    // Time must not go backwards for the program, if the HDL timer is behind
+    ltimer_base_mtime  = ((uint64_t)hi << 32) | lo;
+    ltimer_base_mtime  = ltimer_base_mtime < ltimer_last_mtime ? ltimer_last_mtime : ltimer_base_mtime;
+    ltimer_base_cycles = curr_cycles;
+    ltimer_valid       = true;
+    ltimer_syncs++;
+}
+
+// ---------------------------------------------
+// Serve reads of the timer locally. Returns
+// true if the access was processed.
+// ---------------------------------------------
+
+static bool ltimer_access(const uint32_t addr, uint32_t& data, const bool wr, const uint64_t curr_cycles)
+{
+    if (wr)
+    {
+        return false;
+    }
+
+    switch (addr & ~0x3)
+    {
+    case rv32i_consts::RV32I_RTCLOCK_ADDRESS:
+    case rv32i_consts::RV32I_RTCLOCK_ADDRESS + 4:
+        if (!ltimer_valid || (curr_cycles - ltimer_base_cycles) >= qk_quantum)
+        {
+            ltimer_sync(curr_cycles);
+        }
+
+        ltimer_last_mtime = ltimer_base_mtime + (curr_cycles - ltimer_base_cycles) / qk_cycles_per_tick;
+        data              = (addr & 0x4) ? (uint32_t)(ltimer_last_mtime >> 32) : (uint32_t)ltimer_last_mtime;
+        ltimer_reads++;
+        return true;
+
+    case rv32i_consts::RV32I_RTCLOCK_CMP_ADDRESS:
+    case rv32i_consts::RV32I_RTCLOCK_CMP_ADDRESS + 4:
+        data = (addr & 0x4) ? (uint32_t)(timer_mtimecmp >> 32) : (uint32_t)timer_mtimecmp;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+// ---------------------------------------------
+// Lock or unlock the bus for atomic instructions
+// on the fetch of each new instruction
+// ---------------------------------------------
+
+static void amo_fetch(const uint32_t addr, const uint32_t data, const uint64_t curr_cycles)
+{
+    uint32_t instr  = (addr & 0x2) ? (data >> 16) : data;
+    bool     is_amo = (instr & AMO_OPCODE_MASK) == AMO_OPCODE;
+
+    if (is_amo)
+    {
+        if (!amo_locked)
+        {
+            if (qk_decoupled)
+            {
+                qk_sync(curr_cycles, QK_SYNC_ACCESS);
+            }
+
+            write_word(BUS_LOCK_ADDR, 1);
+
+            amo_locked = true;
+            amo_locks++;
+        }
+
+        // An LR holds the lock for the SC that is expected to follow
+        amo_hold = ((instr >> AMO_FUNCT5_SHIFT) == AMO_FUNCT5_LR) ? AMO_LR_HOLD_INSTRS : 0;
+    }
+    else if (amo_locked)
+    {
+        if (amo_hold)
+        {
+            amo_hold--;
+        }
+        else
+        {
+            if (qk_decoupled)
+            {
+                qk_sync(curr_cycles, QK_SYNC_ACCESS);
+            }
+
+            write_word(BUS_LOCK_ADDR, 0);
+
+            amo_locked = false;
+        }
+    }
+}
+
+// ---------------------------------------------
+// Complete any pending trace record for the
+// last instruction, and start a new one
+// ---------------------------------------------
+
+static inline void trace_fetch(const uint32_t pc, const uint64_t curr_cycles)
+{
+    if (trace_pending)
+    {
+        trace_rec.instr  = pCpu->curr_instr_val();
+        trace_rec.flags  = pCpu->curr_instr_compressed() ? RV32TRACE_FLAG_COMPRESSED : 0;
+        trace_rec.rd_val = pCpu->regi_val((trace_rec.instr >> 7) & 0x1f);
+        trace_rec.cycle  = curr_cycles;
+
+        rv32trace_write(trace_rec);
+    }
+
+    trace_rec.pc  = pc;
+    trace_pending = true;
+}
+
+// ---------------------------------------------
+// Snapshot memory and HDL register access
+// ---------------------------------------------
+
+static int snap_mem_access(const uint32_t addr, uint32_t* data, const uint32_t words, const bool write)
+{
+#ifdef USE_INTERNAL_MEMORY
+    if (addr < INT_MEM_TOP)
+    {
+        bool fault = false;
+
+        for (uint32_t idx = 0; idx < words && !fault; idx++)
+        {
+            if (write)
+            {
+                pCpu->write_mem(addr + idx * 4, data[idx], MEM_WR_ACCESS_WORD, fault);
+            }
+            else
+            {
+                data[idx] = pCpu->read_mem(addr + idx * 4, MEM_RD_ACCESS_WORD, fault);
+            }
+        }
+
+        return fault ? 1 : 0;
+    }
+#endif
+
+    if (write)
+    {
+        write_block(addr, data, words);
+    }
+    else
+    {
+        read_block(addr, data, words);
+    }
+
+    return 0;
+}
+
+// ---------------------------------------------
+// Save a snapshot at the fetch of the
+// instruction at pc
+// ---------------------------------------------
+
+static void take_snapshot(const uint32_t pc, const uint64_t curr_cycles)
+{
+    // Bring the HDL up to the ISS's time, so the timer state is current
+    if (qk_decoupled)
+    {
+        qk_sync(curr_cycles, QK_SYNC_ACCESS);
+    }
+
+    if (!rv32snap_save(snap_fname, pCpu, node, snap_regions, sizeof(snap_regions)/sizeof(snap_regions[0]),
+                       snap_regs, sizeof(snap_regs)/sizeof(snap_regs[0]), snap_mem_access))
+    {
+        VPrint("Snapshot saved to %s at PC 0x%08x after %llu instructions\n", snap_fname, pc,
+               (unsigned long long)pCpu->instret_val());
+    }
+
+    snap_pending = false;
+}
+
+#ifdef USE_INTERNAL_MEMORY
+// ---------------------------------------------
+// Fast load backdoor for the ISS's internal
+// memory
+// ---------------------------------------------
+
+static int int_mem_backdoor(const uint32_t addr, const uint8_t* data, const uint32_t len)
+{
+    bool fault = false;
+
+    if ((uint64_t)addr + len > INT_MEM_TOP)
+    {
+        return 1;
+    }
+
+    for (uint32_t idx = 0; idx < len && !fault; idx++)
+    {
+        pCpu->write_mem(addr + idx, data[idx], MEM_WR_ACCESS_BYTE, fault);
+    }
+
+    return fault ? 1 : 0;
+}
+#endif
+
+// ---------------------------------------------
+// Restore state from a snapshot, continuing
+// from its PC and cycle count. Returns non-zero
+// on error.
+// ---------------------------------------------
+
+static int restore_snapshot(rv32i_cfg_s &cfg, const char* fname)
+{
+    if (rv32snap_restore(fname, pCpu, snap_regions, sizeof(snap_regions)/sizeof(snap_regions[0]), snap_mem_access))
+    {
+        return 1;
+    }
+
+    // Start from the restored PC, and don't count the restored cycles as lag
+    cfg.update_rst_vec = false;
+    qk_last_sync       = pCpu->clk_cycles();
+
+    // Pick up the restored timer compare value
+    timer_mtimecmp     = ((uint64_t)read_word(rv32i_consts::RV32I_RTCLOCK_CMP_ADDRESS + 4) << 32) |
+                                    read_word(rv32i_consts::RV32I_RTCLOCK_CMP_ADDRESS);
+
+    VPrint("Restored snapshot %s at PC 0x%08x, cycle %llu\n", fname, pCpu->pc_val(), (unsigned long long)pCpu->clk_cycles());
+
+    return 0;
+}
+
+// ---------------------------------------------
+// Load the executable, either by the ISS or,
+// if fast loading, with bursts (or backdoor),
+// starting at the ELF entry point unless a
+// start address was specified, and then
+// restore any snapshot. Returns non-zero on
+// error.
+// ---------------------------------------------
+
+static int load_executable(rv32i_cfg_s &cfg, const vusermain_cfg_s &ucfg)
+{
+    uint32_t entry;
+
+    if (!ucfg.fast_load)
+    {
+        if (pCpu->read_elf(cfg.exec_fname))
+        {
+            return 1;
+        }
+    }
+    else
+    {
+#ifdef USE_INTERNAL_MEMORY
+        elf_load_register_backdoor(int_mem_backdoor);
+#endif
+
+        if (elf_load(cfg.exec_fname, entry))
+        {
+            return 1;
+        }
+
+        if (!cfg.update_rst_vec)
+        {
+            cfg.update_rst_vec = true;
+            cfg.new_rst_vec    = entry;
+        }
+    }
+
+    return ucfg.restore_fname != NULL ? restore_snapshot(cfg, ucfg.restore_fname) : 0;
+}
+
 // ---------------------------------------------
 // External memory map access
 // callback function
 // ---------------------------------------------
 
-int ext_mem_access(const uint32_t addr, uint32_t& data, const int type, const rv32i_time_t time)
+static int ext_mem_access_(const uint32_t addr, uint32_t& data, const int type)
 {
     int processed = 1;
 
-#ifdef USE_INTERNAL_MEMORY
+    uint64_t curr_cycles = pCpu->clk_cycles();
+    bool     ifetch      = (type & MEM_NOT_DBG_MASK) == MEM_RD_ACCESS_INSTR;
+    bool     local       = ifetch;
 
-# ifndef INT_MEM_TOP
-# define INT_MEM_TOP 0x00100000
-# endif
+#ifdef USE_INTERNAL_MEMORY
+    local               |= addr < INT_MEM_TOP;
+#endif
 
-    uint64_t curr_cycles;
-    uint32_t cycle_diff;
-    static uint64_t last_cycles = 0;
+    // Timer reads are local when using the local timer
+    if (ltimer_en && !(type & MEM_DBG_MASK) && !ifetch &&
+        ltimer_access(addr, data, (type & MEM_NOT_DBG_MASK) <= MEM_WR_ACCESS_INSTR, curr_cycles))
+    {
+        return processed;
+    }
 
-    curr_cycles = pCpu->clk_cycles();
-    cycle_diff = (uint32_t)(curr_cycles - last_cycles);
+    if (qk_decoupled && !(type & MEM_DBG_MASK))
+    {
+        // Local accesses only synchronise when the quantum has expired or a timer
+        // deadline has been reached. Any other access synchronises first.
+        if (!local)
+        {
+            qk_sync(curr_cycles, QK_SYNC_ACCESS);
+        }
+        else if ((curr_cycles - qk_last_sync) >= qk_quantum)
+        {
+            qk_sync(curr_cycles, QK_SYNC_QUANTUM);
+        }
+        else if (curr_cycles >= qk_deadline)
+        {
+            qk_sync(curr_cycles, QK_SYNC_DEADLINE);
+            qk_deadline = UINT64_MAX;
+        }
+    }
 
-    // Accessing memory
-    if (addr < INT_MEM_TOP)
+    if ((trace_en || prof_en) && ifetch && !(type & MEM_DBG_MASK) && addr == pCpu->pc_val())
     {
-        if ((type & MEM_NOT_DBG_MASK) == MEM_RD_ACCESS_INSTR && cycle_diff >= 1000)
+        if (trace_en)
         {
-            VTick(cycle_diff, node);
-            last_cycles = curr_cycles;
+            trace_fetch(addr, curr_cycles);
         }
 
-        return RV32I_EXT_MEM_NOT_PROCESSED;
+        if (prof_en)
+        {
+            rv32prof_fetch(addr, curr_cycles, pCpu->curr_instr_val(), pCpu->curr_instr_compressed());
+        }
     }
-    // Accessing peripherals
-    else
+
+    if (snap_pending && ifetch && !(type & MEM_DBG_MASK) && addr == pCpu->pc_val() &&
+        (snap_at_pc ? addr == snap_pc : pCpu->instret_val() >= snap_instrs))
     {
-        VTick(cycle_diff, node);
-        last_cycles = curr_cycles;
+        take_snapshot(addr, curr_cycles);
     }
 
+#ifdef USE_INTERNAL_MEMORY
+    if (addr < INT_MEM_TOP)
+    {
+        return RV32I_EXT_MEM_NOT_PROCESSED;
+    }
 #endif
 
+    // Debugger byte accesses to memory are coalesced into bursts. Any other
+    // access first synchronises them with memory.
+    if ((type & MEM_DBG_MASK) && addr < DBG_BURST_TOP &&
+        ((type & MEM_NOT_DBG_MASK) == MEM_RD_ACCESS_BYTE || (type & MEM_NOT_DBG_MASK) == MEM_WR_ACCESS_BYTE))
+    {
+        if ((type & MEM_NOT_DBG_MASK) == MEM_RD_ACCESS_BYTE)
+        {
+            data = dbg_read_byte(addr);
+        }
+        else
+        {
+            dbg_write_byte(addr, data);
+        }
+
+        return processed;
+    }
+
+    dbg_sync();
+
     switch (type & MEM_NOT_DBG_MASK)
     {
     case MEM_RD_ACCESS_BYTE:
@@ -173,6 +688,42 @@ int ext_mem_access(const uint32_t addr, uint32_t& data, const int type, const rv
         break;
     }
 
+    // Only the fetch at the PC is the start of a new instruction (and not the
+    // second half of a misaligned 32 bit instruction)
+    if (amo_locking && ifetch && !(type & MEM_DBG_MASK) && addr == pCpu->pc_val())
+    {
+        amo_fetch(addr, data, curr_cycles);
+    }
+
+    if ((qk_decoupled || ltimer_en) && !ifetch)
+    {
+        bool wr = (type & MEM_NOT_DBG_MASK) <= MEM_WR_ACCESS_INSTR;
+
+        qk_timer_snoop(addr, data, wr, curr_cycles);
+
+        // Any write to the timer resynchronises the local timer at the next read
+        if (wr && (addr & ~0xf) == rv32i_consts::RV32I_RTCLOCK_ADDRESS)
+        {
+            ltimer_valid = false;
+        }
+    }
+
+    return processed;
+}
+
+// The VProc interrupt callback can only run while this hart's thread is
+// blocked in a VProc call, and all of those are made from an external
+// memory access. So, on return, a pending interrupt brings the ISS's
+// next call to its interrupt callback forward to the current cycle.
+int ext_mem_access(const uint32_t addr, uint32_t& data, const int type, const rv32i_time_t time)
+{
+    int processed = ext_mem_access_(addr, data, type);
+
+    if (iss_wakeup_p != NULL && irq_pending[node].load(std::memory_order_acquire))
+    {
+        *iss_wakeup_p = (rv32i_time_t)pCpu->clk_cycles();
+    }
+
     return processed;
 }
 
@@ -180,7 +731,7 @@ int ext_mem_access(const uint32_t addr, uint32_t& data, const int type, const rv
 // Parse configuration file arguments
 // ---------------------------------------------
 
-int parseArgs(int argcIn, char** argvIn, rv32i_cfg_s &cfg, const int node)
+int parseArgs(int argcIn, char** argvIn, rv32i_cfg_s &cfg, vusermain_cfg_s &ucfg, const int node)
 {
     int    error = 0;
     int    c;
@@ -194,6 +745,8 @@ int parseArgs(int argcIn, char** argvIn, rv32i_cfg_s &cfg, const int node)
 
     int returnVal  = 0;
 
+    std::lock_guard<std::mutex> lock(parse_args_mutex);
+
     if (argcIn > 1)
     {
         argc = argcIn;
@@ -243,7 +796,10 @@ int parseArgs(int argcIn, char** argvIn, rv32i_cfg_s &cfg, const int node)
     // Parse the command line arguments and/or configuration file
     // Process the command line options *only* for the INI filename, as we
     // want the command line options to override the INI options
-    while ((c = getopt(argc, argv, "t:n:bA:rdHTeED:gp:S:Cah")) != EOF)
+    // Each hart parses its own arguments, so restart the scan
+    optind = 1;
+
+    while ((c = getopt(argc, argv, "t:n:bA:rdHTeED:gp:S:Cai:w:q:F:mx:X:P:lL:s:I:Y:Mh")) != EOF)
     {
         switch (c)
         {
@@ -301,9 +857,52 @@ int parseArgs(int argcIn, char** argvIn, rv32i_cfg_s &cfg, const int node)
         case 'a':
             cfg.abi_en = true;
             break;
+        case 'i':
+            ucfg.icache_lines = strtol(optarg, NULL, 0);
+            break;
+        case 'w':
+            ucfg.icache_line_words = strtol(optarg, NULL, 0);
+            break;
+        case 'q':
+            ucfg.quantum = strtol(optarg, NULL, 0);
+            break;
+        case 'F':
+            ucfg.clk_freq_mhz = strtol(optarg, NULL, 0);
+            break;
+        case 'm':
+            ucfg.lock_atomics = true;
+            break;
+        case 'M':
+            ucfg.local_timer = true;
+            break;
+        case 'x':
+            ucfg.trace_fname = optarg;
+            break;
+        case 'X':
+            ucfg.trace_ring = strtol(optarg, NULL, 0);
+            break;
+        case 'P':
+            ucfg.prof_period = strtol(optarg, NULL, 0);
+            break;
+        case 'l':
+            ucfg.fast_load = true;
+            break;
+        case 'L':
+            ucfg.restore_fname = optarg;
+            break;
+        case 's':
+            ucfg.snap_fname = optarg;
+            break;
+        case 'I':
+            ucfg.snap_instrs = strtoull(optarg, NULL, 0);
+            break;
+        case 'Y':
+            ucfg.snap_pc    = strtoul(optarg, NULL, 0);
+            ucfg.snap_at_pc = true;
+            break;
         case 'h':
         default:
-            fprintf(stderr, "Usage: %s -t <test executable> [-hHebdrg][-n <num instructions>]\n      [-S <start addr>][-A <brk addr>][-D <debug o/p filename>][-p <port num>]\n", argv[0]);
+            fprintf(stderr, "Usage: %s -t <test executable> [-hHebdrg][-n <num instructions>]\n      [-S <start addr>][-A <brk addr>][-D <debug o/p filename>][-p <port num>]\n      [-i <icache lines>][-w <icache line words>][-q <quantum>][-F <clk MHz>][-m][-M]\n      [-x <trace file>][-X <trace ring records>][-P <profile period>][-l]\n      [-L <snapshot>][-s <snapshot> [-I <instrs>|-Y <addr>]]\n", argv[0]);
             fprintf(stderr, "   -t specify test executable (default test.exe)\n");
             fprintf(stderr, "   -n specify number of instructions to run (default 0, i.e. run until unimp)\n");
             fprintf(stderr, "   -d Enable disassemble mode (default off)\n");
@@ -320,6 +919,20 @@ int parseArgs(int argcIn, char** argvIn, rv32i_cfg_s &cfg, const int node)
             fprintf(stderr, "   -g Enable remote gdb mode (default disabled)\n");
             fprintf(stderr, "   -p Specify remote GDB port number (default 49152)\n");
             fprintf(stderr, "   -S Specify start address (default 0)\n");
+            fprintf(stderr, "   -i Specify number of instruction cache lines (default 0, i.e. no cache)\n");
+            fprintf(stderr, "   -w Specify instruction cache line length in words (default 8)\n");
+            fprintf(stderr, "   -q Specify max cycles ISS runs ahead of simulation when decoupled (default 1000)\n");
+            fprintf(stderr, "   -F Specify HDL clock frequency in MHz, for timer deadlines (default 100)\n");
+            fprintf(stderr, "   -m Lock bus for atomic instructions, for multi-hart (default off)\n");
+            fprintf(stderr, "   -M Serve external timer reads locally, synchronised every quantum (default off)\n");
+            fprintf(stderr, "   -x Specify binary instruction trace file (default no trace)\n");
+            fprintf(stderr, "   -X Specify number of trace records to keep in ring (default 0, i.e. all)\n");
+            fprintf(stderr, "   -P Sample PC for profile every given number of cycles (default 0, i.e. off)\n");
+            fprintf(stderr, "   -l Fast load executable with bursts, starting at ELF entry point (default off)\n");
+            fprintf(stderr, "   -L Restore state from snapshot file after loading (default off)\n");
+            fprintf(stderr, "   -s Specify file to save snapshot to (default no snapshot)\n");
+            fprintf(stderr, "   -I Save snapshot once given number of instructions retired (default 0)\n");
+            fprintf(stderr, "   -Y Save snapshot at fetch of instruction at given address (default off)\n");
             fprintf(stderr, "   -h display this help message\n");
             error = 1;
             break;
@@ -338,30 +951,66 @@ int parseArgs(int argcIn, char** argvIn, rv32i_cfg_s &cfg, const int node)
 // variables. Also, it is not valid to make further VProc calls from
 // this CB, but updating state here should instigate required functionality
 // in the main program flow.
-int vproc_irq_callback(int val)
+//
+// The callback has no node argument, and is called from the simulator
+// thread, so a version is instantiated for each hart.
+template<int HART> int vproc_irq_callback(int val)
 {
-    irq = val;
+    // Publish the new state. The ISS thread picks it up when its VProc
+    // call returns (see ext_mem_access()).
+    irq[HART].store((uint32_t)val, std::memory_order_relaxed);
+    irq_pending[HART].store(true, std::memory_order_release);
 
     return 0;
 }
 
-// The ISS interrupt callback will return an interrupt when irq
-// is non-zero, else it returns 0. The wakeup time in this model is always the next
-// cycle.
+static const pVUserIrqCB_t vproc_irq_callbacks[MAX_HARTS] =
+{
+    vproc_irq_callback<0>, vproc_irq_callback<1>, vproc_irq_callback<2>, vproc_irq_callback<3>,
+    vproc_irq_callback<4>, vproc_irq_callback<5>, vproc_irq_callback<6>, vproc_irq_callback<7>
+};
+
+// The ISS interrupt callback will return an interrupt when irq is non-zero,
+// else it returns 0. The time passed in is the ISS's cycle count (as returned
+// by clk_cycles()), the same units as the quantum keeper's deadline. Rather
+// than be called every cycle, the wakeup time is set to the next known event:
+// the timer deadline when decoupled (at which point the quantum keeper
+// synchronises and the interrupt will have been raised), bounded by the
+// quantum so that the callback is never switched off altogether. A change
+// in interrupt state brings the wakeup forward from ext_mem_access().
 uint32_t iss_int_callback(const rv32i_time_t time, rv32i_time_t *wakeup_time)
 {
-    *wakeup_time = time + 1;
+    rv32i_time_t next = time + (rv32i_time_t)qk_quantum;
+
+    iss_wakeup_p = wakeup_time;
+    iss_int_polls++;
+
+    if (irq_pending[node].exchange(false, std::memory_order_acquire))
+    {
+        iss_int_events++;
+    }
 
-    return irq;
+    if (qk_decoupled && qk_deadline != UINT64_MAX && (rv32i_time_t)qk_deadline > time && (rv32i_time_t)qk_deadline < next)
+    {
+        next = (rv32i_time_t)qk_deadline;
+    }
+
+    *wakeup_time = next;
+
+    return irq[node].load(std::memory_order_relaxed);
 }
 
 // ---------------------------------------------
-// Main entry point for node 0 VPRoc
+// Main program for a hart, run from the
+// VUserMain entry point of its node
 // ---------------------------------------------
 
-extern "C" void VUserMain0()
+static void hart_main(const int hart_node)
 {
-    rv32i_cfg_s   cfg;
+    rv32i_cfg_s     cfg;
+    vusermain_cfg_s ucfg;
+
+    node = hart_node;
 
     VPrint("\n*****************************\n");
     VPrint(  "*   Wyvern Semiconductors   *\n");
@@ -374,14 +1023,34 @@ extern "C" void VUserMain0()
     // Parse arguments. As no argc and argv, pass in these as null, and it will look for
     // vusermain.cfg, which should have a single line with the command line options. If this
     // doesn't exist, no parsing is done.
-    if (parseArgs(0, NULL, cfg, node))
+    if (parseArgs(0, NULL, cfg, ucfg, node) || icache_config(ucfg.icache_lines, ucfg.icache_line_words))
     {
         VPrint("Error in parsing args\n");
     }
     else
     {
         // Create and configure the top level cpu object
-        pCpu = new rv32(cfg.dbg_fp);
+        pCpu = new rv32_vproc(cfg.dbg_fp);
+
+        // Configure the quantum keeper. The ISS is decoupled from simulation time
+        // when it can execute without going to the bus.
+#ifdef USE_INTERNAL_MEMORY
+        qk_decoupled       = true;
+#else
+        qk_decoupled       = ucfg.icache_lines != 0;
+#endif
+        qk_quantum         = ucfg.quantum ? ucfg.quantum : 1;
+        qk_cycles_per_tick = ucfg.clk_freq_mhz;
+
+        amo_locking        = ucfg.lock_atomics;
+
+        ltimer_en          = ucfg.local_timer && cfg.use_external_timer;
+
+        snap_pending       = ucfg.snap_fname != NULL;
+        snap_fname         = ucfg.snap_fname;
+        snap_instrs        = ucfg.snap_instrs;
+        snap_pc            = ucfg.snap_pc;
+        snap_at_pc         = ucfg.snap_at_pc;
 
         // Register external memory callback function
         pCpu->register_ext_mem_callback(ext_mem_access);
@@ -390,7 +1059,7 @@ extern "C" void VUserMain0()
         pCpu->register_int_callback(iss_int_callback);
 
         // Register VProc user callback, used to update irq status
-        VRegIrq(vproc_irq_callback, node);
+        VRegIrq(vproc_irq_callbacks[node], node);
 
         // If GDB mode, pass execution to the remote GDB interface
         if (cfg.gdb_mode)
@@ -405,7 +1074,7 @@ extern "C" void VUserMain0()
             // Load an executable if specified on the command line
             if (cfg.user_fname)
             {
-                if (pCpu->read_elf(cfg.exec_fname))
+                if (load_executable(cfg, ucfg))
                 {
                     error = 1;
                 }
@@ -418,6 +1087,9 @@ extern "C" void VUserMain0()
                 {
                     fprintf(stderr, "***ERROR in opening PTY\n");
                 }
+
+                dbg_sync();
+                dbg_print_stats();
             }
 
 #ifdef __WIN32__
@@ -427,8 +1099,23 @@ extern "C" void VUserMain0()
         else
         {
             // Load an executable
-            if (!pCpu->read_elf(cfg.exec_fname))
+            if (!load_executable(cfg, ucfg))
             {
+                // Set the hart ID to be the node number
+                rv32i_cpu::rv32i_hart_state hart_state = pCpu->rv32_get_cpu_state();
+                hart_state.csr[rv32csr_consts::RV32CSR_ADDR_MHARTID] = node;
+                pCpu->rv32_set_cpu_state(hart_state);
+
+                if (ucfg.trace_fname != NULL)
+                {
+                    trace_en = !rv32trace_open(ucfg.trace_fname, ucfg.trace_ring, node);
+                }
+
+                if (ucfg.prof_period != 0)
+                {
+                    prof_en = !rv32prof_open(cfg.exec_fname, ucfg.prof_period);
+                }
+
                 pre_run_setup();
 
                 // Run processor
@@ -436,6 +1123,40 @@ extern "C" void VUserMain0()
 
                 post_run_actions();
 
+                if (trace_en)
+                {
+                    // Complete the record of the final instruction
+                    trace_fetch(pCpu->pc_val(), pCpu->clk_cycles());
+                    rv32trace_close();
+                }
+
+                if (prof_en)
+                {
+                    char prof_fname[strbufsize];
+                    snprintf(prof_fname, strbufsize, "%s%d", PROF_FNAME_PREFIX, node);
+
+                    if (!rv32prof_write(prof_fname))
+                    {
+                        VPrint("Profile written to %s%s and %s%s\n", prof_fname, RV32PROF_FLAT_SUFFIX, prof_fname, RV32PROF_FOLDED_SUFFIX);
+                    }
+                }
+
+                icache_print_stats();
+                qk_print_stats();
+
+                if (ltimer_en)
+                {
+                    VPrint("Local timer: %llu mtime reads, %llu synchronisations\n",
+                           (unsigned long long)ltimer_reads, (unsigned long long)ltimer_syncs);
+                }
+                VPrint("ISS interrupt callback: %llu calls, %llu interrupt state changes\n",
+                       (unsigned long long)iss_int_polls, (unsigned long long)iss_int_events);
+
+                if (amo_locking)
+                {
+                    VPrint("Atomic bus locks: %llu\n", (unsigned long long)amo_locks);
+                }
+
                 if (cfg.num_instr != 0)
                 {
 
@@ -472,3 +1193,16 @@ extern "C" void VUserMain0()
     SLEEP_FOREVER;
 }
 
+// ---------------------------------------------
+// Main entry points for each hart's VProc node
+// ---------------------------------------------
+
+extern "C" void VUserMain0() { hart_main(0); }
+extern "C" void VUserMain1() { hart_main(1); }
+extern "C" void VUserMain2() { hart_main(2); }
+extern "C" void VUserMain3() { hart_main(3); }
+extern "C" void VUserMain4() { hart_main(4); }
+extern "C" void VUserMain5() { hart_main(5); }
+extern "C" void VUserMain6() { hart_main(6); }
+extern "C" void VUserMain7() { hart_main(7); }
+
@@ -8,18 +8,96 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <atomic>
+#include <mutex>
 
 extern "C" {
     
 #include "VUser.h"
 }
 
+#include "mem_vproc_api.h"
+
 #define CFGFILENAME                        "vusermain.cfg"
 #define RV32I_GETOPT_ARG_STR               "ThHdbrget:n:D:A:p:S:"
 #define MAXARGS                            100
 #define MEM_SIZE                           (1024*1024)
 #define MEM_OFFSET                         0
 
+// Guest profile output file name prefix, to which the node number is added
+#define PROF_FNAME_PREFIX                  "prof"
+
+// Memory regions saved in a snapshot: the test bench's instruction and
+// data memories, or the ISS's internal memory
+#define SNAP_IMEM_ADDR                     0x00000000
+#define SNAP_DMEM_ADDR                     0x00080000
+#define SNAP_MEM_BYTES                     0x00010000
+
+// Maximum number of harts, each on its own VProc node
+#define MAX_HARTS                          8
+
+// Atomic instruction decoding, and the number of instructions an LR
+// holds the bus lock waiting for an SC
+#define AMO_OPCODE                         0x2f
+#define AMO_OPCODE_MASK                    0x7f
+#define AMO_FUNCT5_SHIFT                   27
+#define AMO_FUNCT5_LR                      0x02
+#define AMO_LR_HOLD_INSTRS                 16
+
+// Default temporal decoupling quantum, in cycles, and HDL clock frequency
+// (which sets the number of cycles per mtime tick)
+#define DEFAULT_QUANTUM                    1000
+#define DEFAULT_CLK_FREQ_MHZ               100
+
+// Top of memory modelled internally by the ISS when USE_INTERNAL_MEMORY defined
+#ifndef INT_MEM_TOP
+#define INT_MEM_TOP                        0x00100000
+#endif
+
+// Quantum keeper synchronisation reasons
+#define QK_SYNC_QUANTUM                    0
+#define QK_SYNC_DEADLINE                   1
+#define QK_SYNC_ACCESS                     2
+#define QK_NUM_SYNC_REASONS                3
+
+// Example specific configuration, in addition to the ISS's rv32i_cfg_s
+struct vusermain_cfg_s {
+    uint32_t       icache_lines;
+    uint32_t       icache_line_words;
+    uint32_t       quantum;
+    uint32_t       clk_freq_mhz;
+    bool           lock_atomics;
+    bool           local_timer;
+    const char*    trace_fname;
+    uint32_t       trace_ring;
+    uint32_t       prof_period;
+    bool           fast_load;
+    const char*    restore_fname;
+    const char*    snap_fname;
+    uint64_t       snap_instrs;
+    uint32_t       snap_pc;
+    bool           snap_at_pc;
+
+    vusermain_cfg_s()
+    {
+        icache_lines           = 0;
+        icache_line_words      = ICACHE_DEFAULT_LINE_WORDS;
+        quantum                = DEFAULT_QUANTUM;
+        clk_freq_mhz           = DEFAULT_CLK_FREQ_MHZ;
+        lock_atomics           = false;
+        local_timer            = false;
+        trace_fname            = NULL;
+        trace_ring             = 0;
+        prof_period            = 0;
+        fast_load              = false;
+        restore_fname          = NULL;
+        snap_fname             = NULL;
+        snap_instrs            = 0;
+        snap_pc                = 0;
+        snap_at_pc             = false;
+    }
+};
+
 // Define a sleep forever macro
 #define SLEEP_FOREVER {while(1)            VTick(0x7fffffff, node);}      
 
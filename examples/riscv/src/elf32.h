@@ -0,0 +1,77 @@
+/**************************************************************/
+/* elf32.h                                   Date: 2024/06/03 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell. All rights reserved.   */
+/*                                                            */
+/**************************************************************/
+
+#ifndef _ELF32_H_
+#define _ELF32_H_
+
+#include <cstdint>
+
+// ---------------------------------------------
+// Minimal ELF32 definitions, for reading
+// program headers and the symbol table
+// ---------------------------------------------
+
+#define ELF_MAGIC                               "\177ELF"
+#define ELF_CLASS32                             1
+
+#define ELF_PT_LOAD                             1
+
+#define ELF_SHT_SYMTAB                          2
+#define ELF_STT_FUNC                            2
+#define ELF_ST_TYPE(_info)                      ((_info) & 0xf)
+
+struct elf32_ehdr_s {
+    uint8_t        e_ident[16];
+    uint16_t       e_type;
+    uint16_t       e_machine;
+    uint32_t       e_version;
+    uint32_t       e_entry;
+    uint32_t       e_phoff;
+    uint32_t       e_shoff;
+    uint32_t       e_flags;
+    uint16_t       e_ehsize;
+    uint16_t       e_phentsize;
+    uint16_t       e_phnum;
+    uint16_t       e_shentsize;
+    uint16_t       e_shnum;
+    uint16_t       e_shstrndx;
+};
+
+struct elf32_phdr_s {
+    uint32_t       p_type;
+    uint32_t       p_offset;
+    uint32_t       p_vaddr;
+    uint32_t       p_paddr;
+    uint32_t       p_filesz;
+    uint32_t       p_memsz;
+    uint32_t       p_flags;
+    uint32_t       p_align;
+};
+
+struct elf32_shdr_s {
+    uint32_t       sh_name;
+    uint32_t       sh_type;
+    uint32_t       sh_flags;
+    uint32_t       sh_addr;
+    uint32_t       sh_offset;
+    uint32_t       sh_size;
+    uint32_t       sh_link;
+    uint32_t       sh_info;
+    uint32_t       sh_addralign;
+    uint32_t       sh_entsize;
+};
+
+struct elf32_sym_s {
+    uint32_t       st_name;
+    uint32_t       st_value;
+    uint32_t       st_size;
+    uint8_t        st_info;
+    uint8_t        st_other;
+    uint16_t       st_shndx;
+};
+
+#endif
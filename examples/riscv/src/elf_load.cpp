@@ -0,0 +1,147 @@
+/**************************************************************/
+/* elf_load.cpp                              Date: 2024/06/10 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell. All rights reserved.   */
+/*                                                            */
+/**************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <chrono>
+
+#include "mem_vproc_api.h"
+#include "elf_load.h"
+#include "elf32.h"
+
+// Backdoor write function, if any. Each hart runs in its own thread, so
+// has its own registration.
+static thread_local p_elf_load_backdoor_t elf_backdoor = NULL;
+
+// ---------------------------------------------
+// Register a backdoor memory write function
+// (NULL to load with bursts only)
+// ---------------------------------------------
+
+void elf_load_register_backdoor(p_elf_load_backdoor_t func)
+{
+    elf_backdoor = func;
+}
+
+// ---------------------------------------------
+// Write len bytes at addr with bursts, using
+// byte enables for unaligned first and last
+// words. Returns the number of bursts.
+// ---------------------------------------------
+
+static uint32_t elf_load_burst(const uint32_t addr, const uint8_t* data, const uint32_t len)
+{
+    uint32_t start  = addr & ~3U;
+    uint32_t end    = addr + len;
+    uint32_t words  = (((end + 3) & ~3U) - start) / 4;
+    uint32_t bursts = 0;
+
+    std::vector<uint32_t> buf(words, 0);
+    memcpy((uint8_t*)buf.data() + (addr & 3), data, len);
+
+    for (uint32_t idx = 0; idx < words; idx += ELF_LOAD_BURST_WORDS)
+    {
+        uint32_t wlen = (words - idx) < ELF_LOAD_BURST_WORDS ? (words - idx) : ELF_LOAD_BURST_WORDS;
+        uint32_t fbe  = idx == 0             ? (0xf << (addr & 3)) & 0xf : 0xf;
+        uint32_t lbe  = (idx + wlen) == words ? 0xf >> ((4 - (end & 3)) & 3) : 0xf;
+
+        // A single word transfer has both first and last enables
+        if (wlen == 1)
+        {
+            fbe &= lbe;
+            lbe  = fbe;
+        }
+
+        VBurstWriteBE(start + idx * 4, &buf[idx], wlen, fbe, lbe, node);
+        bursts++;
+    }
+
+    return bursts;
+}
+
+// ---------------------------------------------
+// Load the PT_LOAD segments of an ELF32
+// executable into memory, returning the entry
+// point. Returns non-zero on error.
+// ---------------------------------------------
+
+int elf_load(const char* fname, uint32_t &entry)
+{
+    FILE*        fp = fopen(fname, "rb");
+    elf32_ehdr_s ehdr;
+
+    if (fp == NULL || fread(&ehdr, sizeof(ehdr), 1, fp) != 1 || memcmp(ehdr.e_ident, ELF_MAGIC, 4) || ehdr.e_ident[4] != ELF_CLASS32)
+    {
+        fprintf(stderr, "**ERROR: unable to read ELF32 file %s for loading\n", fname);
+        if (fp != NULL)
+        {
+            fclose(fp);
+        }
+        return 1;
+    }
+
+    std::vector<elf32_phdr_s> phdrs(ehdr.e_phnum);
+
+    fseek(fp, ehdr.e_phoff, SEEK_SET);
+    if (fread(phdrs.data(), sizeof(elf32_phdr_s), ehdr.e_phnum, fp) != ehdr.e_phnum)
+    {
+        fprintf(stderr, "**ERROR: unable to read program headers of %s\n", fname);
+        fclose(fp);
+        return 1;
+    }
+
+    uint32_t segments       = 0;
+    uint32_t bursts         = 0;
+    uint64_t bytes          = 0;
+    uint64_t backdoor_bytes = 0;
+
+    auto t_start = std::chrono::steady_clock::now();
+
+    for (auto &ph : phdrs)
+    {
+        if (ph.p_type != ELF_PT_LOAD || ph.p_memsz == 0)
+        {
+            continue;
+        }
+
+        // Segment data, with bss beyond the file size left zero
+        std::vector<uint8_t> seg(ph.p_memsz, 0);
+
+        fseek(fp, ph.p_offset, SEEK_SET);
+        if (ph.p_filesz > ph.p_memsz || fread(seg.data(), 1, ph.p_filesz, fp) != ph.p_filesz)
+        {
+            fprintf(stderr, "**ERROR: unable to read segment at 0x%08x from %s\n", ph.p_paddr, fname);
+            fclose(fp);
+            return 1;
+        }
+
+        if (elf_backdoor != NULL && !elf_backdoor(ph.p_paddr, seg.data(), ph.p_memsz))
+        {
+            backdoor_bytes += ph.p_memsz;
+        }
+        else
+        {
+            bursts += elf_load_burst(ph.p_paddr, seg.data(), ph.p_memsz);
+        }
+
+        bytes += ph.p_memsz;
+        segments++;
+    }
+
+    fclose(fp);
+
+    double t_usec = (double)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t_start).count();
+
+    VPrint("ELF load: %u segments, %llu bytes (%llu by backdoor) in %u bursts, %.3f ms (%.1f MB/s)\n",
+           segments, (unsigned long long)bytes, (unsigned long long)backdoor_bytes, bursts,
+           t_usec / 1e3, t_usec > 0 ? (double)bytes / t_usec : 0.0);
+
+    entry = ehdr.e_entry;
+
+    return 0;
+}
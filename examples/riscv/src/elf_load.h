@@ -0,0 +1,29 @@
+/**************************************************************/
+/* elf_load.h                                Date: 2024/06/10 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell. All rights reserved.   */
+/*                                                            */
+/**************************************************************/
+
+#ifndef _ELF_LOAD_H_
+#define _ELF_LOAD_H_
+
+#include <cstdint>
+
+// Fast ELF program loader. Rather than the ISS loading an executable a
+// word at a time over the bus, each loadable segment (including its zero
+// filled bss) is written with the largest bursts possible, or via a
+// registered backdoor function that writes directly to the HDL memory.
+
+// Words per burst
+#define ELF_LOAD_BURST_WORDS                    MEM_BLOCK_BURST_WORDS
+
+// Backdoor write function type. Returns 0 if the data was written, else
+// non-zero (e.g. the address range isn't backdoor accessible), when the
+// loader falls back to bursts.
+typedef int (*p_elf_load_backdoor_t)(const uint32_t addr, const uint8_t* data, const uint32_t len);
+
+extern void elf_load_register_backdoor (p_elf_load_backdoor_t func);
+extern int  elf_load                   (const char* fname, uint32_t &entry);
+
+#endif
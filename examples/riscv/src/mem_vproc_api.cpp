@@ -10,8 +10,135 @@
 
 #include "mem_vproc_api.h"
 
+// ---------------------------------------------
+// Instruction cache state. A direct mapped
+// cache of line_words word lines, filled with
+// burst reads. Disabled when lines is 0. Each
+// hart runs in its own thread, so has its own
+// cache.
+// ---------------------------------------------
+
+static thread_local uint32_t  icache_lines         = 0;
+static thread_local uint32_t  icache_line_words    = ICACHE_DEFAULT_LINE_WORDS;
+static thread_local uint32_t  icache_line_bytes    = ICACHE_DEFAULT_LINE_WORDS * 4;
+static thread_local uint32_t* icache_data          = NULL;
+static thread_local uint32_t* icache_tag           = NULL;
+static thread_local bool*     icache_valid         = NULL;
+
+static thread_local uint64_t  icache_hits          = 0;
+static thread_local uint64_t  icache_misses        = 0;
+static thread_local uint64_t  icache_invalidations = 0;
+
+// ---------------------------------------------
+// Debugger access state. The debugger accesses
+// memory a byte at a time, so reads are served
+// from a block read with a single burst, and
+// contiguous writes are gathered and written
+// with a single burst. Both are synchronised
+// with memory at the next non-debug access.
+// ---------------------------------------------
+
+static thread_local uint32_t  dbg_rd_buf[DBG_BLOCK_WORDS];
+static thread_local uint32_t  dbg_rd_addr          = 0;
+static thread_local bool      dbg_rd_valid         = false;
+
+static thread_local uint32_t  dbg_wr_buf[DBG_BLOCK_WORDS + 1];
+static thread_local uint32_t  dbg_wr_addr          = 0;
+static thread_local uint32_t  dbg_wr_len           = 0;
+
+static thread_local uint64_t  dbg_bytes            = 0;
+static thread_local uint64_t  dbg_bursts           = 0;
+
+// ---------------------------------------------
+// Configure the instruction cache with the
+// given number of lines and words per line
+// (both powers of 2). A line count of 0
+// disables the cache. Returns non-zero on
+// error.
+// ---------------------------------------------
+
+int icache_config(const uint32_t lines, const uint32_t line_words)
+{
+    if ((lines & (lines - 1)) || line_words == 0 || (line_words & (line_words - 1)) || line_words > MAXBURSTLEN)
+    {
+        fprintf(stderr, "***ERROR: icache_config: lines (%d) and line words (%d) must be powers of 2, with line words <= %d\n",
+                        lines, line_words, MAXBURSTLEN);
+        return 1;
+    }
+
+    delete [] icache_data;
+    delete [] icache_tag;
+    delete [] icache_valid;
+
+    icache_lines      = lines;
+    icache_line_words = line_words;
+    icache_line_bytes = line_words * 4;
+
+    if (lines)
+    {
+        icache_data   = new uint32_t[lines * line_words];
+        icache_tag    = new uint32_t[lines];
+        icache_valid  = new bool[lines];
+
+        icache_invalidate();
+    }
+
+    return 0;
+}
+
+// ---------------------------------------------
+// Invalidate the whole instruction cache
+// ---------------------------------------------
+
+void icache_invalidate(void)
+{
+    for (uint32_t idx = 0; idx < icache_lines; idx++)
+    {
+        icache_valid[idx] = false;
+    }
+}
+
+// ---------------------------------------------
+// Invalidate any cached line holding addr
+// ---------------------------------------------
+
+static inline void icache_invalidate_addr(const uint32_t addr)
+{
+    if (icache_lines)
+    {
+        uint32_t line_addr = addr & ~(icache_line_bytes - 1);
+        uint32_t idx       = (addr / icache_line_bytes) & (icache_lines - 1);
+
+        if (icache_valid[idx] && icache_tag[idx] == line_addr)
+        {
+            icache_valid[idx] = false;
+            icache_invalidations++;
+        }
+    }
+}
+
+// ---------------------------------------------
+// Display the instruction cache statistics
+// ---------------------------------------------
+
+void icache_print_stats(void)
+{
+    if (icache_lines)
+    {
+        uint64_t accesses = icache_hits + icache_misses;
+
+        VPrint("I-cache (%d lines x %d words): %llu hits, %llu misses (%.2f%% hit rate), %llu invalidations\n",
+               icache_lines, icache_line_words,
+               (unsigned long long)icache_hits, (unsigned long long)icache_misses,
+               accesses ? 100.0 * (double)icache_hits / (double)accesses : 0.0,
+               (unsigned long long)icache_invalidations);
+    }
+}
+
 void write_word(uint32_t addr, uint32_t data)
 {
+    icache_invalidate_addr(addr);
+
     VWriteBE(addr & ~0x3UL, data, 0xf, NORMAL_UPDATE, node);
     
     if (ACCESS_LEN > 0)
@@ -22,6 +149,8 @@ void write_word(uint32_t addr, uint32_t data)
 
 void write_hword(uint32_t addr, uint32_t data)
 {
+    icache_invalidate_addr(addr);
+
     VWriteBE(addr & ~0x3UL, data << ((addr & 0x2) * 8), 0x3 << (addr & 0x2), NORMAL_UPDATE, node);
 
     if (ACCESS_LEN > 0)
@@ -32,6 +161,8 @@ void write_hword(uint32_t addr, uint32_t data)
 
 void write_byte(uint32_t addr, uint32_t data)
 {
+    icache_invalidate_addr(addr);
+
     VWriteBE (addr & ~0x3UL, data << ((addr & 0x3) * 8), 0x1 << (addr & 0x3), NORMAL_UPDATE, node);
 
     if (ACCESS_LEN > 0)
@@ -44,11 +175,48 @@ uint32_t read_instr(uint32_t addr)
 {
     uint32_t word;
 
-    VRead(addr & ~0x3, &word, NORMAL_UPDATE, node);
+    if (icache_lines == 0)
+    {
+        VRead(addr & ~0x3, &word, NORMAL_UPDATE, node);
 
-    if (ACCESS_LEN > 0)
+        if (ACCESS_LEN > 0)
+        {
+            VTick(ACCESS_LEN, node);
+        }
+
+        return word;
+    }
+
+    uint32_t  line_addr = addr & ~(icache_line_bytes - 1);
+    uint32_t  idx       = (addr / icache_line_bytes) & (icache_lines - 1);
+    uint32_t* line      = &icache_data[idx * icache_line_words];
+
+    // On a miss, fill the whole line with a single burst
+    if (!icache_valid[idx] || icache_tag[idx] != line_addr)
     {
-        VTick(ACCESS_LEN, node);
+        VBurstRead(line_addr, line, icache_line_words, node);
+
+        if (ACCESS_LEN > 0)
+        {
+            VTick(ACCESS_LEN, node);
+        }
+
+        icache_tag[idx]   = line_addr;
+        icache_valid[idx] = true;
+        icache_misses++;
+    }
+    else
+    {
+        icache_hits++;
+    }
+
+    word = line[(addr >> 2) & (icache_line_words - 1)];
+
+    // A fence.i (at either half word, for compressed code) invalidates the cache
+    // for subsequent fetches
+    if ((((addr & 0x2) ? (word >> 16) : word) & FENCE_I_MASK) == FENCE_I_INSTR)
+    {
+        icache_invalidate();
     }
 
     return word;
@@ -93,4 +261,174 @@ uint32_t read_byte(uint32_t addr)
     }
 
     return (word >> ((addr & 0x3UL) * 8)) & 0xff;
-}
\ No newline at end of file
+}
+// ---------------------------------------------
+// Word aligned block transfers, using the
+// largest bursts possible. A single word is
+// a normal access, so that a block function
+// can be used for registers as well as memory.
+// ---------------------------------------------
+
+void write_block(uint32_t addr, const uint32_t* data, const uint32_t words)
+{
+    if (words == 1)
+    {
+        write_word(addr, data[0]);
+        return;
+    }
+
+    if (icache_lines)
+    {
+        icache_invalidate();
+    }
+
+    for (uint32_t idx = 0; idx < words; idx += MEM_BLOCK_BURST_WORDS)
+    {
+        uint32_t len = (words - idx) < MEM_BLOCK_BURST_WORDS ? (words - idx) : MEM_BLOCK_BURST_WORDS;
+
+        VBurstWrite((addr & ~0x3UL) + idx * 4, (void*)&data[idx], len, node);
+    }
+
+    if (ACCESS_LEN > 0)
+    {
+        VTick(ACCESS_LEN, node);
+    }
+}
+
+void read_block(uint32_t addr, uint32_t* data, const uint32_t words)
+{
+    if (words == 1)
+    {
+        data[0] = read_word(addr);
+        return;
+    }
+
+    for (uint32_t idx = 0; idx < words; idx += MEM_BLOCK_BURST_WORDS)
+    {
+        uint32_t len = (words - idx) < MEM_BLOCK_BURST_WORDS ? (words - idx) : MEM_BLOCK_BURST_WORDS;
+
+        VBurstRead((addr & ~0x3UL) + idx * 4, &data[idx], len, node);
+    }
+
+    if (ACCESS_LEN > 0)
+    {
+        VTick(ACCESS_LEN, node);
+    }
+}
+
+// ---------------------------------------------
+// Write any gathered debugger write data,
+// using byte enables for unaligned first and
+// last words
+// ---------------------------------------------
+
+static void dbg_flush(void)
+{
+    if (dbg_wr_len == 0)
+    {
+        return;
+    }
+
+    uint32_t start = dbg_wr_addr & ~0x3U;
+    uint32_t end   = dbg_wr_addr + dbg_wr_len;
+    uint32_t words = (((end + 3) & ~0x3U) - start) / 4;
+    uint32_t fbe   = (0xf << (dbg_wr_addr & 3)) & 0xf;
+    uint32_t lbe   = 0xf >> ((4 - (end & 3)) & 3);
+
+    if (words == 1)
+    {
+        VWriteBE(start, dbg_wr_buf[0], fbe & lbe, NORMAL_UPDATE, node);
+    }
+    else
+    {
+        VBurstWriteBE(start, dbg_wr_buf, words, fbe, lbe, node);
+    }
+
+    if (ACCESS_LEN > 0)
+    {
+        VTick(ACCESS_LEN, node);
+    }
+
+    icache_invalidate();
+
+    dbg_wr_len = 0;
+    dbg_bursts++;
+}
+
+// ---------------------------------------------
+// Debugger byte read, from a block read with a
+// single burst
+// ---------------------------------------------
+
+uint32_t dbg_read_byte(const uint32_t addr)
+{
+    uint32_t block_addr = addr & ~(DBG_BLOCK_BYTES - 1);
+
+    dbg_flush();
+
+    if (!dbg_rd_valid || dbg_rd_addr != block_addr)
+    {
+        VBurstRead(block_addr, dbg_rd_buf, DBG_BLOCK_WORDS, node);
+
+        if (ACCESS_LEN > 0)
+        {
+            VTick(ACCESS_LEN, node);
+        }
+
+        dbg_rd_addr  = block_addr;
+        dbg_rd_valid = true;
+        dbg_bursts++;
+    }
+
+    dbg_bytes++;
+
+    return ((uint8_t*)dbg_rd_buf)[addr & (DBG_BLOCK_BYTES - 1)];
+}
+
+// ---------------------------------------------
+// Debugger byte write, gathered with preceding
+// contiguous writes
+// ---------------------------------------------
+
+void dbg_write_byte(const uint32_t addr, const uint32_t data)
+{
+    dbg_rd_valid = false;
+
+    if (dbg_wr_len && (addr != dbg_wr_addr + dbg_wr_len || dbg_wr_len == DBG_BLOCK_BYTES))
+    {
+        dbg_flush();
+    }
+
+    if (dbg_wr_len == 0)
+    {
+        dbg_wr_addr = addr;
+    }
+
+    // The buffer is word aligned with the start address
+    ((uint8_t*)dbg_wr_buf)[(dbg_wr_addr & 3) + dbg_wr_len++] = data;
+    dbg_bytes++;
+}
+
+// ---------------------------------------------
+// Synchronise debugger accesses with memory,
+// before a non-debug access
+// ---------------------------------------------
+
+void dbg_sync(void)
+{
+    dbg_flush();
+    dbg_rd_valid = false;
+}
+
+// ---------------------------------------------
+// Display the debugger access statistics
+// ---------------------------------------------
+
+void dbg_print_stats(void)
+{
+    if (dbg_bytes)
+    {
+        VPrint("Debugger memory accesses: %llu bytes in %llu bursts\n",
+               (unsigned long long)dbg_bytes, (unsigned long long)dbg_bursts);
+    }
+}
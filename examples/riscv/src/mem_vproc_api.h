@@ -27,8 +27,28 @@ extern "C" {
 #define ACCESS_LEN                              0
 
 #define HALT_ADDR                               0xAFFFFFF8
+#define BUS_LOCK_ADDR                           0xAFFFFFF0
 
-extern int      node;
+// Default instruction cache line length in words (the cache itself
+// is disabled unless a number of lines is configured)
+#define ICACHE_DEFAULT_LINE_WORDS               8
+
+// Maximum words per block transfer burst. The HDL burst count is 12 bits,
+// so MAXBURSTLEN itself is not encodable
+#define MEM_BLOCK_BURST_WORDS                   (MAXBURSTLEN/2)
+
+// Debugger memory accesses are coalesced into bursts of a block of this
+// many bytes, for addresses below DBG_BURST_TOP (i.e. memory, and not
+// peripherals)
+#define DBG_BLOCK_BYTES                         1024
+#define DBG_BLOCK_WORDS                         (DBG_BLOCK_BYTES/4)
+#define DBG_BURST_TOP                           0x80000000
+
+// fence.i instruction opcode and funct3 fields, and their mask
+#define FENCE_I_INSTR                           0x0000100f
+#define FENCE_I_MASK                            0x0000707f
+
+extern thread_local int node;
 
 extern void     write_word  (uint32_t addr, uint32_t data);
 extern void     write_hword (uint32_t addr, uint32_t data);
@@ -37,6 +57,17 @@ extern uint32_t read_word   (uint32_t addr);
 extern uint32_t read_instr  (uint32_t addr);
 extern uint32_t read_hword  (uint32_t addr);
 extern uint32_t read_byte   (uint32_t addr);
+extern void     write_block (uint32_t addr, const uint32_t* data, const uint32_t words);
+extern void     read_block  (uint32_t addr, uint32_t* data, const uint32_t words);
+
+extern uint32_t dbg_read_byte      (const uint32_t addr);
+extern void     dbg_write_byte     (const uint32_t addr, const uint32_t data);
+extern void     dbg_sync           (void);
+extern void     dbg_print_stats    (void);
+
+extern int      icache_config      (const uint32_t lines, const uint32_t line_words);
+extern void     icache_invalidate  (void);
+extern void     icache_print_stats (void);
 
 #endif
 
@@ -0,0 +1,40 @@
+/**************************************************************/
+/* rv32_vproc.h                              Date: 2024/05/27 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell. All rights reserved.   */
+/*                                                            */
+/**************************************************************/
+
+#ifndef _RV32_VPROC_H_
+#define _RV32_VPROC_H_
+
+#include "rv32.h"
+
+// ---------------------------------------------
+// rv32 ISS with access to internal state needed
+// by the VProc example (which is protected in
+// the ISS classes)
+// ---------------------------------------------
+
+class rv32_vproc : public rv32
+{
+public:
+    rv32_vproc(FILE* dbg_fp = stdout) : rv32(dbg_fp)
+    {
+    };
+
+    // The current (last decoded) instruction, expanded if compressed, and
+    // whether it was compressed. When called at the fetch of the next
+    // instruction, this is the instruction just completed.
+    uint32_t curr_instr_val()        { return get_curr_instruction(); };
+    bool     curr_instr_compressed() { return cmp_instr; };
+
+    // Counters and privilege level, for snapshots. The instructions retired
+    // count can be read but not set.
+    uint64_t instret_val()                        { return inst_retired(); };
+    void     set_clk_cycles(const uint64_t val)   { cycle_count = val; };
+    uint32_t priv_lvl_val()                       { return state.priv_lvl; };
+    void     set_priv_lvl(const uint32_t val)     { state.priv_lvl = val; };
+};
+
+#endif
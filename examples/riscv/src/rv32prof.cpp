@@ -0,0 +1,311 @@
+/**************************************************************/
+/* rv32prof.cpp                              Date: 2024/06/03 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell. All rights reserved.   */
+/*                                                            */
+/**************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+
+#include "rv32prof.h"
+#include "elf32.h"
+
+struct prof_sym_s {
+    uint32_t       addr;
+    uint32_t       size;
+    std::string    name;
+
+    bool operator<(const prof_sym_s &rhs) const { return addr < rhs.addr; };
+};
+
+// ---------------------------------------------
+// Profiler state. Each hart runs in its own
+// thread, so has its own profile.
+// ---------------------------------------------
+
+static thread_local uint32_t                                   prof_period      = 0;
+static thread_local uint64_t                                   prof_next_sample = 0;
+static thread_local uint64_t                                   prof_samples     = 0;
+static thread_local bool                                       prof_have_last   = false;
+static thread_local uint32_t                                   prof_last_pc     = 0;
+
+static thread_local uint32_t                                   prof_stack[RV32PROF_MAX_DEPTH];
+static thread_local int                                        prof_depth       = 0;
+
+static thread_local std::vector<prof_sym_s>*                   prof_syms        = NULL;
+static thread_local std::unordered_map<uint32_t, uint64_t>*    prof_hist        = NULL;
+static thread_local std::map<std::vector<uint32_t>, uint64_t>* prof_stacks      = NULL;
+
+// ---------------------------------------------
+// Load function symbols from an ELF file's
+// symbol table. Returns non-zero on error.
+// ---------------------------------------------
+
+static int prof_load_symbols(const char* elf_fname)
+{
+    FILE*        fp = fopen(elf_fname, "rb");
+    elf32_ehdr_s ehdr;
+
+    if (fp == NULL || fread(&ehdr, sizeof(ehdr), 1, fp) != 1 || memcmp(ehdr.e_ident, ELF_MAGIC, 4) || ehdr.e_ident[4] != ELF_CLASS32)
+    {
+        fprintf(stderr, "**ERROR: unable to read ELF32 file %s for profiling\n", elf_fname);
+        if (fp != NULL)
+        {
+            fclose(fp);
+        }
+        return 1;
+    }
+
+    std::vector<elf32_shdr_s> shdrs(ehdr.e_shnum);
+
+    fseek(fp, ehdr.e_shoff, SEEK_SET);
+    if (fread(shdrs.data(), sizeof(elf32_shdr_s), ehdr.e_shnum, fp) != ehdr.e_shnum)
+    {
+        fclose(fp);
+        return 1;
+    }
+
+    for (auto &sh : shdrs)
+    {
+        if (sh.sh_type != ELF_SHT_SYMTAB || sh.sh_link >= ehdr.e_shnum)
+        {
+            continue;
+        }
+
+        // Read the symbol table and its linked string table
+        std::vector<elf32_sym_s> syms(sh.sh_size / sizeof(elf32_sym_s));
+        std::vector<char>        strtab(shdrs[sh.sh_link].sh_size + 1, 0);
+
+        fseek(fp, sh.sh_offset, SEEK_SET);
+        size_t nsyms = fread(syms.data(), sizeof(elf32_sym_s), syms.size(), fp);
+
+        fseek(fp, shdrs[sh.sh_link].sh_offset, SEEK_SET);
+        size_t nstr = fread(strtab.data(), 1, shdrs[sh.sh_link].sh_size, fp);
+
+        for (size_t idx = 0; idx < nsyms; idx++)
+        {
+            if (ELF_ST_TYPE(syms[idx].st_info) == ELF_STT_FUNC && syms[idx].st_name < nstr)
+            {
+                prof_syms->push_back({syms[idx].st_value, syms[idx].st_size, &strtab[syms[idx].st_name]});
+            }
+        }
+    }
+
+    fclose(fp);
+
+    std::sort(prof_syms->begin(), prof_syms->end());
+
+    return 0;
+}
+
+// ---------------------------------------------
+// Look up the function containing an address
+// ---------------------------------------------
+
+static const prof_sym_s* prof_lookup(const uint32_t addr)
+{
+    auto it = std::upper_bound(prof_syms->begin(), prof_syms->end(), prof_sym_s{addr, 0, ""});
+
+    if (it == prof_syms->begin())
+    {
+        return NULL;
+    }
+
+    --it;
+
+    return (it->size == 0 || addr < it->addr + it->size) ? &*it : NULL;
+}
+
+static std::string prof_name(const uint32_t addr)
+{
+    const prof_sym_s* sym = prof_lookup(addr);
+    char              buf[16];
+
+    if (sym == NULL)
+    {
+        snprintf(buf, sizeof(buf), "0x%08x", addr);
+        return buf;
+    }
+
+    return sym->name;
+}
+
+// ---------------------------------------------
+// Enable profiling, with a sample every period
+// cycles, symbolising against the given ELF
+// file. Returns non-zero on error.
+// ---------------------------------------------
+
+int rv32prof_open(const char* elf_fname, const uint32_t period)
+{
+    prof_syms        = new std::vector<prof_sym_s>;
+    prof_hist        = new std::unordered_map<uint32_t, uint64_t>;
+    prof_stacks      = new std::map<std::vector<uint32_t>, uint64_t>;
+
+    prof_period      = period;
+    prof_next_sample = period;
+    prof_samples     = 0;
+    prof_depth       = 0;
+    prof_have_last   = false;
+
+    return prof_load_symbols(elf_fname);
+}
+
+// ---------------------------------------------
+// Called at the fetch of each instruction with
+// the previous instruction, to update the
+// shadow call stack and take any due sample
+// ---------------------------------------------
+
+void rv32prof_fetch(const uint32_t pc, const uint64_t cycles, const uint32_t last_instr, const bool last_compressed)
+{
+    if (prof_have_last)
+    {
+        uint32_t opcode = last_instr & RV32PROF_OPCODE_MASK;
+        uint32_t rd     = (last_instr >> 7)  & 0x1f;
+        uint32_t rs1    = (last_instr >> 15) & 0x1f;
+        bool     jump   = opcode == RV32PROF_OPCODE_JAL || opcode == RV32PROF_OPCODE_JALR;
+
+        // A call, or a trap (a discontinuity not due to a branch or jump),
+        // pushes the PC it was made from. A return (or mret) pops.
+        if ((jump && RV32PROF_IS_LINK(rd)) ||
+            (!jump && opcode != RV32PROF_OPCODE_BRANCH && last_instr != RV32PROF_INSTR_MRET &&
+             pc != prof_last_pc + (last_compressed ? 2 : 4)))
+        {
+            if (prof_depth < RV32PROF_MAX_DEPTH)
+            {
+                prof_stack[prof_depth] = prof_last_pc;
+            }
+            prof_depth++;
+        }
+        else if ((opcode == RV32PROF_OPCODE_JALR && rd == 0 && RV32PROF_IS_LINK(rs1)) || last_instr == RV32PROF_INSTR_MRET)
+        {
+            prof_depth -= prof_depth ? 1 : 0;
+        }
+    }
+
+    prof_have_last = true;
+    prof_last_pc   = pc;
+
+    if (cycles >= prof_next_sample)
+    {
+        int depth = prof_depth < RV32PROF_MAX_DEPTH ? prof_depth : RV32PROF_MAX_DEPTH;
+
+        std::vector<uint32_t> stack(prof_stack, prof_stack + depth);
+        stack.push_back(pc);
+
+        (*prof_hist)[pc]++;
+        (*prof_stacks)[stack]++;
+
+        prof_samples++;
+        prof_next_sample = cycles + prof_period;
+    }
+}
+
+// ---------------------------------------------
+// Write the flat profile and folded stacks to
+// <prefix>.txt and <prefix>.folded. Returns
+// non-zero on error.
+// ---------------------------------------------
+
+int rv32prof_write(const char* fname_prefix)
+{
+    std::map<std::string, uint64_t> self;
+    std::map<std::string, uint64_t> total;
+
+    if (prof_hist == NULL)
+    {
+        return 1;
+    }
+
+    for (auto &h : *prof_hist)
+    {
+        self[prof_name(h.first)] += h.second;
+    }
+
+    std::string fname = std::string(fname_prefix) + RV32PROF_FOLDED_SUFFIX;
+    FILE*       fp    = fopen(fname.c_str(), "w");
+
+    if (fp == NULL)
+    {
+        fprintf(stderr, "**ERROR: unable to open profile file %s for writing\n", fname.c_str());
+        return 1;
+    }
+
+    // Symbolise the stacks (call sites, then the sampled PC) into folded
+    // form, merging those that resolve to the same functions. Each function
+    // in a stack counts once towards its inclusive total.
+    std::map<std::string, uint64_t> folded;
+
+    for (auto &s : *prof_stacks)
+    {
+        std::vector<std::string> seen;
+        std::string              line;
+
+        for (size_t idx = 0; idx < s.first.size(); idx++)
+        {
+            std::string name = prof_name(s.first[idx]);
+
+            line += (idx ? ";" : "") + name;
+
+            if (std::find(seen.begin(), seen.end(), name) == seen.end())
+            {
+                seen.push_back(name);
+                total[name] += s.second;
+            }
+        }
+
+        folded[line] += s.second;
+    }
+
+    for (auto &f : folded)
+    {
+        fprintf(fp, "%s %llu\n", f.first.c_str(), (unsigned long long)f.second);
+    }
+
+    fclose(fp);
+
+    fname = std::string(fname_prefix) + RV32PROF_FLAT_SUFFIX;
+
+    if ((fp = fopen(fname.c_str(), "w")) == NULL)
+    {
+        fprintf(stderr, "**ERROR: unable to open profile file %s for writing\n", fname.c_str());
+        return 1;
+    }
+
+    std::vector<std::pair<uint64_t, std::string>> sorted;
+    for (auto &f : self)
+    {
+        sorted.push_back({f.second, f.first});
+    }
+    std::sort(sorted.rbegin(), sorted.rend());
+
+    fprintf(fp, "Flat profile: %llu samples, every %u cycles\n\n", (unsigned long long)prof_samples, prof_period);
+    fprintf(fp, "  %% self    samples    %% total    samples  function\n");
+
+    for (auto &f : sorted)
+    {
+        fprintf(fp, "%8.2f %10llu %10.2f %10llu  %s\n",
+                prof_samples ? 100.0 * (double)f.first / (double)prof_samples : 0.0, (unsigned long long)f.first,
+                prof_samples ? 100.0 * (double)total[f.second] / (double)prof_samples : 0.0, (unsigned long long)total[f.second],
+                f.second.c_str());
+    }
+
+    fclose(fp);
+
+    delete prof_syms;
+    delete prof_hist;
+    delete prof_stacks;
+
+    prof_syms   = NULL;
+    prof_hist   = NULL;
+    prof_stacks = NULL;
+
+    return 0;
+}
@@ -0,0 +1,37 @@
+/**************************************************************/
+/* rv32prof.h                                Date: 2024/06/03 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell. All rights reserved.   */
+/*                                                            */
+/**************************************************************/
+
+#ifndef _RV32PROF_H_
+#define _RV32PROF_H_
+
+#include <cstdio>
+#include <cstdint>
+
+// Guest PC sampling profiler. The PC is sampled every period cycles, and
+// a shadow call stack is reconstructed from calls, returns and traps, so
+// that a folded stack file can be generated for flame graph tools, as
+// well as a flat profile symbolised from the ELF file's symbol table.
+
+#define RV32PROF_MAX_DEPTH                      64
+
+#define RV32PROF_FLAT_SUFFIX                    ".txt"
+#define RV32PROF_FOLDED_SUFFIX                  ".folded"
+
+// Instruction decode for calls and returns (rd/rs1 of ra or t0 being
+// the link register)
+#define RV32PROF_OPCODE_MASK                    0x7f
+#define RV32PROF_OPCODE_BRANCH                  0x63
+#define RV32PROF_OPCODE_JAL                     0x6f
+#define RV32PROF_OPCODE_JALR                    0x67
+#define RV32PROF_INSTR_MRET                     0x30200073
+#define RV32PROF_IS_LINK(_r)                    ((_r) == 1 || (_r) == 5)
+
+extern int  rv32prof_open  (const char* elf_fname, const uint32_t period);
+extern void rv32prof_fetch (const uint32_t pc, const uint64_t cycles, const uint32_t last_instr, const bool last_compressed);
+extern int  rv32prof_write (const char* fname_prefix);
+
+#endif
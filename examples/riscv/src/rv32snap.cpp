@@ -0,0 +1,202 @@
+/**************************************************************/
+/* rv32snap.cpp                              Date: 2024/06/12 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell. All rights reserved.   */
+/*                                                            */
+/**************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <map>
+
+#include "rv32snap.h"
+
+// ---------------------------------------------
+// Save a snapshot of the hart's state to file.
+// Returns non-zero on error.
+// ---------------------------------------------
+
+int rv32snap_save(const char* fname, rv32_vproc* cpu, const uint32_t hart,
+                  const rv32snap_region_s* regions, const int num_regions,
+                  const uint32_t* regs, const int num_regs, p_rv32snap_mem_t mem)
+{
+    FILE*                       fp;
+    rv32snap_hdr_s              hdr;
+    std::vector<rv32snap_csr_s> csrs;
+    std::vector<rv32snap_reg_s> hdl_regs;
+    std::vector<uint32_t>       blocks;
+
+    rv32i_cpu::rv32i_hart_state hs = cpu->rv32_get_cpu_state();
+
+    if ((fp = fopen(fname, "wb")) == NULL)
+    {
+        fprintf(stderr, "**ERROR: unable to open snapshot file %s for writing\n", fname);
+        return 1;
+    }
+
+    // Only the non-zero CSRs are saved
+    for (uint32_t idx = 0; idx < sizeof(hs.csr)/sizeof(hs.csr[0]); idx++)
+    {
+        if (hs.csr[idx])
+        {
+            csrs.push_back({idx, 0, hs.csr[idx]});
+        }
+    }
+
+    for (int idx = 0; idx < num_regs; idx++)
+    {
+        uint32_t val;
+        if (mem(regs[idx], &val, 1, false))
+        {
+            fclose(fp);
+            return 1;
+        }
+        hdl_regs.push_back({regs[idx], val});
+    }
+
+    // Read the memory regions, keeping the non-zero blocks, each prefixed
+    // with its address
+    for (int ridx = 0; ridx < num_regions; ridx++)
+    {
+        for (uint32_t offset = 0; offset < regions[ridx].len; offset += RV32SNAP_BLOCK_BYTES)
+        {
+            uint32_t block[RV32SNAP_BLOCK_WORDS];
+            uint32_t addr = regions[ridx].addr + offset;
+
+            if (mem(addr, block, RV32SNAP_BLOCK_WORDS, false))
+            {
+                fclose(fp);
+                return 1;
+            }
+
+            for (int widx = 0; widx < RV32SNAP_BLOCK_WORDS; widx++)
+            {
+                if (block[widx])
+                {
+                    blocks.push_back(addr);
+                    blocks.insert(blocks.end(), block, block + RV32SNAP_BLOCK_WORDS);
+                    break;
+                }
+            }
+        }
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    strncpy(hdr.magic, RV32SNAP_MAGIC, sizeof(hdr.magic));
+    hdr.version    = RV32SNAP_VERSION;
+    hdr.hart       = hart;
+    hdr.priv_lvl   = cpu->priv_lvl_val();
+    hdr.num_csrs   = csrs.size();
+    hdr.num_regs   = hdl_regs.size();
+    hdr.num_blocks = blocks.size() / (RV32SNAP_BLOCK_WORDS + 1);
+    hdr.cycles     = cpu->clk_cycles();
+    hdr.instret    = cpu->instret_val();
+
+    fwrite(&hdr,            sizeof(hdr),            1,               fp);
+    fwrite(hs.x,            sizeof(hs.x),           1,               fp);
+    fwrite(hs.f,            sizeof(hs.f),           1,               fp);
+    fwrite(&hs.pc,          sizeof(hs.pc),          1,               fp);
+    fwrite(csrs.data(),     sizeof(rv32snap_csr_s), csrs.size(),     fp);
+    fwrite(hdl_regs.data(), sizeof(rv32snap_reg_s), hdl_regs.size(), fp);
+    fwrite(blocks.data(),   sizeof(uint32_t),       blocks.size(),   fp);
+
+    fclose(fp);
+
+    return 0;
+}
+
+// ---------------------------------------------
+// Restore the hart's state from a snapshot
+// file. Memory in the regions not saved in the
+// snapshot is zeroed. Returns non-zero on
+// error.
+// ---------------------------------------------
+
+int rv32snap_restore(const char* fname, rv32_vproc* cpu,
+                     const rv32snap_region_s* regions, const int num_regions,
+                     p_rv32snap_mem_t mem)
+{
+    FILE*                       fp;
+    rv32snap_hdr_s              hdr;
+    rv32i_cpu::rv32i_hart_state hs;
+    bool                        error = false;
+
+    if ((fp = fopen(fname, "rb")) == NULL || fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+        strncmp(hdr.magic, RV32SNAP_MAGIC, sizeof(hdr.magic)) || hdr.version != RV32SNAP_VERSION)
+    {
+        fprintf(stderr, "**ERROR: unable to read snapshot file %s\n", fname);
+        if (fp != NULL)
+        {
+            fclose(fp);
+        }
+        return 1;
+    }
+
+    std::vector<rv32snap_csr_s> csrs(hdr.num_csrs);
+    std::vector<rv32snap_reg_s> hdl_regs(hdr.num_regs);
+    std::vector<uint32_t>       blocks(hdr.num_blocks * (RV32SNAP_BLOCK_WORDS + 1));
+
+    error |= fread(hs.x,            sizeof(hs.x),           1,               fp) != 1;
+    error |= fread(hs.f,            sizeof(hs.f),           1,               fp) != 1;
+    error |= fread(&hs.pc,          sizeof(hs.pc),          1,               fp) != 1;
+    error |= fread(csrs.data(),     sizeof(rv32snap_csr_s), csrs.size(),     fp) != csrs.size();
+    error |= fread(hdl_regs.data(), sizeof(rv32snap_reg_s), hdl_regs.size(), fp) != hdl_regs.size();
+    error |= fread(blocks.data(),   sizeof(uint32_t),       blocks.size(),   fp) != blocks.size();
+
+    fclose(fp);
+
+    if (error)
+    {
+        fprintf(stderr, "**ERROR: snapshot file %s truncated\n", fname);
+        return 1;
+    }
+
+    // Index the saved blocks by address
+    std::map<uint32_t, const uint32_t*> saved;
+    for (size_t idx = 0; idx < blocks.size(); idx += RV32SNAP_BLOCK_WORDS + 1)
+    {
+        saved[blocks[idx]] = &blocks[idx + 1];
+    }
+
+    // Write every block of the regions, so that memory not in the snapshot
+    // is zero, as it was when saved
+    uint32_t zero_block[RV32SNAP_BLOCK_WORDS] = { 0 };
+
+    for (int ridx = 0; ridx < num_regions; ridx++)
+    {
+        for (uint32_t offset = 0; offset < regions[ridx].len; offset += RV32SNAP_BLOCK_BYTES)
+        {
+            uint32_t addr = regions[ridx].addr + offset;
+            auto     it   = saved.find(addr);
+
+            if (mem(addr, (uint32_t*)(it != saved.end() ? it->second : zero_block), RV32SNAP_BLOCK_WORDS, true))
+            {
+                return 1;
+            }
+        }
+    }
+
+    // Resynchronise the HDL registers
+    for (auto &r : hdl_regs)
+    {
+        if (mem(r.addr, &r.val, 1, true))
+        {
+            return 1;
+        }
+    }
+
+    for (auto &c : csrs)
+    {
+        if (c.addr < sizeof(hs.csr)/sizeof(hs.csr[0]))
+        {
+            hs.csr[c.addr] = c.val;
+        }
+    }
+
+    cpu->rv32_set_cpu_state(hs);
+    cpu->set_priv_lvl(hdr.priv_lvl);
+    cpu->set_clk_cycles(hdr.cycles);
+
+    return 0;
+}
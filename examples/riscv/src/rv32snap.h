@@ -0,0 +1,74 @@
+/**************************************************************/
+/* rv32snap.h                                Date: 2024/06/12 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell. All rights reserved.   */
+/*                                                            */
+/**************************************************************/
+
+#ifndef _RV32SNAP_H_
+#define _RV32SNAP_H_
+
+#include <cstdint>
+
+#include "rv32_vproc.h"
+
+// Snapshot of a hart's state: registers, CSRs, privilege level, cycle
+// count, memory regions and a set of HDL registers (e.g. the timer) that
+// are written back on restore to resynchronise the HDL with the ISS.
+// Memory is saved in blocks, with all zero blocks omitted to keep the
+// file compact.
+//
+// File format (little endian):
+//   rv32snap_hdr_s
+//   uint64_t x[32], f[32], pc
+//   num_csrs   x rv32snap_csr_s
+//   num_regs   x rv32snap_reg_s
+//   num_blocks x {uint32_t addr, uint8_t data[RV32SNAP_BLOCK_BYTES]}
+
+#define RV32SNAP_MAGIC                          "RV32SNP"
+#define RV32SNAP_VERSION                        1
+#define RV32SNAP_BLOCK_BYTES                    1024
+#define RV32SNAP_BLOCK_WORDS                    (RV32SNAP_BLOCK_BYTES/4)
+
+struct rv32snap_hdr_s {
+    char           magic[8];
+    uint32_t       version;
+    uint32_t       hart;
+    uint32_t       priv_lvl;
+    uint32_t       num_csrs;
+    uint32_t       num_regs;
+    uint32_t       num_blocks;
+    uint64_t       cycles;
+    uint64_t       instret;
+};
+
+struct rv32snap_csr_s {
+    uint32_t       addr;
+    uint32_t       rsvd;
+    uint64_t       val;
+};
+
+struct rv32snap_reg_s {
+    uint32_t       addr;
+    uint32_t       val;
+};
+
+// Memory region to save, in multiples of RV32SNAP_BLOCK_BYTES
+struct rv32snap_region_s {
+    uint32_t       addr;
+    uint32_t       len;
+};
+
+// Word aligned memory/register block access function, used to save
+// and restore memory and HDL registers. Returns non-zero on error.
+typedef int (*p_rv32snap_mem_t)(const uint32_t addr, uint32_t* data, const uint32_t words, const bool write);
+
+extern int rv32snap_save    (const char* fname, rv32_vproc* cpu, const uint32_t hart,
+                             const rv32snap_region_s* regions, const int num_regions,
+                             const uint32_t* regs, const int num_regs, p_rv32snap_mem_t mem);
+
+extern int rv32snap_restore (const char* fname, rv32_vproc* cpu,
+                             const rv32snap_region_s* regions, const int num_regions,
+                             p_rv32snap_mem_t mem);
+
+#endif
@@ -0,0 +1,120 @@
+/**************************************************************/
+/* rv32trace.cpp                             Date: 2024/05/27 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell. All rights reserved.   */
+/*                                                            */
+/**************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+
+#include "rv32trace.h"
+
+// ---------------------------------------------
+// Trace writer state. Records are buffered and
+// written to file when the buffer is full or,
+// in ring mode, the buffer wraps and only the
+// last ring_recs records are written on close.
+// Each hart runs in its own thread, so has its
+// own trace.
+// ---------------------------------------------
+
+static thread_local FILE*            trace_fp      = NULL;
+static thread_local rv32trace_rec_s* trace_buf     = NULL;
+static thread_local uint32_t         trace_recs    = 0;
+static thread_local uint32_t         trace_idx     = 0;
+static thread_local bool             trace_ring    = false;
+static thread_local bool             trace_wrapped = false;
+static thread_local rv32trace_hdr_s  trace_hdr;
+
+// ---------------------------------------------
+// Open a trace file, with a ring buffer of
+// ring_recs records, or streamed if 0. Returns
+// non-zero on error.
+// ---------------------------------------------
+
+int rv32trace_open(const char* fname, const uint32_t ring_recs, const uint32_t hart)
+{
+    if ((trace_fp = fopen(fname, "wb")) == NULL)
+    {
+        fprintf(stderr, "**ERROR: unable to open trace file %s for writing\n", fname);
+        return 1;
+    }
+
+    trace_ring    = ring_recs != 0;
+    trace_recs    = trace_ring ? ring_recs : RV32TRACE_BUF_RECS;
+    trace_idx     = 0;
+    trace_wrapped = false;
+
+    if ((trace_buf = (rv32trace_rec_s*)malloc(trace_recs * sizeof(rv32trace_rec_s))) == NULL)
+    {
+        fprintf(stderr, "**ERROR: unable to allocate trace buffer\n");
+        fclose(trace_fp);
+        trace_fp = NULL;
+        return 1;
+    }
+
+    memset(&trace_hdr, 0, sizeof(trace_hdr));
+    strncpy(trace_hdr.magic, RV32TRACE_MAGIC, sizeof(trace_hdr.magic));
+    trace_hdr.version  = RV32TRACE_VERSION;
+    trace_hdr.rec_size = sizeof(rv32trace_rec_s);
+    trace_hdr.hart     = hart;
+
+    // Write a placeholder header, updated on close
+    fwrite(&trace_hdr, sizeof(trace_hdr), 1, trace_fp);
+
+    return 0;
+}
+
+// ---------------------------------------------
+// Add a record to the trace
+// ---------------------------------------------
+
+void rv32trace_write(const rv32trace_rec_s &rec)
+{
+    trace_buf[trace_idx++] = rec;
+
+    if (trace_idx == trace_recs)
+    {
+        if (trace_ring)
+        {
+            trace_wrapped = true;
+        }
+        else
+        {
+            fwrite(trace_buf, sizeof(rv32trace_rec_s), trace_recs, trace_fp);
+        }
+
+        trace_idx = 0;
+    }
+}
+
+// ---------------------------------------------
+// Flush any buffered records, oldest first,
+// and close the trace file
+// ---------------------------------------------
+
+void rv32trace_close(void)
+{
+    if (trace_fp == NULL)
+    {
+        return;
+    }
+
+    if (trace_wrapped)
+    {
+        fwrite(&trace_buf[trace_idx], sizeof(rv32trace_rec_s), trace_recs - trace_idx, trace_fp);
+    }
+
+    fwrite(trace_buf, sizeof(rv32trace_rec_s), trace_idx, trace_fp);
+
+    trace_hdr.wrapped = trace_wrapped;
+    fseek(trace_fp, 0, SEEK_SET);
+    fwrite(&trace_hdr, sizeof(trace_hdr), 1, trace_fp);
+
+    fclose(trace_fp);
+    free(trace_buf);
+
+    trace_fp  = NULL;
+    trace_buf = NULL;
+}
@@ -0,0 +1,47 @@
+/**************************************************************/
+/* rv32trace.h                               Date: 2024/05/27 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell. All rights reserved.   */
+/*                                                            */
+/**************************************************************/
+
+#ifndef _RV32TRACE_H_
+#define _RV32TRACE_H_
+
+#include <cstdio>
+#include <cstdint>
+
+// Binary instruction trace file format. A header followed by fixed size
+// records, one per executed instruction, in execution order. Compressed
+// instructions are recorded in their expanded 32 bit form, as for the
+// ISS's disassembly.
+
+#define RV32TRACE_MAGIC                         "RV32TRC"
+#define RV32TRACE_VERSION                       1
+
+#define RV32TRACE_FLAG_COMPRESSED               0x00000001
+
+// Number of records buffered before writing to file, when not a ring
+#define RV32TRACE_BUF_RECS                      65536
+
+struct rv32trace_hdr_s {
+    char           magic[8];
+    uint32_t       version;
+    uint32_t       rec_size;
+    uint32_t       hart;
+    uint32_t       wrapped;     // Non-zero if ring buffer overwrote older records
+};
+
+struct rv32trace_rec_s {
+    uint32_t       pc;
+    uint32_t       instr;       // Instruction, expanded if compressed
+    uint32_t       rd_val;      // Value of x[rd] after execution
+    uint32_t       flags;
+    uint64_t       cycle;       // Cycle count at completion
+};
+
+extern int  rv32trace_open  (const char* fname, const uint32_t ring_recs, const uint32_t hart);
+extern void rv32trace_write (const rv32trace_rec_s &rec);
+extern void rv32trace_close (void);
+
+#endif
@@ -0,0 +1,378 @@
+// -----------------------------------------------------------------------------
+//  Title      : Multi-hart test bench for RISC-V virtual processors
+//  Project    : UNKNOWN
+// -----------------------------------------------------------------------------
+//  File       : test_mh.v
+//  Author     : Simon Southwell
+//  Created    : 2024-05-20
+//  Standard   : Verilog 2001
+// -----------------------------------------------------------------------------
+//  Description:
+//  This block defines a top level test bench for a cluster of NUM_HARTS rv32
+//  ISS harts co-simulating with Verilog, each on its own VProc node. Each hart
+//  has private instruction and data memories (the same map as test.v), with a
+//  shared memory, timer, UART and simulation control reached over a round
+//  robin arbitrated bus. The bus may be locked by a hart for atomic accesses.
+// -----------------------------------------------------------------------------
+//  Copyright (c) 2024 Simon Southwell
+// -----------------------------------------------------------------------------
+//
+//  This is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation(), either version 3 of the License(), or
+//  (at your option) any later version.
+//
+//  It is distributed in the hope that it will be useful(),
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+
+`timescale 1ns/1ps
+
+`define RESET_PERIOD     10
+
+`define MEMSEG           4'h0
+`define UARTSEG          4'h8
+
+`define IMEM_SUBSEGMENT  4'h0
+`define SHMEM_SUBSEGMENT 4'h4
+`define DMEM_SUBSEGMENT  4'h8
+
+`define TIMERSTARTADDR   32'hAFFFFFE0
+`define TIMERENDADDR     32'hAFFFFFEC
+
+`define LOCK_ADDR        32'hAFFFFFF0
+`define HALT_ADDR        32'hAFFFFFF8
+`define INT_ADDR         32'hAFFFFFFC
+
+module test_mh
+#(parameter GUI_RUN          = 0,
+            CLK_FREQ_MHZ     = 100,
+            NUM_HARTS        = 4,
+            VCD_DUMP         = 0,
+            DISABLE_DELTA    = 0,
+            TIMEOUTCOUNT     = 0);
+
+localparam  IDX_WIDTH        = 3;
+
+// Clock, reset and simulation control state
+reg            clk;
+wire           reset_n;
+integer        count;
+
+// Concatenated hart buses to the arbiter
+wire [NUM_HARTS*32-1:0] h_address;
+wire [NUM_HARTS-1:0]    h_write;
+wire [NUM_HARTS*32-1:0] h_writedata;
+wire [NUM_HARTS*4-1:0]  h_byteenable;
+wire [NUM_HARTS-1:0]    h_read;
+wire [NUM_HARTS-1:0]    h_waitrequest;
+
+// Shared bus
+wire [31:0]    address;
+wire           write;
+wire [31:0]    writedata;
+wire  [3:0]    byteenable;
+wire           read;
+wire [31:0]    readdata;
+wire           waitrequest;
+wire [31:0]    shreaddata;
+wire [31:0]    timreaddata;
+wire [31:0]    uartreaddata;
+wire [IDX_WIDTH-1:0] owner;
+
+reg            readdatavalid;
+reg  [NUM_HARTS-1:0] swirq;
+reg  [NUM_HARTS-1:0] halted;
+
+wire           timirq;
+
+// -----------------------------------------------
+// Initialisation, clock and reset
+// -----------------------------------------------
+
+initial
+begin
+    // If enabled, dump all the signals to a VCD file
+    if (VCD_DUMP != 0)
+    begin
+      $dumpfile("waves.vcd");
+      $dumpvars(0, test_mh);
+    end
+
+   count                               = -1;
+   clk                                 = 1'b1;
+   swirq                               = {NUM_HARTS{1'b0}};
+   halted                              = {NUM_HARTS{1'b0}};
+   readdatavalid                       = 1'b0;
+end
+
+// Generate a clock
+always #(500/CLK_FREQ_MHZ) clk         = ~clk;
+
+// Generate a reset signal using count
+assign reset_n                         = (count >= `RESET_PERIOD) ? 1'b1 : 1'b0;
+
+// -----------------------------------------------
+// Shared bus address decode
+// -----------------------------------------------
+
+wire cs_sh   =  address[31:28] == `MEMSEG && address[19:16] == `SHMEM_SUBSEGMENT && (read == 1'b1 || write == 1'b1);
+wire cs_tim  =  (read == 1'b1 || write ==1'b1) && address >= `TIMERSTARTADDR && address <= `TIMERENDADDR;
+wire cs_uart =  (read == 1'b1 || write ==1'b1) && address[31:28] == `UARTSEG;
+wire cs_int  =  write == 1'b1 && address == `INT_ADDR;
+wire cs_halt =  write == 1'b1 && address == `HALT_ADDR;
+
+// Peripheral accesses have a wait state
+assign waitrequest = read & (cs_tim | cs_uart) & ~readdatavalid;
+
+assign readdata    = cs_tim  ? timreaddata  :
+                     cs_uart ? uartreaddata :
+                               shreaddata;
+
+// -----------------------------------------------
+// Simulation control process. The simulation
+// finishes when all the harts have halted.
+// -----------------------------------------------
+
+always @(posedge clk)
+begin
+  count                                <= count + 1;
+
+  if (cs_halt == 1'b1 && writedata[0])
+  begin
+    halted[owner]                      <= 1'b1;
+  end
+
+  if ((TIMEOUTCOUNT && count == TIMEOUTCOUNT) || &halted)
+  begin
+    if (count >= TIMEOUTCOUNT && TIMEOUTCOUNT > 0)
+    begin
+      $display("***ERROR: simulation timed out!");
+    end
+
+    if (GUI_RUN == 0)
+    begin
+      $finish;
+    end
+    else
+    begin
+      $stop;
+    end
+  end
+end
+
+// -----------------------------------------------
+// Software IRQ generation. Byte 1 of the write
+// data selects the hart.
+// -----------------------------------------------
+
+always @(posedge clk)
+begin
+  if (cs_int == 1'b1 && byteenable[0] == 1'b1 && writedata[15:8] < NUM_HARTS)
+  begin
+    swirq[writedata[15:8]]             <= writedata[0];
+  end
+end
+
+always @(posedge clk)
+begin
+  // Generate a read data valid signal only after a wait state for
+  // a peripheral access
+  readdatavalid                        <= waitrequest;
+end
+
+// -----------------------------------------------
+// Harts, each with private memories
+// -----------------------------------------------
+
+genvar h;
+generate
+  for (h = 0; h < NUM_HARTS; h = h + 1)
+  begin : hart
+
+    wire [31:0] daddress;
+    wire        dwrite;
+    wire [31:0] dwritedata;
+    wire  [3:0] dbyteenable;
+    wire        dread;
+    wire [31:0] dreaddata;
+    wire [31:0] romreaddata;
+    wire [31:0] memreaddata;
+    wire [31:0] iaddress;
+    wire        iread;
+    wire [31:0] ireaddata;
+
+    // The timer interrupt goes only to hart 0
+    wire  [2:0] irq      = {swirq[h], (h == 0) ? timirq : 1'b0, 1'b0};
+
+    // Private memory decode. Everything else goes to the shared bus.
+    wire        loc_rom  = daddress[31:28] == `MEMSEG && daddress[19:16] == `IMEM_SUBSEGMENT;
+    wire        loc_mem  = daddress[31:28] == `MEMSEG && daddress[19:16] == `DMEM_SUBSEGMENT;
+    wire        is_local = loc_rom | loc_mem;
+
+    wire        cs0      = iaddress[31:28] == `MEMSEG && iaddress[19:16] == `IMEM_SUBSEGMENT && iread == 1'b1;
+    wire        cs1      = loc_rom && (dread == 1'b1 || dwrite == 1'b1);
+    wire        cs4      = loc_mem && (dread == 1'b1 || dwrite == 1'b1);
+
+    assign h_address   [h*32 +: 32] = daddress;
+    assign h_writedata [h*32 +: 32] = dwritedata;
+    assign h_byteenable[h*4  +: 4]  = dbyteenable;
+    assign h_write[h]               = dwrite & ~is_local;
+    assign h_read[h]                = dread  & ~is_local;
+
+    assign dreaddata    = cs1 ? romreaddata :
+                          cs4 ? memreaddata :
+                                readdata;
+
+    riscVsim  #(.NODE          (h),
+                .USE_HARVARD   (1),
+                .DISABLE_DELTA (DISABLE_DELTA)) cpu
+              (.clk               (clk),
+
+               .daddress          (daddress),
+               .dwrite            (dwrite),
+               .dwritedata        (dwritedata),
+               .dbyteenable       (dbyteenable),
+               .dread             (dread),
+               .dreaddata         (dreaddata),
+               .dwaitrequest      (is_local ? 1'b0 : h_waitrequest[h]),
+
+               .iaddress          (iaddress),
+               .iread             (iread),
+               .ireaddata         (ireaddata),
+               .iwaitrequest      (1'b0),
+
+               .irq               (irq)
+              );
+
+    Mem r     (.clk                (clk),
+
+               .CS0                (cs0),
+               .A0                 (iaddress[15:2]),
+               .BE0                (4'hf),
+               .WE0                (1'b0),
+               .DI0                (32'h0),
+               .DO0                (ireaddata),
+
+               .CS1                (cs1),
+               .A1                 (daddress[15:2]),
+               .BE1                (dbyteenable),
+               .WE1                (dwrite),
+               .DI1                (dwritedata),
+               .DO1                (romreaddata)
+              );
+
+    Mem m     (.clk                (clk),
+
+               .CS0                (1'b0),
+               .A0                 (14'h0),
+               .BE0                (4'hf),
+               .WE0                (1'b0),
+               .DI0                (32'h0),
+               .DO0                (),
+
+               .CS1                (cs4),
+               .A1                 (daddress[15:2]),
+               .BE1                (dbyteenable),
+               .WE1                (dwrite),
+               .DI1                (dwritedata),
+               .DO1                (memreaddata)
+              );
+  end
+endgenerate
+
+// ---------------------------------------------------------
+// Shared bus arbiter
+// ---------------------------------------------------------
+
+ bus_arbiter #(.NUM_MASTERS (NUM_HARTS),
+               .IDX_WIDTH   (IDX_WIDTH),
+               .LOCK_ADDR   (`LOCK_ADDR)) arb
+           (
+             .clk               (clk),
+
+             .m_address         (h_address),
+             .m_write           (h_write),
+             .m_writedata       (h_writedata),
+             .m_byteenable      (h_byteenable),
+             .m_read            (h_read),
+             .m_readdata        (),
+             .m_waitrequest     (h_waitrequest),
+
+             .s_address         (address),
+             .s_write           (write),
+             .s_writedata       (writedata),
+             .s_byteenable      (byteenable),
+             .s_read            (read),
+             .s_readdata        (readdata),
+             .s_waitrequest     (waitrequest),
+
+             .owner             (owner)
+           );
+
+ // ---------------------------------------------------------
+ // Shared memory
+ // ---------------------------------------------------------
+
+ Mem sh    (.clk                (clk),
+
+            .CS0                (1'b0),
+            .A0                 (14'h0),
+            .BE0                (4'hf),
+            .WE0                (1'b0),
+            .DI0                (32'h0),
+            .DO0                (),
+
+            .CS1                (cs_sh),
+            .A1                 (address[15:2]),
+            .BE1                (byteenable),
+            .WE1                (write),
+            .DI1                (writedata),
+            .DO1                (shreaddata)
+           );
+
+ // ---------------------------------------------------------
+ // Timer
+ // ---------------------------------------------------------
+
+ mtimer #(.CLKFREQMHZ (CLK_FREQ_MHZ)) timer
+           (
+             .clk               (clk),
+             .nreset            (reset_n),
+
+             .cs                (cs_tim),
+             .addr              (address[3:2]),
+             .wr                (write),
+             .wdata             (writedata),
+             .rd                (read),
+             .rdata             (timreaddata),
+             .rvalid            (),
+
+             .irq               (timirq)
+           );
+
+ // ---------------------------------------------------------
+ // UART
+ // ---------------------------------------------------------
+
+  uart_model console
+           (
+             .clk               (clk),
+             .nreset            (reset_n),
+
+             .cs                (cs_uart),
+             .addr              (address[4:0]),
+             .wr                (write),
+             .wdata             (writedata),
+             .rd                (read),
+             .rdata             (uartreaddata),
+             .rvalid            ()
+           );
+
+endmodule
@@ -0,0 +1,434 @@
+/**************************************************************/
+/* rv32trace.cpp                             Date: 2024/05/27 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell. All rights reserved.   */
+/*                                                            */
+/**************************************************************/
+//
+// Offline decoder for binary instruction traces generated by
+// the VProc rv32 example (the -x option). The disassembly is in
+// the same format as the ISS's run-time disassembly (-r).
+//
+// Usage: rv32trace [-a][-v][-s <start>][-n <count>] <trace file>
+//
+//   -a  Use ABI register names
+//   -v  Append register write values and cycle counts
+//   -s  Skip the first <start> records
+//   -n  Display at most <count> records
+//
+// Decodes RV32IMAFD, Zicsr and Zifencei (compressed instructions
+// being recorded in their expanded form). Other instructions
+// are displayed as reserved.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#if !defined _WIN32 && !defined _WIN64
+#include <unistd.h>
+#else
+extern "C" {
+    extern int getopt(int nargc, char** nargv, const char* ostr);
+    extern char* optarg;
+    extern int   optind;
+}
+#endif
+
+#include "rv32trace.h"
+
+#define MNEMONIC_WIDTH                          9
+#define NUM_STR_BUFS                            4
+
+// Instruction formats, matching the ISS disassembly formats
+enum fmt_e {
+    FMT_R, FMT_RA, FMT_I, FMT_IL, FMT_S, FMT_B, FMT_U, FMT_J, FMT_IF, FMT_ICSR, FMT_ICSRI, FMT_SYS,
+    FMT_RF, FMT_RFCMP, FMT_RFCVT1, FMT_RFCVT2, FMT_RFCVT3, FMT_R4, FMT_IFL, FMT_SFS, FMT_RSVD
+};
+
+static const char* rmap_str[32] = { "zero", "ra", "sp",  "gp",  "tp", "t0", "t1", "t2",
+                                    "s0",   "s1", "a0",  "a1",  "a2", "a3", "a4", "a5",
+                                    "a6",   "a7", "s2",  "s3",  "s4", "s5", "s6", "s7",
+                                    "s8",   "s9", "s10", "s11", "t3", "t4", "t5", "t6"};
+
+static const char* xmap_str[32] = { "x0",  "x1",  "x2",  "x3",  "x4",  "x5",  "x6",  "x7",
+                                    "x8",  "x9",  "x10", "x11", "x12", "x13", "x14", "x15",
+                                    "x16", "x17", "x18", "x19", "x20", "x21", "x22", "x23",
+                                    "x24", "x25", "x26", "x27", "x28", "x29", "x30", "x31"};
+
+static const char* fmap_str[32] = { "ft0", "ft1", "ft2",  "ft3",  "ft4", "ft5", "ft6",  "ft7",
+                                    "fs0", "fs1", "fa0",  "fa1",  "fa2", "fa3", "fa4",  "fa5",
+                                    "fa6", "fa7", "fs2",  "fs3",  "fs4", "fs5", "fs6",  "fs7",
+                                    "fs8", "fs9", "fs10", "fs11", "ft8", "ft9", "ft10", "ft11"};
+
+static const char* fxmap_str[32] = { "f0",  "f1",  "f2",  "f3",  "f4",  "f5",  "f6",  "f7",
+                                     "f8",  "f9",  "f10", "f11", "f12", "f13", "f14", "f15",
+                                     "f16", "f17", "f18", "f19", "f20", "f21", "f22", "f23",
+                                     "f24", "f25", "f26", "f27", "f28", "f29", "f30", "f31"};
+
+static const char* op_str[8]    = { "add",  "sll",  "slt",  "sltu",  "xor",  "srl",  "or",   "and"  };
+static const char* opi_str[8]   = { "addi", "slli", "slti", "sltiu", "xori", "srli", "ori",  "andi" };
+static const char* mul_str[8]   = { "mul",  "mulh", "mulhsu", "mulhu", "div", "divu", "rem", "remu" };
+static const char* ld_str[8]    = { "lb",   "lh",   "lw",   NULL,    "lbu",  "lhu",  NULL,   NULL   };
+static const char* st_str[8]    = { "sb",   "sh",   "sw",   NULL,    NULL,   NULL,   NULL,   NULL   };
+static const char* br_str[8]    = { "beq",  "bne",  NULL,   NULL,    "blt",  "bge",  "bltu", "bgeu" };
+static const char* csr_str[8]   = { NULL,   "csrrw", "csrrs", "csrrc", NULL, "csrrwi", "csrrsi", "csrrci" };
+
+// Single and double precision variants, indexed by the fmt field
+static const char* fma_str[4][2] = { {"fmadd.s",  "fmadd.d"},  {"fmsub.s",  "fmsub.d"},
+                                     {"fnmsub.s", "fnmsub.d"}, {"fnmadd.s", "fnmadd.d"} };
+static const char* fop_str[4][2] = { {"fadd.s",   "fadd.d"},   {"fsub.s",   "fsub.d"},
+                                     {"fmul.s",   "fmul.d"},   {"fdiv.s",   "fdiv.d"} };
+static const char* fsgn_str[3][2]= { {"fsgnj.s",  "fsgnj.d"},  {"fsgnjn.s", "fsgnjn.d"}, {"fsgnjx.s", "fsgnjx.d"} };
+static const char* fmin_str[2][2]= { {"fmin.s",   "fmin.d"},   {"fmax.s",   "fmax.d"} };
+static const char* fcmp_str[3][2]= { {"fle.s",    "fle.d"},    {"flt.s",    "flt.d"},    {"feq.s",    "feq.d"} };
+static const char* fcvtw_str[2][2]={ {"fcvt.w.s", "fcvt.w.d"}, {"fcvt.wu.s","fcvt.wu.d"} };
+static const char* fcvtf_str[2][2]={ {"fcvt.s.w", "fcvt.d.w"}, {"fcvt.s.wu","fcvt.d.wu"} };
+
+static bool abi_en = false;
+
+static char str[NUM_STR_BUFS][16];
+static int  str_idx = 0;
+
+// ---------------------------------------------
+// Register name followed by a comma (as the ISS's
+// rmap() and fmap())
+// ---------------------------------------------
+
+static const char* rmap(const uint32_t r)
+{
+    str_idx = (str_idx + 1) % NUM_STR_BUFS;
+
+    snprintf(str[str_idx], sizeof(str[0]), "%s,", abi_en ? rmap_str[r] : xmap_str[r]);
+
+    return str[str_idx];
+}
+
+static const char* fmap(const uint32_t r)
+{
+    str_idx = (str_idx + 1) % NUM_STR_BUFS;
+
+    snprintf(str[str_idx], sizeof(str[0]), "%s,", abi_en ? fmap_str[r] : fxmap_str[r]);
+
+    return str[str_idx];
+}
+
+static const char* reg(const uint32_t r)
+{
+    return abi_en ? rmap_str[r] : xmap_str[r];
+}
+
+static const char* freg(const uint32_t r)
+{
+    return abi_en ? fmap_str[r] : fxmap_str[r];
+}
+
+// ---------------------------------------------
+// Decode an instruction's mnemonic and format
+// ---------------------------------------------
+
+static const char* decode(const uint32_t instr, fmt_e &fmt)
+{
+    uint32_t opcode = instr & 0x7f;
+    uint32_t funct3 = (instr >> 12) & 0x7;
+    uint32_t funct7 = instr >> 25;
+    uint32_t rs2    = (instr >> 20) & 0x1f;
+    uint32_t dp     = funct7 & 0x1;
+    const char* mnem = NULL;
+
+    fmt = FMT_RSVD;
+
+    // Fields are decoded as the ISS decodes them, so that encodings it
+    // executes despite reserved bits (e.g. a non-zero jalr funct3) are
+    // displayed as it displays them
+    switch (opcode)
+    {
+    case 0x37: fmt = FMT_U;  mnem = "lui";   break;
+    case 0x17: fmt = FMT_U;  mnem = "auipc"; break;
+    case 0x6f: fmt = FMT_J;  mnem = "jal";   break;
+    case 0x67: fmt = FMT_I;  mnem = "jalr";  break;
+    case 0x63: fmt = FMT_B;  mnem = br_str[funct3]; break;
+    case 0x03: fmt = FMT_IL; mnem = ld_str[funct3]; break;
+    case 0x23: fmt = FMT_S;  mnem = st_str[funct3]; break;
+    case 0x13:
+        fmt  = FMT_I;
+        if (funct3 == 5)
+        {
+            mnem = (funct7 == 0x20) ? "srai" : (funct7 == 0) ? "srli" : NULL;
+        }
+        else
+        {
+            mnem = opi_str[funct3];
+        }
+        break;
+    case 0x33:
+        fmt  = FMT_R;
+        if (funct7 == 0x01)
+        {
+            mnem = mul_str[funct3];
+        }
+        else if (funct7 == 0x20)
+        {
+            mnem = (funct3 == 0) ? "sub" : (funct3 == 5) ? "sra" : NULL;
+        }
+        else if (funct7 == 0)
+        {
+            mnem = op_str[funct3];
+        }
+        break;
+    case 0x0f: fmt = FMT_IF; mnem = "fence"; break;
+    case 0x2f:
+        // The ISS displays the AMO logical and min/max operations in R format
+        fmt = ((instr >> 27) >= 0x0c) ? FMT_R : FMT_RA;
+        if (funct3 == 2)
+        {
+            switch (instr >> 27)
+            {
+            case 0x00: mnem = "amoadd.w";  break;
+            case 0x01: mnem = "amoswap.w"; break;
+            case 0x02: mnem = "lr.w";      break;
+            case 0x03: mnem = "sc.w";      break;
+            case 0x04: mnem = "amoxor.w";  break;
+            case 0x08: mnem = "amoor.w";   break;
+            case 0x0c: mnem = "amoand.w";  break;
+            case 0x10: mnem = "amomin.w";  break;
+            case 0x14: mnem = "amomax.w";  break;
+            case 0x18: mnem = "amominu.w"; break;
+            case 0x1c: mnem = "amomaxu.w"; break;
+            }
+        }
+        break;
+    case 0x73:
+        if (funct3 == 0)
+        {
+            // The ISS only decodes the rs2 field, and executes uret and sret as mret
+            fmt = FMT_SYS;
+            switch (rs2)
+            {
+            case 0x00: mnem = "ecall";  break;
+            case 0x01: mnem = "ebreak"; break;
+            case 0x02: mnem = "mret";   break;
+            case 0x05: mnem = "wfi";    break;
+            }
+        }
+        else
+        {
+            fmt  = (funct3 & 0x4) ? FMT_ICSRI : FMT_ICSR;
+            mnem = csr_str[funct3];
+        }
+        break;
+    case 0x07:
+        fmt  = FMT_IFL;
+        mnem = (funct3 == 3) ? "fld" : "flw";
+        break;
+    case 0x27:
+        fmt  = FMT_SFS;
+        mnem = (funct3 == 3) ? "fsd" : "fsw";
+        break;
+    case 0x43:
+    case 0x47:
+    case 0x4b:
+    case 0x4f:
+        fmt  = FMT_R4;
+        mnem = fma_str[(opcode >> 2) & 0x3][(funct7 & 0x3) ? 1 : 0];
+        break;
+    case 0x53:
+        fmt  = FMT_RF;
+        switch (funct7 & 0x7e)
+        {
+        case 0x00:
+        case 0x04:
+        case 0x08:
+        case 0x0c: mnem = fop_str[funct7 >> 2][dp]; break;
+        case 0x2c: mnem = dp ? "fsqrt.d" : "fsqrt.s"; break;
+        case 0x10: mnem = (funct3 < 3) ? fsgn_str[funct3][dp] : NULL; break;
+        case 0x14: mnem = (funct3 < 2) ? fmin_str[funct3][dp] : NULL; break;
+        case 0x50: fmt = FMT_RFCMP;  mnem = (funct3 < 3) ? fcmp_str[funct3][dp] : NULL; break;
+        case 0x60: fmt = FMT_RFCVT1; mnem = fcvtw_str[rs2 ? 1 : 0][dp]; break;
+        case 0x68: fmt = FMT_RFCVT2; mnem = fcvtf_str[rs2 ? 1 : 0][dp]; break;
+        case 0x70:
+            fmt  = FMT_RFCVT1;
+            mnem = (funct3 == 1) ? (dp ? "fclass.d" : "fclass.s") : (funct3 == 0 && !dp) ? "fmv.x.w" : NULL;
+            break;
+        case 0x78: fmt = FMT_RFCVT2; mnem = dp ? NULL : "fmv.w.x"; break;
+        case 0x20: fmt = FMT_RFCVT3; mnem = dp ? "fcvt.d.s" : "fcvt.s.d"; break;
+        }
+        break;
+    }
+
+    if (mnem == NULL)
+    {
+        fmt  = FMT_RSVD;
+        mnem = "reserved";
+    }
+
+    return mnem;
+}
+
+// ---------------------------------------------
+// Display a single trace record
+// ---------------------------------------------
+
+static void disassemble(const rv32trace_rec_s &rec, const bool verbose)
+{
+    uint32_t instr = rec.instr;
+    uint32_t rd    = (instr >> 7)  & 0x1f;
+    uint32_t rs1   = (instr >> 15) & 0x1f;
+    uint32_t rs2   = (instr >> 20) & 0x1f;
+    uint32_t rs3   = instr >> 27;
+    char     cmp   = (rec.flags & RV32TRACE_FLAG_COMPRESSED) ? '\'' : ' ';
+
+    int32_t  imm_i = (int32_t)instr >> 20;
+    int32_t  imm_s = ((int32_t)(instr & 0xfe000000) >> 20) | ((instr >> 7) & 0x1f);
+    int32_t  imm_b = ((int32_t)(instr & 0x80000000) >> 19) | ((instr & 0x80) << 4) |
+                     ((instr >> 20) & 0x7e0) | ((instr >> 7) & 0x1e);
+    int32_t  imm_j = ((int32_t)(instr & 0x80000000) >> 11) | (instr & 0xff000) |
+                     ((instr >> 9) & 0x800) | ((instr >> 20) & 0x7fe);
+
+    fmt_e    fmt;
+    char     mnem[16];
+
+    snprintf(mnem, sizeof(mnem), "%-*s", MNEMONIC_WIDTH, decode(instr, fmt));
+
+    // Shift immediates are the shift amount only
+    if ((instr & 0x7f) == 0x13 && ((instr >> 12) & 0x3) == 1)
+    {
+        imm_i &= 0x1f;
+    }
+
+    switch (fmt)
+    {
+    case FMT_R:     printf("%08x: 0x%08x%c   %s %s %s %s",   rec.pc, instr, cmp, mnem, rmap(rd), rmap(rs1), reg(rs2));        break;
+    case FMT_RA:    printf("%08x: 0x%08x    %s %s %s (%s)",  rec.pc, instr, mnem, rmap(rd), rmap(rs2), reg(rs1));             break;
+    case FMT_I:     printf("%08x: 0x%08x%c   %s %s %s %d",   rec.pc, instr, cmp, mnem, rmap(rd), rmap(rs1), imm_i);           break;
+    case FMT_IL:    printf("%08x: 0x%08x%c   %s %s %d(%s)",  rec.pc, instr, cmp, mnem, rmap(rd), imm_i, reg(rs1));            break;
+    case FMT_S:     printf("%08x: 0x%08x%c   %s %s %d(%s)",  rec.pc, instr, cmp, mnem, rmap(rs2), imm_s, reg(rs1));           break;
+    case FMT_B:     printf("%08x: 0x%08x%c   %s %s %s %d",   rec.pc, instr, cmp, mnem, rmap(rs1), rmap(rs2), imm_b);          break;
+    case FMT_U:     printf("%08x: 0x%08x%c   %s %s 0x%08x",  rec.pc, instr, cmp, mnem, rmap(rd), instr >> 12);                break;
+    case FMT_J:     printf("%08x: 0x%08x%c   %s %s %d",      rec.pc, instr, cmp, mnem, rmap(rd), imm_j);                      break;
+    case FMT_IF:    printf("%08x: 0x%08x    %s %d, %d",      rec.pc, instr, mnem, (imm_i >> 4) & 0xf, imm_i & 0xf);           break;
+    case FMT_ICSR:  printf("%08x: 0x%08x    %s %s 0x%03x, %s", rec.pc, instr, mnem, rmap(rd), instr >> 20, reg(rs1));         break;
+    case FMT_ICSRI: printf("%08x: 0x%08x    %s %s 0x%03x, %d", rec.pc, instr, mnem, rmap(rd), instr >> 20, rs1);              break;
+    case FMT_RF:     printf("%08x: 0x%08x    %s %s %s %s",    rec.pc, instr, mnem, fmap(rd), fmap(rs1), freg(rs2));           break;
+    case FMT_RFCMP:  printf("%08x: 0x%08x    %s %s %s %s",    rec.pc, instr, mnem, rmap(rd), fmap(rs1), freg(rs2));           break;
+    case FMT_RFCVT1: printf("%08x: 0x%08x    %s %s %s",       rec.pc, instr, mnem, rmap(rd), freg(rs1));                      break;
+    case FMT_RFCVT2: printf("%08x: 0x%08x    %s %s %s",       rec.pc, instr, mnem, fmap(rd), reg(rs1));                       break;
+    case FMT_RFCVT3: printf("%08x: 0x%08x    %s %s %s",       rec.pc, instr, mnem, fmap(rd), freg(rs1));                      break;
+    case FMT_R4:     printf("%08x: 0x%08x    %s %s %s %s %s", rec.pc, instr, mnem, fmap(rd), fmap(rs1), fmap(rs2), freg(rs3)); break;
+    case FMT_IFL:    printf("%08x: 0x%08x%c   %s %s %d(%s)",  rec.pc, instr, cmp, mnem, fmap(rd), imm_i, reg(rs1));            break;
+    case FMT_SFS:    printf("%08x: 0x%08x%c   %s %s %d(%s)",  rec.pc, instr, cmp, mnem, fmap(rs2), imm_s, reg(rs1));           break;
+    case FMT_SYS:
+    case FMT_RSVD:  printf("%08x: 0x%08x%c   %s",            rec.pc, instr, cmp, mnem);                                       break;
+    }
+
+    if (verbose)
+    {
+        // Only formats with an integer destination register have a write value
+        bool xdest = fmt != FMT_S   && fmt != FMT_B      && fmt != FMT_IF     && fmt != FMT_SYS && fmt != FMT_RSVD &&
+                     fmt != FMT_RF  && fmt != FMT_RFCVT2 && fmt != FMT_RFCVT3 && fmt != FMT_R4  &&
+                     fmt != FMT_IFL && fmt != FMT_SFS;
+
+        if (xdest && rd != 0)
+        {
+            printf("    ; %s = 0x%08x", reg(rd), rec.rd_val);
+        }
+
+        printf("    @ %llu", (unsigned long long)rec.cycle);
+    }
+
+    printf("\n");
+}
+
+// ---------------------------------------------
+// Main program
+// ---------------------------------------------
+
+int main(int argc, char** argv)
+{
+    bool     verbose = false;
+    uint64_t start   = 0;
+    uint64_t count   = UINT64_MAX;
+    int      c;
+
+    while ((c = getopt(argc, argv, "avs:n:h")) != EOF)
+    {
+        switch (c)
+        {
+        case 'a':
+            abi_en = true;
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        case 's':
+            start = strtoull(optarg, NULL, 0);
+            break;
+        case 'n':
+            count = strtoull(optarg, NULL, 0);
+            break;
+        case 'h':
+        default:
+            fprintf(stderr, "Usage: %s [-a][-v][-s <start>][-n <count>] <trace file>\n", argv[0]);
+            fprintf(stderr, "   -a Use ABI register names\n");
+            fprintf(stderr, "   -v Display register write values and cycle counts\n");
+            fprintf(stderr, "   -s Skip the first <start> records (default 0)\n");
+            fprintf(stderr, "   -n Display at most <count> records (default all)\n");
+            fprintf(stderr, "   -h display this help message\n");
+            return 1;
+        }
+    }
+
+    if (optind >= argc)
+    {
+        fprintf(stderr, "%s: no trace file specified\n", argv[0]);
+        return 1;
+    }
+
+    FILE* fp = fopen(argv[optind], "rb");
+
+    if (fp == NULL)
+    {
+        fprintf(stderr, "%s: unable to open trace file %s\n", argv[0], argv[optind]);
+        return 1;
+    }
+
+    rv32trace_hdr_s hdr;
+
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || strncmp(hdr.magic, RV32TRACE_MAGIC, sizeof(hdr.magic)) ||
+        hdr.version != RV32TRACE_VERSION || hdr.rec_size != sizeof(rv32trace_rec_s))
+    {
+        fprintf(stderr, "%s: %s is not a valid version %d trace file\n", argv[0], argv[optind], RV32TRACE_VERSION);
+        fclose(fp);
+        return 1;
+    }
+
+    if (hdr.wrapped)
+    {
+        printf("# hart %d trace (ring buffer wrapped, earlier records lost)\n", hdr.hart);
+    }
+
+    fseek(fp, (long)(sizeof(hdr) + start * sizeof(rv32trace_rec_s)), SEEK_SET);
+
+    rv32trace_rec_s rec, next;
+    bool            valid = fread(&rec, sizeof(rec), 1, fp) == 1;
+
+    while (valid && count--)
+    {
+        valid = fread(&next, sizeof(next), 1, fp) == 1;
+
+        disassemble(rec, verbose);
+
+        // Mark discontinuities in the PC, as for the ISS's run-time disassembly
+        if (valid && next.pc != rec.pc + ((rec.flags & RV32TRACE_FLAG_COMPRESSED) ? 2 : 4))
+        {
+            printf("    *\n");
+        }
+
+        rec = next;
+    }
+
+    fclose(fp);
+
+    return 0;
+}
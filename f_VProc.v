@@ -36,7 +36,8 @@ module VProc
 #(parameter               INT_WIDTH       = 3,
                           NODE_WIDTH      = 4,
                           BURST_ADDR_INCR = 1,
-                          DISABLE_DELTA   = 0
+                          DISABLE_DELTA   = 0,
+                          IDLE_TIMED      = 0
 )
 (
     // Clock
@@ -99,6 +100,27 @@ integer               TickCount;
 integer               BlkCount;
 integer               AccIdx;
 integer               LBE;
+reg                   TickIrqBrk;
+integer               TickRemain;
+
+// Set from the software to wake the node from a parked wait
+reg                   Wake;
+
+// Clock cycle count and simulation time, passed to VSched, with the time
+// (in this module's time units) split into 31 bit halves
+integer               CycleCount;
+time                  SimTime;
+integer               VPTimeLo;
+integer               VPTimeHi;
+
+// Timed idle state
+reg                   IdleStart;
+reg                   IdleWake;
+realtime              IdleBegin;
+realtime              IdleTime;
+realtime              LastEdge;
+realtime              ClkPeriod;
+integer               IdleEdges;
 
 `ifndef VPROC_BYTE_ENABLE
 // When no byte enable define a local dummy register to
@@ -142,6 +164,14 @@ begin
     Update                              = 0;
     BlkCount                            = 0;
     IntSampLast                         = 0;
+    TickIrqBrk                          = 0;
+    TickRemain                          = 0;
+    Wake                                = 0;
+    CycleCount                          = 0;
+    IdleStart                           = 0;
+    IdleWake                            = 0;
+    LastEdge                            = -1;
+    ClkPeriod                           = 0;
 
     // Don't remove delay! Needed to allow Node to be assigned
     // before the call to VInit
@@ -164,6 +194,19 @@ begin
     NodeI                               = Node;
     VPTicks                             = `DELTACYCLE;
 
+    // Count the cycle and sample the time
+    CycleCount                          = CycleCount + 1;
+    SimTime                             = $time;
+    VPTimeLo                            = SimTime[30:0];
+    VPTimeHi                            = SimTime[62:31];
+
+    // Measure the clock period, for a timed idle, from consecutive edges
+    if (LastEdge >= 0)
+    begin
+        ClkPeriod                       = $realtime - LastEdge;
+    end
+    LastEdge                            = $realtime;
+
     // Wait until the VProc software is initialised for this node (VInit called)
     // before starting accesses
     if (Initialised == 1'b1)
@@ -171,7 +214,7 @@ begin
         // If an interrupt active, call VSched with interrupt value
         if (IntSamp > 0)
         begin
-            `VSched(NodeI, IntSamp, DataInSamp, VPDataOut, VPAddr, VPRW, VPTicks);
+            `VSched(NodeI, IntSamp, DataInSamp, VPDataOut, VPAddr, VPRW, VPTicks, CycleCount, VPTimeLo, VPTimeHi);
 
             // If interrupt routine returns non-zero tick, then override
             // current tick value. Otherwise, leave at present value.
@@ -187,6 +230,23 @@ begin
         begin
           `VIrq(NodeI, IntSamp);
           IntSampLast                   <= IntSamp;
+
+          // If an interruptible tick is still counting, terminate it now, remembering
+          // how many cycles it had left to run
+          if (TickIrqBrk && RD === 1'b0 && WE === 1'b0 && TickCount > 0)
+          begin
+              TickRemain                = TickCount;
+              TickCount                 = 0;
+          end
+        end
+
+        // A node parked on an interruptible tick, while its software waits
+        // on a mailbox or barrier, has the tick ended in the same way when
+        // woken by the software
+        if (Wake && TickIrqBrk && RD === 1'b0 && WE === 1'b0 && TickCount > 0)
+        begin
+            TickRemain                  = TickCount;
+            TickCount                   = 0;
         end
 
         // If tick, write or a read has completed (or in last cycle)...
@@ -197,6 +257,9 @@ begin
             BurstFirst                  <= 1'b0;
             BurstLast                   <= 1'b0;
 
+            // A wake is only for a tick in progress
+            Wake                        = 1'b0;
+
             // Loop accessing new commands until VPTicks is not a delta cycle update
             while (VPTicks < 0)
             begin
@@ -206,6 +269,13 @@ begin
                 // Sample the data in port
                 DataInSamp              = DataIn;
 
+                // An interruptible tick returns its remaining cycle count in place of data
+                if (TickIrqBrk)
+                begin
+                    DataInSamp          = TickRemain;
+                    TickRemain          = 0;
+                end
+
                 if (BlkCount <= 1)
                 begin
                     // If this is the last transfer in a burst, call VAccess with
@@ -218,7 +288,17 @@ begin
                     end
 
                     // Get new access command
-                    `VSched(NodeI, IntSamp, DataInSamp, VPDataOut, VPAddr, VPRW, VPTicks);
+`ifdef VPROC_TWO_PHASE
+                    // Release the user thread, then let the other nodes scheduled in
+                    // this time step do the same before waiting for its command, so
+                    // that the nodes' user code runs concurrently. Under Verilator,
+                    // `MINDELAY is empty, and the two calls are back to back.
+                    `VSchedPost(NodeI, IntSamp, DataInSamp, CycleCount, VPTimeLo, VPTimeHi);
+                    `MINDELAY;
+                    `VSchedCollect(NodeI, VPDataOut, VPAddr, VPRW, VPTicks);
+`else
+                    `VSched(NodeI, IntSamp, DataInSamp, VPDataOut, VPAddr, VPRW, VPTicks, CycleCount, VPTimeLo, VPTimeHi);
+`endif
 
                     // Update the outputs
                     Burst               <= VPRW[`BLKBITS];
@@ -227,6 +307,7 @@ begin
                     BE                  <= VPRW[`BEBITS];
                     LBE                 <= VPRW[`LBEBITS];
                     Addr                <= VPAddr;
+                    TickIrqBrk          = VPRW[`IRQBRKBIT];
 
                     // If new BlkCount is non-zero, setup burst transfer
                     if (VPRW[`BLKBITS] !== 0)
@@ -304,8 +385,59 @@ begin
         begin
             // Count down to zero and stop
             TickCount                   = (TickCount > 0) ? TickCount - 1 : 0;
+
+`ifndef VERILATOR
+            // With a timed idle, wait out the rest of a long tick in one step, with
+            // no activity on the clock edges, until the middle of the cycle before
+            // its last edge, or until the interrupt input changes or the node is
+            // woken. The clock period is assumed not to change while idle.
+            if (IDLE_TIMED != 0 && TickCount > 2 && IntSamp == 0 && ClkPeriod > 0 && RD === 1'b0 && WE === 1'b0)
+            begin
+                IdleBegin               = $realtime;
+                IdleTime                = (TickCount - 0.5) * ClkPeriod;
+                IdleStart               = ~IdleStart;
+
+                @(Interrupt or IdleWake or Wake);
+                disable idle_timer;
+
+                // Count off the clock edges waited through, leaving at least the
+                // last for the next edge
+                IdleEdges               = $rtoi(($realtime - IdleBegin) / ClkPeriod + 0.001);
+                IdleEdges               = (IdleEdges < TickCount) ? IdleEdges : TickCount - 1;
+                TickCount               = TickCount - IdleEdges;
+                CycleCount              = CycleCount + IdleEdges;
+                LastEdge                = -1;
+            end
+`endif
         end
     end
 end
 
+`ifdef VPROC_SV
+`ifndef VERILATOR
+// ------------------------------------------------------------
+// Wakes the node from a parked wait. Called from the
+// software, with this instance's scope set.
+// ------------------------------------------------------------
+
+export "DPI-C" function VWake;
+
+function void VWake();
+    Wake                                = 1'b1;
+endfunction
+`endif
+`endif
+
+`ifndef VERILATOR
+// ------------------------------------------------------------
+// Timed idle wake-up process. Started by the scheduler process,
+// which disables it if woken by an interrupt change first.
+// ------------------------------------------------------------
+
+always @(IdleStart)
+begin : idle_timer
+    #(IdleTime) IdleWake                = ~IdleWake;
+end
+`endif
+
 endmodule
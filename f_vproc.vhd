@@ -32,7 +32,8 @@ entity VProc is
   generic (INT_WIDTH       : integer := 3;
            NODE_WIDTH      : integer := 4;
            BURST_ADDR_INCR : integer := 1;
-           DISABLE_DELTA   : integer := 0
+           DISABLE_DELTA   : integer := 0;
+           IDLE_TIMED      : integer := 0
   );
   port (
     Clk             : in  std_logic;
@@ -69,6 +70,7 @@ constant      BEFIRSTLOBIT : integer := 14;
 constant      BEFIRSTHIBIT : integer := 17;
 constant      BELASTLOBIT  : integer := 18;
 constant      BELASTHIBIT  : integer := 21;
+constant      IRQBRKBIT    : integer := 22;
 constant      DeltaCycle   : integer := -1;
 
 signal        Initialised  : integer := 0;
@@ -99,6 +101,8 @@ begin
     variable TickVal     : integer := 1;
     variable BlkCount    : integer := 0;
     variable AccIdx      : integer := 0;
+    variable TickIrqBrk  : std_logic := '0';
+    variable TickRemain  : integer := 0;
 
     variable DataInSamp  : integer;
     variable IntSamp     : integer;
@@ -106,14 +110,44 @@ begin
     variable RdAckSamp   : std_logic;
     variable WRAckSamp   : std_logic;
 
+    variable CycleCount  : signed(31 downto 0) := (others => '0');
+    variable TimeUnit    : time;
+    variable TimeHiUnit  : time;
+    variable TimeHi      : integer;
+    variable TimeLo      : integer;
+
+    variable IdleBegin   : time;
+    variable LastEdge    : time;
+    variable LastEdgeVld : boolean := false;
+    variable ClkPeriod   : time := 0 ns;
+    variable IdleEdges   : integer;
+
   begin
 
+    -- Simulation time is passed to VSched in 31 bit halves, in units of the
+    -- simulator's resolution, so as not to divide by a time unit that is
+    -- below it (e.g. 1 ps with the 1 ns default of some simulators)
+    TimeUnit                    := std.env.resolution_limit;
+    TimeHiUnit                  := TimeUnit * 1073741824 * 2;
+
     while true loop
 
       -- Can't have a sensitivity list for the process and process delta cycles in VHDL,
       -- so emulate the clock edge with a wait here.
       wait until Clk'event and Clk = '1';
 
+      -- Count the cycle (wrapping, as the count is extended in VSched) and sample the time
+      CycleCount                := CycleCount + 1;
+      TimeHi                    := now / TimeHiUnit;
+      TimeLo                    := (now - TimeHi * TimeHiUnit) / TimeUnit;
+
+      -- Measure the clock period, for a timed idle, from consecutive edges
+      if LastEdgeVld then
+        ClkPeriod               := now - LastEdge;
+      end if;
+      LastEdge                  := now;
+      LastEdgeVld               := true;
+
       -- Cleanly sample the inputs
       DataInSamp                := to_integer(signed(DataIn));
       IntSamp                   := to_integer(signed("0" & Interrupt));
@@ -132,7 +166,10 @@ begin
                  VPDataOut,
                  VPAddr,
                  VPRW,
-                 VPTicks);
+                 VPTicks,
+                 to_integer(CycleCount),
+                 TimeLo,
+                 TimeHi);
 
           -- If interrupt routine returns non-zero tick, then override
           -- current tick value. Otherwise, leave at present value.
@@ -146,6 +183,13 @@ begin
         if IntSamp /= IntSampLast then
           VIrq(to_integer(unsigned(Node)), IntSamp);
           IntSampLast := IntSamp;
+
+          -- If an interruptible tick is still counting, terminate it now, remembering
+          -- how many cycles it had left to run
+          if TickIrqBrk = '1' and RD = '0' and WE = '0' and TickVal > 0 then
+            TickRemain          := TickVal;
+            TickVal             := 0;
+          end if;
         end if;
 
         -- If tick, write or a read has completed (or in last cycle)...
@@ -164,6 +208,12 @@ begin
             -- Sample the data in port
             DataInSamp          := to_integer(signed(DataIn));
 
+            -- An interruptible tick returns its remaining cycle count in place of data
+            if TickIrqBrk = '1' then
+              DataInSamp        := TickRemain;
+              TickRemain        := 0;
+            end if;
+
             if BlkCount <= 1 then
 
               -- If this is the last transfer in a burst, call $vaccess with
@@ -184,7 +234,10 @@ begin
                      VPDataOut,
                      VPAddr,
                      VPRW,
-                     VPTicks);
+                     VPTicks,
+                     to_integer(CycleCount),
+                     TimeLo,
+                     TimeHi);
 
               Burst             <= std_logic_vector(to_unsigned(VPRW, 32)(BLKHIBIT downto BLKLOBIT));
               BE                <= std_logic_vector(to_unsigned(VPRW, 32)(BEFIRSTHIBIT downto BEFIRSTLOBIT));
@@ -192,6 +245,7 @@ begin
               WE                <= to_unsigned(VPRW, 32)(WEbit);
               RD                <= to_unsigned(VPRW, 32)(RDbit);
               Addr              <= std_logic_vector(to_signed(VPAddr, 32));
+              TickIrqBrk        := to_unsigned(VPRW, 32)(IRQBRKBIT);
 
               BlkCount          := to_integer(to_unsigned(VPRW, 32)(BLKHIBIT downto BLKLOBIT));
 
@@ -267,6 +321,26 @@ begin
             TickVal             := 0;
           end if;
 
+          -- With a timed idle, wait out the rest of a long tick in one step, with
+          -- no activity on the clock edges, until the middle of the cycle before
+          -- its last edge, or until the interrupt input changes. The clock period
+          -- is assumed not to change while idle.
+          if IDLE_TIMED /= 0 and TickVal > 2 and IntSamp = 0 and ClkPeriod > 0 ns and RD = '0' and WE = '0' then
+            IdleBegin           := now;
+
+            wait on Interrupt for (TickVal - 1) * ClkPeriod + ClkPeriod / 2;
+
+            -- Count off the clock edges waited through, leaving at least the
+            -- last for the next edge
+            IdleEdges           := (now - IdleBegin) / ClkPeriod;
+            if IdleEdges >= TickVal then
+              IdleEdges         := TickVal - 1;
+            end if;
+            TickVal             := TickVal - IdleEdges;
+            CycleCount          := CycleCount + IdleEdges;
+            LastEdgeVld         := false;
+          end if;
+
         end if;
       end if;
     end loop;
@@ -37,7 +37,10 @@ package vproc_pkg is
     VPDataOut : out integer;
     VPAddr    : out integer;
     VPRw      : out integer;
-    VPTicks   : out integer
+    VPTicks   : out integer;
+    VPCycle   : in  integer;
+    VPTimeLo  : in  integer;
+    VPTimeHi  : in  integer
   );
 attribute foreign of VSched : procedure is "VSched VProc.so";
 --attribute foreign of VSched : procedure is "VHPI VProc.so; VSched";
@@ -83,7 +86,10 @@ package body vproc_pkg is
     VPDataOut : out integer;
     VPAddr    : out integer;
     VPRw      : out integer;
-    VPTicks   : out integer
+    VPTicks   : out integer;
+    VPCycle   : in  integer;
+    VPTimeLo  : in  integer;
+    VPTimeHi  : in  integer
   ) is
   begin
     report "ERROR: foreign subprogram out_params not called";
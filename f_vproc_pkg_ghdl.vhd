@@ -36,7 +36,10 @@ package vproc_pkg is
     VPDataOut : out integer;
     VPAddr    : out integer;
     VPRw      : out integer;
-    VPTicks   : out integer
+    VPTicks   : out integer;
+    VPCycle   : in  integer;
+    VPTimeLo  : in  integer;
+    VPTimeHi  : in  integer
   );
 attribute foreign of VSched : procedure is "VHPIDIRECT ./VProc.so VSched";
 
@@ -78,7 +81,10 @@ package body vproc_pkg is
     VPDataOut : out integer;
     VPAddr    : out integer;
     VPRw      : out integer;
-    VPTicks   : out integer
+    VPTicks   : out integer;
+    VPCycle   : in  integer;
+    VPTimeLo  : in  integer;
+    VPTimeHi  : in  integer
   ) is
   begin
     report "ERROR: foreign subprogram out_params not called";
@@ -67,11 +67,41 @@ class PyVProcClass :
     self.__processIrq()
     return c_uint32(self.read(addr, delta)).value
 
-  # API method to tick for specified number of clocks
+  # API method to tick for specified number of clocks. The tick is
+  # issued as a single wait, which the simulation cuts short on an
+  # interrupt event so the callback runs in the cycle it would have
+  # with a tick per cycle, before resuming the remaining count.
   def tick (self, ticks) :
-    for i in range(ticks) :
+    remaining = ticks
+    while remaining > 0 :
       self.__processIrq()
-      self.api.PyTick(1, self.node)
+      remaining = self.api.PyTickIrq(remaining, self.node)
+
+  # API method to tick for up to the specified number of clocks,
+  # returning early after processing any interrupt event. Returns
+  # the number of ticks remaining.
+  def tickIrq (self, ticks) :
+    self.__processIrq()
+    remaining = self.api.PyTickIrq(ticks, self.node)
+    self.__processIrq()
+    return remaining
+
+  # API method to get the node's clock cycle count, as of the return
+  # of its last access or tick
+  def getCycle (self) :
+    self.api.PyGetCycle.restype = c_uint64
+    return self.api.PyGetCycle(self.node)
+
+  # API method to get the simulation time in the VProc component's time
+  # units, as of the return of the node's last access or tick
+  def getSimTime (self) :
+    self.api.PyGetSimTime.restype = c_uint64
+    return self.api.PyGetSimTime(self.node)
+
+  # API method to tick until the node's clock cycle count reaches the
+  # specified cycle, as for tick(). Returns at once if already reached.
+  def waitUntil (self, cycle) :
+    self.tick(cycle - self.getCycle())
 
   # API method to do a burst write
   def burstWrite(self, addr, data, length) :
@@ -81,7 +111,7 @@ class PyVProcClass :
   # API method to do a burst write with byte enables
   def burstWriteBE(self, addr, data, length, fbe, lbe) :
     self.__processIrq()
-    self.api.PyBurstWrite(addr, (c_int * len(data))(*data), length, fbe, lbe, self.node)
+    self.api.PyBurstWriteBE(addr, (c_int * len(data))(*data), length, fbe, lbe, self.node)
 
   # API method to do a burst read
   def burstRead(self, addr, length) :
@@ -97,6 +127,11 @@ class PyVProcClass :
   def regIrq(self, irqCb) :
     self.__irqcb = irqCb
 
+  # API method to process any outstanding interrupt events without
+  # advancing time
+  def processIrq (self) :
+    self.__processIrq()
+
   def __processIrq (self) :
     while True :
       irq =  (c_int * 1)(0)
@@ -113,3 +148,206 @@ class PyVProcClass :
     self.api.PyPrint(c_char_p(bytestring))
 
 
+
+# ---------------------------------------------------------------
+# Awaitable object returned by the PyVProcAsync API methods. The
+# coroutine yields it to the scheduling loop, which resumes the
+# coroutine with the result once the request has completed.
+# ---------------------------------------------------------------
+
+class _VProcAwait :
+
+  def __init__(self, kind, *args) :
+    self.kind = kind
+    self.args = args
+
+  def __await__(self) :
+    return (yield self)
+
+# ---------------------------------------------------------------
+# Task wrapper for a coroutine scheduled on a PyVProcAsync loop.
+# Awaiting a task waits for its completion and returns the
+# coroutine's return value.
+# ---------------------------------------------------------------
+
+class PyVProcTask :
+
+  def __init__(self, coro) :
+    self.coro    = coro
+    self.done    = False
+    self.result  = None
+    self.joiners = []
+
+  def __await__(self) :
+    return (yield _VProcAwait('join', self))
+
+# ---------------------------------------------------------------
+# Coroutine API layered on a PyVProcClass node. Any number of
+# coroutines may be spawned on the one node, with their bus
+# transactions serialised in request order, e.g.
+#
+#   async def seq(vp) :
+#     await vp.irq(0x1)
+#     data = await vp.read(addr)
+#
+#   vp = pyvproc.PyVProcAsync(pyvproc.PyVProcClass(node))
+#   vp.run(seq(vp), seq2(vp))
+#
+# The loop's time is the node's clock cycle count, as returned by
+# getCycle(), so ticks(n) waits n cycles however long the bus
+# transactions issued in the meantime take.
+# ---------------------------------------------------------------
+
+class PyVProcAsync :
+
+  def __init__(self, vp) :
+    self.vp       = vp
+    self.now      = 0
+    self.irqState = 0
+    self.__userCb = None
+    self.__ready  = []
+    self.__bus    = []
+    self.__sleep  = []
+    self.__irqWait = []
+    self.__tasks  = []
+    vp.regIrq(self.__irqEvent)
+
+  # Awaitable API methods
+  def write (self, addr, data, delta = 0) :
+    return _VProcAwait('bus', self.vp.write, addr, data, delta)
+
+  def writeBE (self, addr, data, be, delta = 0) :
+    return _VProcAwait('bus', self.vp.writeBE, addr, data, be, delta)
+
+  def read (self, addr, delta = 0) :
+    return _VProcAwait('bus', self.vp.read, addr, delta)
+
+  def uread (self, addr, delta = 0) :
+    return _VProcAwait('bus', self.vp.uread, addr, delta)
+
+  def burstWrite (self, addr, data, length) :
+    return _VProcAwait('bus', self.vp.burstWrite, addr, data, length)
+
+  def burstWriteBE (self, addr, data, length, fbe, lbe) :
+    return _VProcAwait('bus', self.vp.burstWriteBE, addr, data, length, fbe, lbe)
+
+  def burstRead (self, addr, length) :
+    return _VProcAwait('bus', self.vp.burstRead, addr, length)
+
+  # Wait for the specified number of clock cycles
+  def ticks (self, n) :
+    return _VProcAwait('ticks', n)
+
+  # Wait until any of the interrupt bits in mask are set, returning
+  # the interrupt state. Completes immediately if already set.
+  def irq (self, mask) :
+    return _VProcAwait('irq', mask)
+
+  # Register a vectored interrupt callback, called ahead of waking
+  # any coroutines waiting on the interrupt
+  def regIrq (self, irqCb) :
+    self.__userCb = irqCb
+
+  # Schedule a coroutine, returning its task
+  def spawn (self, coro) :
+    task = PyVProcTask(coro)
+    self.__tasks.append(task)
+    self.__ready.append((task, None))
+    return task
+
+  # Run the loop until all the tasks have completed, returning the
+  # results of the coroutines passed in
+  def run (self, *coros) :
+    tasks = [self.spawn(c) for c in coros]
+    self.__sync()
+
+    while self.__tasks :
+
+      # Run every ready task until it next awaits
+      while self.__ready :
+        task, value = self.__ready.pop(0)
+        self.__step(task, value)
+
+      if not self.__tasks :
+        break
+
+      # Issue the oldest bus request and resume its coroutine
+      if self.__bus :
+        task, func, args = self.__bus.pop(0)
+        self.__ready.append((task, func(*args)))
+        self.__sync()
+
+      # Nothing on the bus, so tick until the next sleeper is due
+      # or an interrupt wakes a waiting coroutine
+      elif self.__sleep :
+        self.__idle(min(s[0] for s in self.__sleep) - self.now)
+
+      elif self.__irqWait :
+        self.__idle(0x7fffffff)
+
+      else :
+        raise RuntimeError("PyVProcAsync: all tasks blocked on other tasks")
+
+    return [t.result for t in tasks]
+
+  # Resume a task's coroutine and queue whatever it awaits next
+  def __step (self, task, value) :
+    try :
+      op = task.coro.send(value)
+    except StopIteration as e :
+      task.done   = True
+      task.result = e.value
+      self.__tasks.remove(task)
+      for j in task.joiners :
+        self.__ready.append((j, e.value))
+      return
+
+    if op.kind == 'bus' :
+      self.__bus.append((task, op.args[0], op.args[1:]))
+    elif op.kind == 'ticks' :
+      if op.args[0] > 0 :
+        self.__sleep.append((self.now + op.args[0], task))
+      else :
+        self.__ready.append((task, None))
+    elif op.kind == 'irq' :
+      if self.irqState & op.args[0] :
+        self.__ready.append((task, self.irqState))
+      else :
+        self.__irqWait.append((op.args[0], task))
+    elif op.kind == 'join' :
+      if op.args[0].done :
+        self.__ready.append((task, op.args[0].result))
+      else :
+        op.args[0].joiners.append(task)
+
+  # Update loop time from the node's cycle count, waking any
+  # sleepers now due
+  def __sync (self) :
+    self.now = self.vp.getCycle()
+    due = [s for s in self.__sleep if s[0] <= self.now]
+    for s in due :
+      self.__sleep.remove(s)
+      self.__ready.append((s[1], None))
+
+  # Tick for up to n cycles, stopping early if an interrupt waiter
+  # becomes ready
+  def __idle (self, n) :
+    if not self.__irqWait :
+      self.vp.tick(n)
+      self.__sync()
+    else :
+      end = self.now + n
+      while self.now < end and not self.__ready :
+        self.vp.tickIrq(end - self.now)
+        self.__sync()
+
+  # Vectored interrupt callback for the node
+  def __irqEvent (self, irq) :
+    self.irqState = irq
+    if self.__userCb != None :
+      self.__userCb(irq)
+    woken = [w for w in self.__irqWait if irq & w[0]]
+    for w in woken :
+      self.__irqWait.remove(w)
+      self.__ready.append((w[1], irq))
+    return 0
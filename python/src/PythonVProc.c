@@ -31,10 +31,17 @@ static wbfunc_p     VburstWrite;
 static wbbefunc_p   VburstWriteBE;
 static rbfunc_p     VburstRead;
 static tkfunc_p     Vtick;
+static tkirqfunc_p  VtickIrq;
+static getfunc_p    VgetCycle;
+static getfunc_p    VgetSimTime;
 static regirqfunc_p VregIrqPy;
 static pyirqcb_p    PyIrqCB;
 static pyfetchirq_p PyFetchIrq_;
 
+// Python is initialised once, by whichever node gets there first
+static pthread_once_t py_init_once = PTHREAD_ONCE_INIT;
+static int            bind_status  = 0;
+
 // ------------------------------------------------------------
 // Function to load VProc shared object and create bindings to
 // the API functions
@@ -95,6 +102,24 @@ static int BindToApiFuncs(void)
         return 1;
     }
 
+    if ((VtickIrq = (tkirqfunc_p)dlsym(hdl, "VTickIrq")) == NULL)
+    {
+        fprintf(stderr, "***ERROR: failed to find symbol VTickIrq\n");
+        return 1;
+    }
+
+    if ((VgetCycle = (getfunc_p)dlsym(hdl, "VGetCycle")) == NULL)
+    {
+        fprintf(stderr, "***ERROR: failed to find symbol VGetCycle\n");
+        return 1;
+    }
+
+    if ((VgetSimTime = (getfunc_p)dlsym(hdl, "VGetSimTime")) == NULL)
+    {
+        fprintf(stderr, "***ERROR: failed to find symbol VGetSimTime\n");
+        return 1;
+    }
+
     if ((VregIrqPy = (regirqfunc_p)dlsym(hdl, "VRegIrqPy")) == NULL)
     {
         fprintf(stderr, "***ERROR: failed to find symbol VRegIrqPy\n");
@@ -117,31 +142,43 @@ static int BindToApiFuncs(void)
 }
 
 // ------------------------------------------------------------
-// Function to load and run a user supplied VUserMainX python
-// function to match the node number (e.g. VUserMain0)
+// One-time initialisation of the Python environment, shared by
+// all nodes. Binds to the VProc API, starts the interpreter and
+// then releases the GIL so that each node's thread can acquire
+// it in turn.
+// ------------------------------------------------------------
+
+static void PyInitOnce(void)
+{
+    if ((bind_status = BindToApiFuncs()) != 0)
+    {
+        return;
+    }
+
+    Py_Initialize();
+
+    // The initialising thread holds the GIL on return from Py_Initialize().
+    // Release it, as each node thread acquires its own thread state. Python
+    // is never finalised as node threads don't return.
+    PyEval_SaveThread();
+}
+
+// ------------------------------------------------------------
+// Function to import and call the VUserMainX python function
+// in the current interpreter. The calling thread must hold
+// the GIL.
 //
 // Returns 0 on success
 //
 // ------------------------------------------------------------
 
-int RunPython(const int node)
+static int CallVUserMain(const int node)
 {
     PyObject *pName, *pModule, *pFunc;
     PyObject *pValue;
     char strbuf[DEFAULTSTRBUFSIZE];
-    int status;
     int rtnval = 0;
 
-    if (status = BindToApiFuncs())
-    {
-        return status;
-    }
-
-    // Register the Python interface interrupt callback function
-    PyRegIrq(PyIrqCB, node);
-
-    Py_Initialize();
-
     sprintf(strbuf, "VUserMain%d", node);
 
     pName = PyUnicode_DecodeFSDefault(strbuf);
@@ -191,11 +228,115 @@ int RunPython(const int node)
         return 1;
     }
 
-    if (Py_FinalizeEx() < 0)
+    return rtnval;
+}
+
+#ifdef VPROC_PY_OWN_GIL
+
+// ------------------------------------------------------------
+// Function to run a node's VUserMainX python function in a new
+// sub-interpreter with its own GIL. The calling thread must not
+// hold any GIL.
+//
+// Returns 0 if the function was run, with its status in
+// rtnval, or 1 if the sub-interpreter couldn't be created
+//
+// ------------------------------------------------------------
+
+static int RunInSubInterp(const int node, int* rtnval)
+{
+    PyThreadState*   tstate = NULL;
+    PyThreadState*   main_tstate;
+    PyGILState_STATE gstate;
+    PyStatus         status;
+
+    const PyInterpreterConfig config = {
+        .use_main_obmalloc            = 0,
+        .allow_fork                   = 0,
+        .allow_exec                   = 0,
+        .allow_threads                = 1,
+        .allow_daemon_threads         = 0,
+        .check_multi_interp_extensions = 1,
+        .gil                          = PyInterpreterConfig_OWN_GIL,
+    };
+
+    // Creating an interpreter needs the main interpreter's GIL, which is
+    // released again when the new interpreter (with its own GIL) is made current
+    gstate      = PyGILState_Ensure();
+    main_tstate = PyThreadState_Get();
+
+    status      = Py_NewInterpreterFromConfig(&tstate, &config);
+
+    if (PyStatus_Exception(status))
     {
-        return 120;
+        // On failure the main interpreter's thread state is current again
+        PyGILState_Release(gstate);
+        return 1;
     }
 
+    *rtnval = CallVUserMain(node);
+
+    // Ending the sub-interpreter leaves no thread state current. Reattach
+    // this thread's main interpreter state (taking its GIL) so that it, and
+    // the GIL, can be released.
+    Py_EndInterpreter(tstate);
+    PyEval_RestoreThread(main_tstate);
+    PyGILState_Release(gstate);
+
+    return 0;
+}
+
+#endif
+
+// ------------------------------------------------------------
+// Function to load and run a user supplied VUserMainX python
+// function to match the node number (e.g. VUserMain0)
+//
+// Any number of nodes may call this function, each from its own
+// VProc user thread. Where supported (see PythonVProc.h), each
+// node is run in its own sub-interpreter with its own GIL, so
+// that nodes' Python code can run in parallel. Otherwise, or if
+// a sub-interpreter can't be created, the node runs in the main
+// interpreter, shared by all such nodes, with the GIL released
+// whenever a node is blocked in a VProc API call (ctypes releases
+// it for the duration of a foreign call), so nodes are only ever
+// serialised where the simulator serialises them, or while their
+// Python code is running.
+//
+// Returns 0 on success
+//
+// ------------------------------------------------------------
+
+int RunPython(const int node)
+{
+    PyGILState_STATE gstate;
+    int              rtnval;
+
+    pthread_once(&py_init_once, PyInitOnce);
+
+    if (bind_status)
+    {
+        return bind_status;
+    }
+
+    // Register the Python interface interrupt callback function
+    PyRegIrq(PyIrqCB, node);
+
+#ifdef VPROC_PY_OWN_GIL
+    if (RunInSubInterp(node, &rtnval) == 0)
+    {
+        return rtnval;
+    }
+
+    fprintf(stderr, "***Warning: RunPython() : failed to create sub-interpreter for node %d, running in main interpreter\n", node);
+#endif
+
+    gstate = PyGILState_Ensure();
+
+    rtnval = CallVUserMain(node);
+
+    PyGILState_Release(gstate);
+
     return rtnval;
 }
 
@@ -238,9 +379,9 @@ uint32_t PyRead (const uint32_t addr, const int delta, const uint32_t node)
 {
     uint32_t rdata;
 
-    int status = Vread(addr, &rdata, delta, node);
+    Vread(addr, &rdata, delta, node);
 
-    return (uint64_t)rdata;
+    return rdata;
 }
 
 // ------------------------------------------------------------
@@ -252,6 +393,34 @@ uint32_t PyTick (const uint32_t ticks, const uint32_t node)
     return Vtick(ticks, node);
 }
 
+// ------------------------------------------------------------
+// VTickIrq wrapper function for Python. Returns the number of
+// ticks remaining when terminated early by an interrupt event
+// ------------------------------------------------------------
+
+uint32_t PyTickIrq (const uint32_t ticks, const uint32_t node)
+{
+    return VtickIrq(ticks, node);
+}
+
+// ------------------------------------------------------------
+// VGetCycle wrapper function for Python
+// ------------------------------------------------------------
+
+uint64_t PyGetCycle (const uint32_t node)
+{
+    return VgetCycle(node);
+}
+
+// ------------------------------------------------------------
+// VGetSimTime wrapper function for Python
+// ------------------------------------------------------------
+
+uint64_t PyGetSimTime (const uint32_t node)
+{
+    return VgetSimTime(node);
+}
+
 // ------------------------------------------------------------
 // VBurstWrite wrapper function for Python
 // ------------------------------------------------------------
@@ -267,7 +436,7 @@ uint32_t PyBurstWrite (const uint32_t addr, void *data, const uint32_t len, cons
 
 uint32_t PyBurstWriteBE (const uint32_t addr, void *data, const uint32_t len, uint32_t fbe, uint32_t lbe, const uint32_t node)
 {
-    return VburstWrite(addr, data, len, node);
+    return VburstWriteBE(addr, data, len, fbe, lbe, node);
 }
 
 // ------------------------------------------------------------
@@ -296,5 +465,5 @@ uint32_t PyRegIrq (const pPyIrqCB_t func, const uint32_t node)
 
 uint32_t PyFetchIrq (void *irq, const uint32_t node)
 {
-    PyFetchIrq_(irq, node);
+    return PyFetchIrq_(irq, node);
 }
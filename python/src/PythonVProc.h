@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include <Python.h>
 #include <dlfcn.h>
+#include <pthread.h>
 #include "VProc.h"
 
 #ifndef _PYTHONVPROC_H_
@@ -31,6 +32,15 @@
 
 #define DEFAULTSTRBUFSIZE      256
 
+// Each node runs its Python code in its own sub-interpreter, with its own
+// GIL, where supported. This needs Python 3.13 or later, the first where
+// ctypes (used by pyvproc) can be imported in a sub-interpreter. With an
+// earlier Python, or if compiled with VPROC_PY_SHARED_INTERP defined, the
+// nodes share the main interpreter, and its GIL.
+#if PY_VERSION_HEX >= 0x030D0000 && !defined(VPROC_PY_SHARED_INTERP)
+# define VPROC_PY_OWN_GIL
+#endif
+
 // Pointer types for external API functions. Must match prototypes in VUser.h
 typedef int      (*wfunc_p)      (const unsigned, const unsigned, const int, const unsigned);
 typedef int      (*wbefunc_p)    (const unsigned, const unsigned, const unsigned, const int, const unsigned);
@@ -39,6 +49,8 @@ typedef int      (*wbfunc_p)     (const unsigned, void *, const unsigned, const
 typedef int      (*wbbefunc_p)   (const unsigned, void *, const unsigned, const unsigned, const unsigned, const unsigned);
 typedef int      (*rbfunc_p)     (const unsigned, void *, const unsigned, const unsigned);
 typedef int      (*tkfunc_p)     (const unsigned, const unsigned );
+typedef int      (*tkirqfunc_p)  (const unsigned, const unsigned );
+typedef uint64_t (*getfunc_p)    (const unsigned);
 typedef void     (*regirqfunc_p) (const pPyIrqCB_t, const unsigned);
 typedef int      (*pyirqcb_p)    (const int, const int);
 typedef uint32_t (*pyfetchirq_p) (void *, const uint32_t);
@@ -49,6 +61,9 @@ uint32_t PyWrite        (const uint32_t addr,  const uint32_t data,  const int d
 uint32_t PyWriteBE      (const uint32_t addr,  const uint32_t data,  const uint32_t be, const int delta, const uint32_t node);
 uint32_t PyRead         (const uint32_t addr,  const int      delta, const uint32_t node);
 uint32_t PyTick         (const uint32_t ticks, const uint32_t node);
+uint32_t PyTickIrq      (const uint32_t ticks, const uint32_t node);
+uint64_t PyGetCycle     (const uint32_t node);
+uint64_t PyGetSimTime   (const uint32_t node);
 uint32_t PyBurstWrite   (const uint32_t addr,  void *data, const uint32_t len, const uint32_t node);
 uint32_t PyBurstWriteBE (const uint32_t addr,  void *data, const uint32_t len, const uint32_t fbe, const uint32_t lbe, const uint32_t node);
 uint32_t PyBurstRead    (const uint32_t addr,  void *data, const uint32_t len, const uint32_t node);
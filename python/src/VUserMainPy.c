@@ -28,30 +28,20 @@
 
 #define SLEEPFOREVER       {while(1) VTick(0x7fffffff, node);}
 
-// In Python 64 nodes is the maximum (the default), but check this hasn't been
-// overridden to a large number.
+// In Python 64 nodes is the maximum (the default, and the number of
+// VUserMain<n> bindings below), but check this hasn't been overridden
+// to a large number.
 #if VP_MAX_NODES > 64
 #error "**ERROR: VP_MAX_NODES > 64 is unsupported"
 #endif
 
-static uint32_t active_node = 0;
-
 static void VUserMain(int node)
 {
-    if (active_node)
-    {
-        fprintf(stderr, "NODE%d: ***ERROR: Under Python only a single instance of VProc is supported at this time.\n", node);
-    }
-    else
-    {
-        active_node |= (uint32_t)1 << node;
-
-        int status = RunPython(node);
+    int status = RunPython(node);
 
-        if (status)
-        {
-            fprintf(stderr, "***ERROR: RunPython(%d) returned error status %d\n", node, status);
-        }
+    if (status)
+    {
+        fprintf(stderr, "***ERROR: RunPython(%d) returned error status %d\n", node, status);
     }
 
     SLEEPFOREVER;
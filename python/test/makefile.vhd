@@ -67,7 +67,9 @@ endif
 
 # VPROC C source code
 VPROC_C            = VSched.c \
-                     VUser.c
+                     VUser.c \
+                     VShm.c \
+                     VTrace.c
 
 # Python interface C code compiled into PyVProc.so
 PYTHON_C           = PythonVProc.c
@@ -63,6 +63,13 @@ wire          VPWE;
 wire          VPRD;
 wire          Update;
 
+wire [31:0]   VPAddr1;
+wire [31:0]   VPDataOut1;
+wire [31:0]   VPDataIn1;
+wire          VPWE1;
+wire          VPRD1;
+wire          Update1;
+
 // ---------------------------------------------------------
 // Combinatorial logic
 // ---------------------------------------------------------
@@ -74,6 +81,7 @@ wire          reset_irq = nreset & ~nreset_h;
 // Memory chip select in segment 0xa
 wire CS1 = (VPAddr[31:28] == 4'ha) ? 1'b1 : 1'b0;
 wire CS2 = (VPAddr[31:28] == 4'hb) ? 1'b1 : 1'b0;
+wire CS3 = (VPAddr1[31:28] == 4'ha) ? 1'b1 : 1'b0;
 
 wire        irq1      = (Count > 54 && Count < 60) ? 1'b1 : 1'b0;
 wire [31:0] Interrupt = {30'h0, irq1, nreset};
@@ -106,7 +114,34 @@ wire [31:0] Interrupt = {30'h0, irq1, nreset};
            );
 
  // ---------------------------------------------------------
- // Memory
+ // Virtual Processor 1
+ // ---------------------------------------------------------
+
+ VProc    #(.INT_WIDTH          (`INTWIDTH),
+            .NODE_WIDTH         (`NODEWIDTH)
+           ) vp2
+           (.Clk                (clk),
+            .Addr               (VPAddr1),
+            .WE                 (VPWE1),
+            .RD                 (VPRD1),
+
+`ifdef VPROC_BURST_IF
+            .Burst              (),
+            .BurstFirst         (),
+            .BurstLast          (),
+`endif
+            .DataOut            (VPDataOut1),
+            .DataIn             (VPDataIn1),
+            .WRAck              (VPWE1),
+            .RDAck              (VPRD1),
+            .Interrupt          ({`INTWIDTH{1'b0}}),
+            .Update             (Update1),
+            .UpdateResponse     (Update1),
+            .Node               (1)
+           );
+
+ // ---------------------------------------------------------
+ // Memories
  // ---------------------------------------------------------
 
  Mem m     (.clk                (clk),
@@ -117,6 +152,14 @@ wire [31:0] Interrupt = {30'h0, irq1, nreset};
             .CS                 (CS1)
            );
 
+ Mem m1    (.clk                (clk),
+            .DI                 (VPDataOut1),
+            .DO                 (VPDataIn1),
+            .WE                 (VPWE1),
+            .A                  (VPAddr1[9:0]),
+            .CS                 (CS3)
+           );
+
 // ---------------------------------------------------------
 // Initialise state and generate a clock
 // ---------------------------------------------------------
@@ -60,6 +60,15 @@ architecture sim of test is
   signal  CS1                          : std_logic;
   signal  Mem                          : array_t (0 to 1023)(31 downto 0) := (others => 32x"0");
 
+  signal  UpdateResponse1              : std_logic                        := '1';
+  signal  VPAddr1, VPDataOut1          : std_logic_vector(31 downto 0)    := 32x"0";
+  signal  VPDataIn1                    : std_logic_vector(31 downto 0)    := 32x"0";
+  signal  VPWE1                        : std_logic;
+  signal  VPRD1                        : std_logic;
+  signal  Update1                      : std_logic;
+  signal  CS3                          : std_logic;
+  signal  Mem1                         : array_t (0 to 1023)(31 downto 0) := (others => 32x"0");
+
 begin
 
   ---------------------------------------------
@@ -67,6 +76,7 @@ begin
   ---------------------------------------------
   notReset                             <= '1' when (Count > 5) else '0';
   CS1                                  <= '1' when VPAddr(31 downto 28) = 4x"a" else '0';
+  CS3                                  <= '1' when VPAddr1(31 downto 28) = 4x"a" else '0';
   irq1                                 <= '1' when (Count > 54) and (Count < 60) else '0';
 
   ---------------------------------------------
@@ -90,7 +100,27 @@ begin
   );
 
   ---------------------------------------------
-  -- Response process
+  -- VProc 1
+  ---------------------------------------------
+
+  vp1 : entity work.VProc
+  port map (
+    Clk                                => Clk,
+    Addr                               => VPAddr1,
+    WE                                 => VPWE1,
+    RD                                 => VPRD1,
+    DataOut                            => VPDataOut1,
+    DataIn                             => VPDataIn1,
+    WRAck                              => VPWE1,
+    RDAck                              => VPRD1,
+    Interrupt                          => "000",
+    Update                             => Update1,
+    UpdateResponse                     => UpdateResponse1,
+    Node                               => 4x"1"
+  );
+
+  ---------------------------------------------
+  -- Response processes
   ---------------------------------------------
 
   P_UPDT : process(Update)
@@ -99,6 +129,11 @@ begin
     UpdateResponse                     <= not UpdateResponse;
   end process;
 
+  P_UPDT1 : process(Update1)
+  begin
+    UpdateResponse1                    <= not UpdateResponse1;
+  end process;
+
   ---------------------------------------------
   -- Clock generation
   ---------------------------------------------
@@ -156,5 +191,18 @@ begin
 
   end process;
 
+  P_MEM1 : process (Clk, VPAddr1)
+  begin
+
+    VPDataIn1                          <= Mem1(to_integer(unsigned(VPAddr1(9 downto 0))));
+
+    if Clk'event and Clk = '1' then
+      if VPWE1 = '1' and CS3 = '1' then
+        Mem1(to_integer(unsigned(VPAddr1(9 downto 0)))) <= VPDataOut1;
+      end if;
+    end if;
+
+  end process;
+
 end sim;
 
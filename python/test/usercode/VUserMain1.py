@@ -0,0 +1,80 @@
+###################################################################
+# Python user test code for VProc co-simulation
+#
+# Copyright (c) 2024 Simon Southwell.
+#
+# This file is part of VProc.
+#
+# This code is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# The code is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this code. If not, see <http://www.gnu.org/licenses/>.
+#
+###################################################################
+
+from ctypes import *
+import sys
+sys.path.append('../modules')
+import pyvproc
+
+# Define some local constants
+__LONGTIME    = 0x7fffffff
+
+# ---------------------------------------------------------------
+# Main entry point for node 1, running alongside node 0 to check
+# that more than one Python node can run at once. It has its own
+# memory, and finishes before node 0 stops the simulation.
+# ---------------------------------------------------------------
+
+def VUserMain1() :
+
+  # This is node 1
+  node  = 1
+
+  # Create an API object for node 1
+  vpapi = pyvproc.PyVProcClass(node)
+
+  vpapi.tick(5)
+
+  # Construct some test data (addresses are word addresses)
+  addr  = [0xa0000010, 0xa0000011]
+  wdata = [0x0badcafe, 0x5eed1e55]
+
+  # Write test
+  for idx in range(len(addr)) :
+    vpapi.VPrint("NODE1: Writing " + hex(wdata[idx]) + " to   addr " + hex(addr[idx]))
+    vpapi.write(addr[idx], wdata[idx])
+    vpapi.tick(1)
+
+  # Read Test
+  for idx in range(len(addr)) :
+    rdata = vpapi.uread(addr[idx])
+
+    if rdata == wdata[idx] :
+      vpapi.VPrint("NODE1: Read    " + hex(rdata) + " from addr " + hex(addr[idx]))
+    else :
+      vpapi.VPrint("NODE1: ***ERROR: Read    " + hex(rdata) + " from addr " + hex(addr[idx]) + ", expected " + hex(wdata[idx]))
+
+  # Burst write and read test
+  burstWrData = [0x11111111, 0x22222222, 0x33333333, 0x44444444]
+  burstAddr   = 0xa0000100
+  vpapi.burstWrite(burstAddr, burstWrData, len(burstWrData))
+
+  burstRdData = vpapi.burstRead(burstAddr, len(burstWrData));
+  vpapi.VPrint("NODE1: Read burst    " + str(list(map(hex, burstRdData))) + " from addr " + hex(burstAddr));
+
+  if burstRdData != burstWrData :
+    vpapi.VPrint("NODE1: ***ERROR: mismatch in burst read data");
+
+  vpapi.VPrint("NODE1: Tests complete")
+
+  while True :
+    vpapi.tick(__LONGTIME)
@@ -0,0 +1,170 @@
+###################################################################
+# Python user test code for VProc co-simulation
+#
+# Copyright (c) 2024 Simon Southwell.
+#
+# This file is part of VProc.
+#
+# This code is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# The code is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this code. If not, see <http://www.gnu.org/licenses/>.
+#
+###################################################################
+
+from ctypes import *
+import sys
+sys.path.append('../modules')
+import pyvproc
+
+# Define some local constants
+__SIMSTOPADDR = 0xb0000000
+__LONGTIME    = 0x7fffffff
+
+# Interrupt bits driven by the test bench
+__IRQRESET    = 0x1
+__IRQ1        = 0x2
+
+__BURSTLEN    = 8
+__TIMERCYCLES = 10
+
+# ---------------------------------------------------------------
+# Coroutine to write words from a base address and read them back,
+# returning the number of mismatches
+# ---------------------------------------------------------------
+
+async def memTest (vp, base, wdata) :
+
+  errors = 0
+
+  for idx in range(len(wdata)) :
+    await vp.write(base + idx, wdata[idx])
+
+  for idx in range(len(wdata)) :
+    rdata = await vp.uread(base + idx)
+
+    if rdata != wdata[idx] :
+      vp.vp.VPrint("NODE0: ***ERROR: Read " + hex(rdata) + " from addr " + hex(base + idx) + ", expected " + hex(wdata[idx]))
+      errors += 1
+
+  return errors
+
+# ---------------------------------------------------------------
+# Coroutine to write a burst and read it back, returning the number
+# of mismatches
+# ---------------------------------------------------------------
+
+async def burstTest (vp, base, wdata) :
+
+  await vp.burstWrite(base, wdata, len(wdata))
+
+  rdata = await vp.burstRead(base, len(wdata))
+
+  if rdata != wdata :
+    vp.vp.VPrint("NODE0: ***ERROR: Read burst " + str(list(map(hex, rdata))) + " from addr " + hex(base))
+    return 1
+
+  return 0
+
+# ---------------------------------------------------------------
+# Coroutine to sleep for a number of cycles, returning the number
+# of cycles, as counted by the simulation, that it slept for
+# ---------------------------------------------------------------
+
+async def timer (vp, cycles) :
+
+  start = vp.vp.getCycle()
+  await vp.ticks(cycles)
+
+  return vp.vp.getCycle() - start
+
+# ---------------------------------------------------------------
+# Coroutine to wait on an interrupt, returning its state
+# ---------------------------------------------------------------
+
+async def irqWait (vp, mask) :
+
+  return await vp.irq(mask)
+
+# ---------------------------------------------------------------
+# Top level coroutine for the node's tests, returning an error count
+# ---------------------------------------------------------------
+
+async def tests (vp) :
+
+  errors = 0
+
+  await vp.irq(__IRQRESET)
+  vp.vp.VPrint("NODE0: Seen reset deasserted at cycle " + str(vp.now))
+
+  # Wait on IRQ[1] while running memory tests and a timer alongside
+  irqtask = vp.spawn(irqWait(vp, __IRQ1))
+
+  # Word and burst memory tests, with their bus accesses interleaved
+  mem0    = vp.spawn(memTest(vp, 0xa0000000, [0x12345678, 0x87654321, 0xcafef00d, 0xdeadbeef]))
+  mem1    = vp.spawn(burstTest(vp, 0xa0000100, [0x900ddeed + idx for idx in range(__BURSTLEN)]))
+
+  # A timer running alongside the memory tests must sleep for the
+  # requested number of cycles, however long the accesses take. It
+  # can only wake late by up to the length of the access in progress.
+  slept   = await timer(vp, __TIMERCYCLES)
+
+  if slept < __TIMERCYCLES or slept >= __TIMERCYCLES + __BURSTLEN :
+    vp.vp.VPrint("NODE0: ***ERROR: timer slept for " + str(slept) + " cycles, expected " + str(__TIMERCYCLES))
+    errors += 1
+
+  errors += await mem0
+  errors += await mem1
+
+  irq = await irqtask
+
+  if not irq & __IRQ1 :
+    vp.vp.VPrint("NODE0: ***ERROR: woken with IRQ[1] clear (" + hex(irq) + ")")
+    errors += 1
+  else :
+    vp.vp.VPrint("NODE0: Seen IRQ[1] at cycle " + str(vp.now))
+
+  return errors
+
+# ---------------------------------------------------------------
+# Main entry point for node 0
+# ---------------------------------------------------------------
+
+def VUserMain0() :
+
+  # This is node 0
+  node  = 0
+
+  # Create an API object for node 0, and a coroutine API on top of it
+  vpapi = pyvproc.PyVProcClass(node)
+  vp    = pyvproc.PyVProcAsync(vpapi)
+
+  errors = vp.run(tests(vp))[0]
+
+  # IRQ[1] is deasserted a few cycles after it was seen, which should
+  # cut a long tick short
+  remaining = vpapi.tickIrq(100)
+
+  if remaining == 0 or vp.irqState & __IRQ1 :
+    vpapi.VPrint("NODE0: ***ERROR: tickIrq() not terminated by IRQ[1] deassertion")
+    errors += 1
+
+  if errors == 0 :
+    vpapi.VPrint("\nNODE0: Tests complete, stopping simulation\n")
+  else :
+    vpapi.VPrint("\nNODE0: ***ERROR: " + str(errors) + " errors, stopping simulation\n")
+
+  # Tell simulator to stop/finish
+  vpapi.write(__SIMSTOPADDR, 1);
+
+  # Should not get here
+  while True :
+    vpapi.tick(__LONGTIME)
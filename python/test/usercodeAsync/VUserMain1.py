@@ -0,0 +1,68 @@
+###################################################################
+# Python user test code for VProc co-simulation
+#
+# Copyright (c) 2024 Simon Southwell.
+#
+# This file is part of VProc.
+#
+# This code is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# The code is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this code. If not, see <http://www.gnu.org/licenses/>.
+#
+###################################################################
+
+from ctypes import *
+import sys
+sys.path.append('../modules')
+import pyvproc
+
+# Define some local constants
+__LONGTIME    = 0x7fffffff
+
+# ---------------------------------------------------------------
+# Coroutine to write a burst and read it back, after a delay,
+# returning the number of mismatches
+# ---------------------------------------------------------------
+
+async def burstTest (vp, delay, base, wdata) :
+
+  await vp.ticks(delay)
+  await vp.burstWrite(base, wdata, len(wdata))
+
+  rdata = await vp.burstRead(base, len(wdata))
+
+  if rdata != wdata :
+    vp.vp.VPrint("NODE1: ***ERROR: Read burst " + str(list(map(hex, rdata))) + " from addr " + hex(base))
+    return 1
+
+  return 0
+
+# ---------------------------------------------------------------
+# Main entry point for node 1
+# ---------------------------------------------------------------
+
+def VUserMain1() :
+
+  # This is node 1
+  node  = 1
+
+  vpapi = pyvproc.PyVProcClass(node)
+  vp    = pyvproc.PyVProcAsync(vpapi)
+
+  errors = sum(vp.run(burstTest(vp, 3, 0xa0000010, [0x11111111, 0x22222222, 0x33333333]),
+                      burstTest(vp, 5, 0xa0000020, [0x44444444, 0x55555555])))
+
+  if errors == 0 :
+    vpapi.VPrint("NODE1: Tests complete")
+
+  while True :
+    vpapi.tick(__LONGTIME)
@@ -0,0 +1,118 @@
+###################################################################
+# Python multi-node test code for VProc co-simulation
+#
+# Copyright (c) 2024 Simon Southwell.
+#
+# This file is part of VProc.
+#
+# This code is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# The code is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this code. If not, see <http://www.gnu.org/licenses/>.
+#
+###################################################################
+
+from ctypes import *
+import sys
+import time
+sys.path.append('../modules')
+import pyvproc
+
+# Run on test/testNodes.v, where each node has a memory at address 0,
+# reads the cycle count at __CYCLEADDR and is done on writing to
+# __DONEADDR. The simulation finishes once every node is done.
+
+__CYCLEADDR   = 0xfffffff8
+__DONEADDR    = 0xfffffff0
+__LONGTIME    = 0x7fffffff
+
+__ITERATIONS  = 20
+__ITERTICKS   = 10
+__WORK        = 20000
+
+# Nodes that have imported this module in the current interpreter. With
+# a sub-interpreter per node, each node has its own copy of the module.
+nodesSeen     = []
+
+# ---------------------------------------------------------------
+# Whether running in a sub-interpreter (Python 3.13 or later)
+# ---------------------------------------------------------------
+
+def inSubInterp() :
+  try :
+    import _interpreters
+    return _interpreters.get_current() != _interpreters.get_main()
+  except ImportError :
+    return False
+
+# ---------------------------------------------------------------
+# Some Python work between accesses, which nodes with their own
+# GIL can do in parallel
+# ---------------------------------------------------------------
+
+def work(seed) :
+  acc = seed
+  for idx in range(__WORK) :
+    acc = (acc * 1103515245 + 12345) & 0xffffffff
+  return acc
+
+# ---------------------------------------------------------------
+# Test run by each node. Every node runs the same sequence of
+# accesses and ticks, from the same cycle, so all are busy in the
+# same clock cycles, and each checks its data and that its
+# accesses completed in the cycles expected.
+# ---------------------------------------------------------------
+
+def run(node) :
+
+  errors = 0
+  vpapi  = pyvproc.PyVProcClass(node)
+
+  nodesSeen.append(node)
+
+  if inSubInterp() and nodesSeen != [node] :
+    vpapi.VPrint("NODE" + str(node) + ": ***ERROR: sub-interpreter shared with nodes " + str(nodesSeen))
+    errors += 1
+
+  start = vpapi.uread(__CYCLEADDR)
+  t0    = time.perf_counter()
+
+  for idx in range(__ITERATIONS) :
+    data = work(node * 1000 + idx)
+    addr = idx * 4
+
+    vpapi.write(addr, data)
+    vpapi.tick(__ITERTICKS)
+
+    rdata = vpapi.uread(addr)
+
+    if rdata != data :
+      vpapi.VPrint("NODE" + str(node) + ": ***ERROR: read " + hex(rdata) + " from addr " + hex(addr) + ", expected " + hex(data))
+      errors += 1
+
+  elapsed = time.perf_counter() - t0
+
+  # Each iteration is a write, the ticks and a read, after the read of the start cycle
+  count    = vpapi.uread(__CYCLEADDR)
+  expected = __ITERATIONS * (__ITERTICKS + 2) + 1
+
+  if count - start != expected :
+    vpapi.VPrint("NODE" + str(node) + ": ***ERROR: took " + str(count - start) + " cycles, expected " + str(expected))
+    errors += 1
+
+  vpapi.VPrint("NODE" + str(node) + ": " + ("FAIL" if errors else "PASS") + " with " + str(errors) +
+               " errors, in " + ("own" if inSubInterp() else "shared") + " interpreter, " +
+               str(round(elapsed, 3)) + "s")
+
+  vpapi.write(__DONEADDR, 1)
+
+  while True :
+    vpapi.tick(__LONGTIME)
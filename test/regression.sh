@@ -72,6 +72,191 @@ make -f makefile.verilator                              \
         run 2>&1 | egrep -i "error|fatal" | tee -a $LOGFILE
 echo "" | tee -a $LOGFILE
 
+#
+# Verilator multi-threaded stress test, single- and multi-threaded
+#
+echo "========= verilator multi-threaded test ========" $'\n' | tee -a $LOGFILE
+
+for threadsflag in "" "--threads 4 --threads-dpi all"
+do
+  echo "Running makefile.verilator with usercodeMT and THREADSFLAG=\"$threadsflag\" ..." | tee -a $LOGFILE
+  make -f makefile.verilator clean
+  make -f makefile.verilator                            \
+          USRCDIR=usercodeMT                            \
+          USER_C=VUserMain0.c                           \
+          FILELIST=files_mt.verilator                   \
+          BURSTDEF= VCDFLAG=                            \
+          THREADSFLAG="$threadsflag"                    \
+          2>&1 | egrep -i "error|fatal" | tee -a $LOGFILE
+  work/Vtest 2>&1 | egrep -i "error|fatal|fail" | tee -a $LOGFILE
+  make -f makefile.verilator clean
+  echo "" | tee -a $LOGFILE
+done
+
+#
+# Icarus node feature tests, on the multi-node testNodes.v
+#
+echo "========== icarus node feature tests ===========" $'\n' | tee -a $LOGFILE
+
+NODESFILES="testNodes.v ../f_VProc.v"
+NODESFLAGS="-DVPROC_BURST_IF -DVPROC_BYTE_ENABLE -I../"
+
+echo "Running makefile.ica with usercodeTwoPhase and VPROC_TWO_PHASE ..." | tee -a $LOGFILE
+make -f makefile.ica clean
+make -f makefile.ica                                    \
+        USRCDIR=usercodeTwoPhase                        \
+        USER_C=VUserMain0.c                             \
+        VLOGFILES="$NODESFILES"                         \
+        VLOGFLAGS="$NODESFLAGS -DVPROC_TWO_PHASE"       \
+        run 2>&1 | egrep -i "error|fatal|fail" | egrep -v "$FILTERSTR" | tee -a $LOGFILE
+make -f makefile.ica clean
+echo "" | tee -a $LOGFILE
+
+echo "Running makefile.ica with usercodeGroup and VPROC_TWO_PHASE ..." | tee -a $LOGFILE
+make -f makefile.ica clean
+make -f makefile.ica                                    \
+        USRCDIR=usercodeGroup                           \
+        USER_C=VUserMain0.c                             \
+        VLOGFILES="$NODESFILES"                         \
+        VLOGFLAGS="$NODESFLAGS -DVPROC_TWO_PHASE -Ptest.NUM_NODES=3" \
+        run 2>&1 | egrep -i "error|fatal|fail" | egrep -v "$FILTERSTR" | tee -a $LOGFILE
+make -f makefile.ica clean
+echo "" | tee -a $LOGFILE
+
+for twophase in "" "-DVPROC_TWO_PHASE" "-Ptest.IDLE_TIMED=1"
+do
+  echo "Running makefile.ica with usercodeMbox and VLOGFLAGS extra \"$twophase\" ..." | tee -a $LOGFILE
+  make -f makefile.ica clean
+  make -f makefile.ica                                  \
+          USRCDIR=usercodeMbox                          \
+          USER_C=VUserMain0.c                           \
+          VLOGFILES="$NODESFILES"                       \
+          VLOGFLAGS="$NODESFLAGS $twophase"             \
+          run 2>&1 | egrep -i "error|fatal|fail" | egrep -v "$FILTERSTR" | tee -a $LOGFILE
+  make -f makefile.ica clean
+  echo "" | tee -a $LOGFILE
+done
+
+echo "Running makefile.ica with usercodeTrace and VPROC_TRACE ..." | tee -a $LOGFILE
+make -f makefile.ica clean
+rm -f trace.json
+VPROC_TRACE=trace.json                                  \
+  make -f makefile.ica                                  \
+          USRCDIR=usercodeTrace                         \
+          USER_C=VUserMain0.c                           \
+          VLOGFILES="$NODESFILES"                       \
+          VLOGFLAGS="$NODESFLAGS -Ptest.NUM_NODES=2"    \
+          run 2>&1 | egrep -i "error|fatal|fail" | egrep -v "$FILTERSTR" | tee -a $LOGFILE
+python3 usercodeTrace/checktrace.py trace.json 2>&1 | tee -a $LOGFILE
+rm -f trace.json
+make -f makefile.ica clean
+echo "" | tee -a $LOGFILE
+
+echo "Running makefile.ica with usercodeCycleModel ..." | tee -a $LOGFILE
+make -f makefile.ica clean
+make -f makefile.ica                                    \
+        USRCDIR=usercodeCycleModel                      \
+        USER_C=VUserMain0.cpp                           \
+        VLOGFILES="$NODESFILES"                         \
+        VLOGFLAGS="$NODESFLAGS -Ptest.NUM_NODES=2"      \
+        run 2>&1 | egrep -i "error|fatal|fail" | egrep -v "$FILTERSTR" | tee -a $LOGFILE
+make -f makefile.ica clean
+echo "" | tee -a $LOGFILE
+
+for idletimed in 0 1
+do
+  echo "Running makefile.ica with usercodeIdle and IDLE_TIMED=$idletimed ..." | tee -a $LOGFILE
+  make -f makefile.ica clean
+  make -f makefile.ica                                  \
+          USRCDIR=usercodeIdle                          \
+          USER_C=VUserMain0.c                           \
+          VLOGFILES="$NODESFILES"                       \
+          VLOGFLAGS="$NODESFLAGS -Ptest.NUM_NODES=2 -Ptest.IDLE_TIMED=$idletimed" \
+          run 2>&1 | egrep -i "error|fatal|fail" | egrep -v "$FILTERSTR" | tee -a $LOGFILE
+  make -f makefile.ica clean
+  echo "" | tee -a $LOGFILE
+done
+
+echo "Running makefile.ica with usercodeShm and VPROC_SHM ..." | tee -a $LOGFILE
+make -f makefile.ica clean
+make -f makefile.ica                                    \
+        USRCDIR=usercodeShm                             \
+        USER_C=VUserMain0.c                             \
+        VLOGFILES="$NODESFILES"                         \
+        VLOGFLAGS="$NODESFLAGS -Ptest.NUM_NODES=2"      \
+        all client 2>&1 | egrep -i "error|fatal" | tee -a $LOGFILE
+gcc -c -g -DVPROC_SV -I../code usercodeShm/VUserMain0.c -o obj/vuser.o
+g++ obj/vuser.o -rdynamic -L. -lvprocclient -lpthread -lrt -ldl -o vuser
+VPROC_SHM=vproc_regress ./vuser 0 2>&1 | egrep -i "error|fatal|fail" | tee -a $LOGFILE &
+VPROC_SHM=vproc_regress VPROC_SHM_NODES=1               \
+  make -f makefile.ica                                  \
+          USRCDIR=usercodeShm                           \
+          USER_C=VUserMain0.c                           \
+          VLOGFILES="$NODESFILES"                       \
+          VLOGFLAGS="$NODESFLAGS -Ptest.NUM_NODES=2"    \
+          run 2>&1 | egrep -i "error|fatal|fail" | egrep -v "$FILTERSTR" | tee -a $LOGFILE
+wait
+rm -f vuser
+make -f makefile.ica clean
+echo "" | tee -a $LOGFILE
+
+#
+# Bridge test, partitioned across two Icarus simulations
+#
+echo "========== icarus partitioned bridge test ======" $'\n' | tee -a $LOGFILE
+
+BRIDGEFILES="testBridge.v ../bfm/bridgetgt.v ../f_VProc.v"
+
+echo "Running makefile.ica with usercodeBridge, on master and slave sides ..." | tee -a $LOGFILE
+make -f makefile.ica clean
+rm -rf bridgeslave
+mkdir bridgeslave
+make -f makefile.ica                                    \
+        TESTDIR=bridgeslave                             \
+        SIMEXE=bridgeslave/sim                          \
+        USRCDIR=usercodeBridge                          \
+        USER_C=VUserSlave.c                             \
+        VLOGFILES="$BRIDGEFILES"                        \
+        VLOGFLAGS="$NODESFLAGS -Ptest.SLAVE=1"          \
+        run 2>&1 | egrep -i "error|fatal|fail" | egrep -v "$FILTERSTR" | tee -a $LOGFILE &
+make -f makefile.ica                                    \
+        USRCDIR=usercodeBridge                          \
+        USER_C="VUserMain0.c VUserMain1.c"              \
+        VLOGFILES="$BRIDGEFILES"                        \
+        VLOGFLAGS="$NODESFLAGS"                         \
+        run 2>&1 | egrep -i "error|fatal|fail" | egrep -v "$FILTERSTR" | tee -a $LOGFILE
+wait
+make -f makefile.ica clean
+rm -rf bridgeslave
+echo "" | tee -a $LOGFILE
+
+#
+# Bus functional model tests
+#
+echo "============== icarus BFM tests ================" $'\n' | tee -a $LOGFILE
+
+echo "Running makefile.ica with usercodeAxi on the AXI4 BFM and memory ..." | tee -a $LOGFILE
+make -f makefile.ica clean
+make -f makefile.ica                                    \
+        USRCDIR=usercodeAxi                             \
+        USER_C=VUserMain0.c                             \
+        VLOGFILES="testAxi.v ../bfm/axi4bfm.v ../bfm/axi4mem.v ../f_VProc.v" \
+        VLOGFLAGS="$NODESFLAGS"                         \
+        run 2>&1 | egrep -i "error|fatal|fail" | egrep -v "$FILTERSTR" | tee -a $LOGFILE
+make -f makefile.ica clean
+echo "" | tee -a $LOGFILE
+
+echo "Running makefile.ica with usercodeAxis on a looped back AXI4-Stream BFM ..." | tee -a $LOGFILE
+make -f makefile.ica clean
+make -f makefile.ica                                    \
+        USRCDIR=usercodeAxis                            \
+        USER_C=VUserMain0.c                             \
+        VLOGFILES="testAxis.v ../bfm/axisbfm.v ../f_VProc.v" \
+        VLOGFLAGS="$NODESFLAGS"                         \
+        run 2>&1 | egrep -i "error|fatal|fail" | egrep -v "$FILTERSTR" | tee -a $LOGFILE
+make -f makefile.ica clean
+echo "" | tee -a $LOGFILE
+
 #
 # Python regression tests
 #
@@ -79,7 +264,7 @@ echo "" | tee -a $LOGFILE
 cd ../python/test
 
 echo "=========== python regression tests ============" $'\n' | tee -a $LOGFILE
-for usrcode in usercode
+for usrcode in usercode usercodeAsync
 do
   export PYTHONPATH=$usrcode
   for mkfile in $MKFILEBASE "makefile HDL=VHDL"
@@ -92,6 +277,26 @@ do
   done
 done
 
+#
+# Eight Python nodes scheduled together on testNodes.v. Each runs in its own
+# sub-interpreter (Python 3.13 or later), or all in the shared interpreter
+# with VPROC_PY_SHARED_INTERP
+#
+export PYTHONPATH=usercodeNodes
+for interp in "" "-DVPROC_PY_SHARED_INTERP"
+do
+  echo "Running makefile.ica with usercodeNodes/ and USRFLAGS \"$interp\" ..." | tee -a $LOGFILE
+  make -f makefile.ica clean
+  make -f makefile.ica                                  \
+          USRCDIR=usercodeNodes                         \
+          USRFLAGS="$interp"                            \
+          VLOGFILES="../../test/testNodes.v ../../f_VProc.v" \
+          VLOGFLAGS="-DVPROC_BURST_IF -DVPROC_BYTE_ENABLE -DVPROC_TWO_PHASE -I../.. -Ptest.NUM_NODES=8" \
+          run 2>&1 | egrep -i "error|fatal|fail" | egrep -v "$FILTERSTR" | tee -a $LOGFILE
+  make -f makefile.ica clean
+  echo "" | tee -a $LOGFILE
+done
+
 #
 # PCIe regression tests (if repository checked out)
 #
@@ -0,0 +1,323 @@
+/*
+ * Test environment for the VProc AXI4 BFM
+ *
+ * Copyright (c) 2024 Simon Southwell.
+ *
+ * This file is part of VProc.
+ *
+ * VProc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * VProc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with VProc. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+`timescale 1ns / 10ps
+
+//--------------------------------------------------------
+// Local definitions
+//--------------------------------------------------------
+
+`define DONE     32'hfffffff0
+`define TIMEOUT  200000
+
+// =======================================================
+// Top level test module. An AXI4 BFM (node 0) is connected
+// to a 256Kbyte AXI memory, at every address (modulo its
+// size). Each address handshake is checked for a burst
+// longer than 256 beats or crossing a 4Kbyte boundary,
+// and each burst's wlast or rlast for coming on its last
+// beat. When node 0 writes to DONE, bursts of the full 256
+// beats must have been made, with more than one, but no
+// more than OUTSTANDING, read bursts in flight at once,
+// and the simulation finishes.
+// =======================================================
+
+module test
+#(parameter
+            RD_LATENCY    = 4,
+            VCD_DUMP      = 0
+);
+
+localparam  ID_WIDTH      = 4;
+localparam  OUTSTANDING   = 4;
+
+reg                 clk;
+integer             count;
+
+// Burst checking state, with the lengths of the write bursts
+// addressed, and those seen on the write data channel, queued
+// in order, and each read ID's burst length and beats so far
+integer             awlens [0:255];
+integer             wlens  [0:255];
+integer             aw_num;
+integer             w_num;
+integer             w_chk;
+integer             wbeats;
+integer             arlens [0:(1 << ID_WIDTH)-1];
+integer             rbeats [0:(1 << ID_WIDTH)-1];
+integer             rd_out;
+integer             max_rd_out;
+integer             max_awlen;
+integer             max_arlen;
+
+wire         [31:0] awaddr;
+wire                awvalid;
+wire                awready;
+wire [ID_WIDTH-1:0] awid;
+wire          [7:0] awlen;
+
+wire         [31:0] wdata;
+wire                wvalid;
+wire                wready;
+wire                wlast;
+wire          [3:0] wstrb;
+
+wire                bvalid;
+wire                bready;
+wire [ID_WIDTH-1:0] bid;
+
+wire         [31:0] araddr;
+wire                arvalid;
+wire                arready;
+wire [ID_WIDTH-1:0] arid;
+wire          [7:0] arlen;
+
+wire         [31:0] rdata;
+wire                rvalid;
+wire                rready;
+wire                rlast;
+wire [ID_WIDTH-1:0] rid;
+
+//--------------------------------------------------------
+// Initial process
+//--------------------------------------------------------
+
+initial
+begin
+    // If enabled, dump all the signals to a VCD file
+    if (VCD_DUMP != 0)
+    begin
+      $dumpfile("waves.vcd");
+      $dumpvars(0, test);
+    end
+
+    clk         = 1'b1;
+    count       = 0;
+
+    aw_num      = 0;
+    w_num       = 0;
+    w_chk       = 0;
+    wbeats      = 0;
+    rd_out      = 0;
+    max_rd_out  = 0;
+    max_awlen   = 0;
+    max_arlen   = 0;
+
+    forever clk = #5 ~clk;
+end
+
+//--------------------------------------------------------
+// Simulation control process
+//--------------------------------------------------------
+
+always @(posedge clk)
+begin
+  count <= count + 1;
+
+  if (awvalid && awready && ({20'h0, awaddr[11:0]} + {awlen, 2'b00}) > 32'hffc)
+  begin
+    $display("***ERROR: write burst at %h of %0d beats crosses a 4K boundary", awaddr, awlen + 1);
+  end
+
+  if (arvalid && arready && ({20'h0, araddr[11:0]} + {arlen, 2'b00}) > 32'hffc)
+  begin
+    $display("***ERROR: read burst at %h of %0d beats crosses a 4K boundary", araddr, arlen + 1);
+  end
+
+  if (bfm.vpwe && bfm.vpwrack && bfm.vpaddr == `DONE)
+  begin
+    if (max_awlen != 255 || max_arlen != 255)
+    begin
+      $display("***ERROR: longest write burst %0d beats, and read burst %0d, expected 256", max_awlen + 1, max_arlen + 1);
+    end
+
+    if (max_rd_out < 2 || max_rd_out > OUTSTANDING)
+    begin
+      $display("***ERROR: at most %0d read bursts outstanding, expected 2 to %0d", max_rd_out, OUTSTANDING);
+    end
+
+    if (w_num != aw_num || wbeats != 0)
+    begin
+      $display("***ERROR: %0d write bursts addressed, and %0d (with %0d beats) written", aw_num, w_num, wbeats);
+    end
+
+    $display("Node 0 done at cycle %0d", count);
+    $finish;
+  end
+
+  if (count == `TIMEOUT-1)
+  begin
+    $display("***ERROR: simulation timed out");
+    $finish;
+  end
+end
+
+//--------------------------------------------------------
+// Burst checking process
+//--------------------------------------------------------
+
+always @(posedge clk)
+begin
+  // Write bursts, which may have their data before their address
+  if (awvalid && awready)
+  begin
+    awlens[aw_num % 256]        = awlen;
+    aw_num                      = aw_num + 1;
+    max_awlen                   = (awlen > max_awlen) ? awlen : max_awlen;
+  end
+
+  if (wvalid && wready)
+  begin
+    wbeats                      = wbeats + 1;
+
+    if (wlast)
+    begin
+      wlens[w_num % 256]        = wbeats;
+      w_num                     = w_num + 1;
+      wbeats                    = 0;
+    end
+  end
+
+  while (w_chk < aw_num && w_chk < w_num)
+  begin
+    if (wlens[w_chk % 256] != awlens[w_chk % 256] + 1)
+    begin
+      $display("***ERROR: write burst %0d of %0d beats had wlast on beat %0d", w_chk, awlens[w_chk % 256] + 1, wlens[w_chk % 256]);
+    end
+
+    w_chk                       = w_chk + 1;
+  end
+
+  // Read bursts, each outstanding one with its own ID
+  if (rvalid && rready)
+  begin
+    rbeats[rid]                 = rbeats[rid] + 1;
+
+    if (rlast !== (rbeats[rid] == arlens[rid] + 1))
+    begin
+      $display("***ERROR: read burst with ID %0d of %0d beats had rlast %b on beat %0d", rid, arlens[rid] + 1, rlast, rbeats[rid]);
+    end
+
+    if (rlast)
+    begin
+      rd_out                    = rd_out - 1;
+    end
+  end
+
+  if (arvalid && arready)
+  begin
+    arlens[arid]                = arlen;
+    rbeats[arid]                = 0;
+    rd_out                      = rd_out + 1;
+    max_rd_out                  = (rd_out > max_rd_out) ? rd_out : max_rd_out;
+    max_arlen                   = (arlen > max_arlen) ? arlen : max_arlen;
+  end
+end
+
+//--------------------------------------------------------
+// AXI4 BFM
+//--------------------------------------------------------
+
+axi4bfm #(.IRQWIDTH        (3),
+          .ID_WIDTH        (ID_WIDTH),
+          .MAX_OUTSTANDING (OUTSTANDING),
+          .NODE            (0)
+         ) bfm (
+  .clk                     (clk),
+
+  .awaddr                  (awaddr),
+  .awvalid                 (awvalid),
+  .awready                 (awready),
+  .awprot                  (),
+  .awid                    (awid),
+  .awlen                   (awlen),
+  .awsize                  (),
+  .awburst                 (),
+
+  .wdata                   (wdata),
+  .wvalid                  (wvalid),
+  .wready                  (wready),
+  .wlast                   (wlast),
+  .wstrb                   (wstrb),
+
+  .bvalid                  (bvalid),
+  .bready                  (bready),
+  .bid                     (bid),
+
+  .araddr                  (araddr),
+  .arvalid                 (arvalid),
+  .arready                 (arready),
+  .arprot                  (),
+  .arid                    (arid),
+  .arlen                   (arlen),
+  .arsize                  (),
+  .arburst                 (),
+
+  .rdata                   (rdata),
+  .rvalid                  (rvalid),
+  .rready                  (rready),
+  .rlast                   (rlast),
+  .rid                     (rid),
+
+  .irq                     (3'b000)
+);
+
+//--------------------------------------------------------
+// AXI4 memory
+//--------------------------------------------------------
+
+axi4mem #(.ID_WIDTH        (ID_WIDTH),
+          .MEM_LOG2        (16),
+          .RD_LATENCY      (RD_LATENCY)
+         ) mem (
+  .clk                     (clk),
+
+  .awaddr                  (awaddr),
+  .awvalid                 (awvalid),
+  .awready                 (awready),
+  .awid                    (awid),
+  .awlen                   (awlen),
+
+  .wdata                   (wdata),
+  .wvalid                  (wvalid),
+  .wready                  (wready),
+  .wlast                   (wlast),
+  .wstrb                   (wstrb),
+
+  .bvalid                  (bvalid),
+  .bready                  (bready),
+  .bid                     (bid),
+
+  .araddr                  (araddr),
+  .arvalid                 (arvalid),
+  .arready                 (arready),
+  .arid                    (arid),
+  .arlen                   (arlen),
+
+  .rdata                   (rdata),
+  .rvalid                  (rvalid),
+  .rready                  (rready),
+  .rlast                   (rlast),
+  .rid                     (rid)
+);
+
+endmodule
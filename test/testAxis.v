@@ -0,0 +1,214 @@
+/*
+ * Loopback test environment for the VProc AXI4-Stream BFM
+ *
+ * Copyright (c) 2024 Simon Southwell.
+ *
+ * This file is part of VProc.
+ *
+ * VProc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * VProc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with VProc. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+`timescale 1ns / 10ps
+
+//--------------------------------------------------------
+// Local definitions
+//--------------------------------------------------------
+
+`define DONE     32'hfffffff0
+`define TIMEOUT  200000
+
+// Frames sent by node 0 (see usercodeAxis/VUserMain0.c)
+`define FRAMES   26
+
+// =======================================================
+// Top level test module. An AXI4-Stream BFM (node 0) has
+// its transmit stream looped back to its receive stream.
+// With STALL set, the loop is stalled on a pseudo-random
+// pattern of cycles, so that the BFM sees backpressure
+// and gaps in the received stream. Each beat is checked
+// for tkeep being full, other than on a frame's last beat
+// with tlast, where it must be packed, and for tuser held
+// through the frame. A stalled beat must be held until
+// it's taken. The simulation finishes when node 0 writes
+// to DONE, when every frame must have ended with tlast,
+// and, with STALL set, the BFM must have been stalled.
+// =======================================================
+
+module test
+#(parameter
+            STALL         = 1,
+            VCD_DUMP      = 0
+);
+
+reg         clk;
+integer     count;
+reg   [7:0] lfsr;
+
+// Stream checking state, with the last stalled beat
+reg         stalled;
+reg  [31:0] held_data;
+reg         held_last;
+reg   [3:0] held_keep;
+reg   [7:0] held_user;
+reg         in_frame;
+reg   [7:0] frame_user;
+integer     frames;
+integer     stalls;
+
+wire [31:0] tdata;
+wire        tx_tvalid;
+wire        tx_tready;
+wire        rx_tvalid;
+wire        rx_tready;
+wire        tlast;
+wire  [3:0] tkeep;
+wire  [7:0] tuser;
+
+// The loop passes a beat only on cycles it isn't stalled
+wire        go = (STALL == 0) | ~(lfsr[0] & lfsr[3]);
+
+assign rx_tvalid = tx_tvalid & go;
+assign tx_tready = rx_tready & go;
+
+//--------------------------------------------------------
+// Initial process
+//--------------------------------------------------------
+
+initial
+begin
+    // If enabled, dump all the signals to a VCD file
+    if (VCD_DUMP != 0)
+    begin
+      $dumpfile("waves.vcd");
+      $dumpvars(0, test);
+    end
+
+    clk         = 1'b1;
+    count       = 0;
+    lfsr        = 8'hff;
+
+    stalled     = 1'b0;
+    in_frame    = 1'b0;
+    frames      = 0;
+    stalls      = 0;
+
+    forever clk = #5 ~clk;
+end
+
+//--------------------------------------------------------
+// Simulation control process
+//--------------------------------------------------------
+
+always @(posedge clk)
+begin
+  count <= count + 1;
+  lfsr  <= {lfsr[6:0], lfsr[7] ^ lfsr[5] ^ lfsr[4] ^ lfsr[3]};
+
+  if (bfm.vpwe && bfm.vpaddr == `DONE)
+  begin
+    if (frames != `FRAMES || in_frame)
+    begin
+      $display("***ERROR: %0d frames ended with tlast, expected %0d", frames, `FRAMES);
+    end
+
+    if (STALL != 0 && stalls == 0)
+    begin
+      $display("***ERROR: transmit stream never stalled");
+    end
+
+    $display("Node 0 done at cycle %0d", count);
+    $finish;
+  end
+
+  if (count == `TIMEOUT-1)
+  begin
+    $display("***ERROR: simulation timed out");
+    $finish;
+  end
+end
+
+//--------------------------------------------------------
+// Stream checking process
+//--------------------------------------------------------
+
+always @(posedge clk)
+begin
+  if (stalled && (tx_tvalid !== 1'b1 || tdata !== held_data || tlast !== held_last ||
+                  tkeep !== held_keep || tuser !== held_user))
+  begin
+    $display("***ERROR: stalled beat changed at cycle %0d", count);
+  end
+
+  if (tx_tvalid && tx_tready)
+  begin
+    if (!tlast && tkeep !== 4'hf)
+    begin
+      $display("***ERROR: beat with tkeep %h before the end of a frame at cycle %0d", tkeep, count);
+    end
+
+    if (tlast && tkeep !== 4'h1 && tkeep !== 4'h3 && tkeep !== 4'h7 && tkeep !== 4'hf)
+    begin
+      $display("***ERROR: last beat with unpacked tkeep %h at cycle %0d", tkeep, count);
+    end
+
+    if (in_frame && tuser !== frame_user)
+    begin
+      $display("***ERROR: tuser changed from %h to %h within a frame at cycle %0d", frame_user, tuser, count);
+    end
+
+    in_frame                    = ~tlast;
+    frame_user                  = tuser;
+    frames                      = frames + tlast;
+  end
+
+  stalled                       = tx_tvalid && !tx_tready;
+
+  if (stalled)
+  begin
+    stalls                      = stalls + 1;
+    held_data                   = tdata;
+    held_last                   = tlast;
+    held_keep                   = tkeep;
+    held_user                   = tuser;
+  end
+end
+
+//--------------------------------------------------------
+// AXI4-Stream BFM
+//--------------------------------------------------------
+
+axisbfm #(.IRQWIDTH        (3),
+          .NODE            (0)
+         ) bfm (
+  .clk                     (clk),
+
+  .tx_tdata                (tdata),
+  .tx_tvalid               (tx_tvalid),
+  .tx_tready               (tx_tready),
+  .tx_tlast                (tlast),
+  .tx_tkeep                (tkeep),
+  .tx_tuser                (tuser),
+
+  .rx_tdata                (tdata),
+  .rx_tvalid               (rx_tvalid),
+  .rx_tready               (rx_tready),
+  .rx_tlast                (tlast),
+  .rx_tkeep                (tkeep),
+  .rx_tuser                (tuser),
+
+  .irq                     (3'b000)
+);
+
+endmodule
@@ -0,0 +1,224 @@
+/*
+ * Partitioned simulation test environment for the VProc bridge
+ *
+ * Copyright (c) 2024 Simon Southwell.
+ *
+ * This file is part of VProc.
+ *
+ * VProc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * VProc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with VProc. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+`timescale 1ns / 10ps
+
+//--------------------------------------------------------
+// Local definitions
+//--------------------------------------------------------
+
+`define DONE     32'hfffffff0
+`define TIMEOUT  100000
+
+// =======================================================
+// Top level test module, for either side of a bridge, run
+// as two simulations. With SLAVE clear, node 0 is a CPU
+// whose accesses to 0x8xxxxxxx are made on the target port
+// of a bridgetgt (node 1), and whose interrupt input is the
+// bridgetgt's irq_out. With SLAVE set, node 0 replays the
+// bridged accesses on a 1K word memory at 0x80000000, with
+// a register at 0x80001000 driving its interrupt input,
+// which is reflected back to the CPU. Each simulation
+// finishes when its node 0 writes to DONE.
+// =======================================================
+
+module test
+#(parameter
+            SLAVE         = 0,
+            VCD_DUMP      = 0
+);
+
+reg         clk;
+integer     count;
+
+wire [31:0] addr;
+wire [31:0] wdata;
+wire  [3:0] be;
+wire        write;
+wire        read;
+wire        update;
+reg         updateresp;
+wire [31:0] rdata;
+wire        wrack;
+wire        rdack;
+wire  [2:0] irq;
+
+//--------------------------------------------------------
+// Initial process
+//--------------------------------------------------------
+
+initial
+begin
+    // If enabled, dump all the signals to a VCD file
+    if (VCD_DUMP != 0)
+    begin
+      $dumpfile("waves.vcd");
+      $dumpvars(0, test);
+    end
+
+    clk         = 1'b1;
+    count       = 0;
+    updateresp  = 1'b0;
+
+    forever clk = #5 ~clk;
+end
+
+//--------------------------------------------------------
+// Simulation control process
+//--------------------------------------------------------
+
+always @(posedge clk)
+begin
+  count <= count + 1;
+
+  if (write && addr == `DONE)
+  begin
+    $display("%s side done at cycle %0d", SLAVE ? "Slave" : "Master", count);
+    $finish;
+  end
+
+  if (count == `TIMEOUT-1)
+  begin
+    $display("***ERROR: simulation timed out");
+    $finish;
+  end
+end
+
+always @(update)
+begin
+  updateresp <= ~updateresp;
+end
+
+`ifndef VPROC_BYTE_ENABLE
+assign be = 4'hf;
+`endif
+
+//--------------------------------------------------------
+// Node 0
+//--------------------------------------------------------
+
+VProc #(.BURST_ADDR_INCR (4)) vp (
+  .Clk                   (clk),
+
+  .Addr                  (addr),
+`ifdef VPROC_BYTE_ENABLE
+  .BE                    (be),
+`endif
+
+  .WE                    (write),
+  .WRAck                 (wrack),
+  .DataOut               (wdata),
+
+  .RD                    (read),
+  .RDAck                 (rdack),
+  .DataIn                (rdata),
+
+  .Interrupt             (irq),
+
+  .Update                (update),
+  .UpdateResponse        (updateresp),
+`ifdef VPROC_BURST_IF
+  .Burst                 (),
+  .BurstFirst            (),
+  .BurstLast             (),
+`endif
+
+  .Node                  (4'd0)
+);
+
+generate
+  if (SLAVE == 0)
+  begin : master_g
+
+    //--------------------------------------------------------
+    // Master side: node 0's bridged accesses go to a bridge
+    // target, acknowledged when the slave side responds
+    //--------------------------------------------------------
+
+    wire        sel    = (addr[31:28] == 4'h8);
+    wire        ack;
+    wire [31:0] tgtdata;
+
+    assign wrack       = ~sel | ack;
+    assign rdack       = ~sel | ack;
+    assign rdata       = sel ? tgtdata : 32'h0;
+
+    bridgetgt #(.IRQWIDTH (3),
+                .NODE     (1)
+               ) tgt (
+      .clk               (clk),
+
+      .addr              (addr),
+      .wdata             (wdata),
+      .be                (be),
+      .we                (write & sel),
+      .rd                (read  & sel),
+      .ack               (ack),
+      .rdata             (tgtdata),
+
+      .irq_out           (irq)
+    );
+
+  end
+  else
+  begin : slave_g
+
+    //--------------------------------------------------------
+    // Slave side: memory and an interrupt register
+    //--------------------------------------------------------
+
+    reg  [31:0] mem [0:1023];
+    reg   [2:0] irqreg;
+
+    wire        memcs  = (addr[31:12] == 20'h80000);
+    wire        irqcs  = (addr == 32'h80001000);
+
+    initial
+    begin
+      irqreg           = 3'b000;
+    end
+
+    assign wrack       = write;
+    assign rdack       = read;
+    assign rdata       = irqcs ? {29'h0, irqreg} : mem[addr[11:2]];
+    assign irq         = irqreg;
+
+    always @(posedge clk)
+    begin
+      if (write && memcs)
+      begin
+        mem[addr[11:2]] <= {be[3] ? wdata[31:24] : mem[addr[11:2]][31:24],
+                            be[2] ? wdata[23:16] : mem[addr[11:2]][23:16],
+                            be[1] ? wdata[15:8]  : mem[addr[11:2]][15:8],
+                            be[0] ? wdata[7:0]   : mem[addr[11:2]][7:0]};
+      end
+
+      if (write && irqcs)
+      begin
+        irqreg         <= wdata[2:0];
+      end
+    end
+
+  end
+endgenerate
+
+endmodule
@@ -0,0 +1,157 @@
+/*
+ * Multi-node stress test environment for VProc with Verilator --threads
+ *
+ * Copyright (c) 2024 Simon Southwell.
+ *
+ * This file is part of VProc.
+ *
+ * VProc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * VProc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with VProc. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+`timescale 1ns / 10ps
+
+//--------------------------------------------------------
+// Local definitions
+//--------------------------------------------------------
+
+`define DONE     32'hfffffff0
+`define TIMEOUT  100000
+
+// =======================================================
+// Top level test module. Each node has its own memory,
+// and no logic is shared between nodes, so that Verilator
+// can evaluate them on separate threads.
+// =======================================================
+
+module test
+#(parameter
+            NUM_NODES     = 8,       // Valid range => 1 to 16
+            VCD_DUMP      = 0
+);
+
+reg                  clk;
+integer              count;
+
+wire [NUM_NODES-1:0] done;
+
+//--------------------------------------------------------
+// Initial process
+//--------------------------------------------------------
+
+initial
+begin
+    // If enabled, dump all the signals to a VCD file
+    if (VCD_DUMP != 0)
+    begin
+      $dumpfile("waves.vcd");
+      $dumpvars(0, test);
+    end
+
+    clk         = 1'b1;
+    count       = 0;
+
+    forever clk = #5 ~clk;
+end
+
+//--------------------------------------------------------
+// Simulation control process
+//--------------------------------------------------------
+
+always @(posedge clk)
+begin
+  count <= count + 1;
+
+  if (&done)
+  begin
+    $display("All %0d nodes done at cycle %0d", NUM_NODES, count);
+    $finish;
+  end
+
+  if (count == `TIMEOUT-1)
+  begin
+    $display("***ERROR: simulation timed out");
+    $finish;
+  end
+end
+
+//--------------------------------------------------------
+// VProc nodes, each with a local memory
+//--------------------------------------------------------
+
+genvar gi;
+
+generate
+  for (gi = 0; gi < NUM_NODES; gi = gi + 1)
+  begin : node_g
+
+    wire [31:0] addr;
+    wire [31:0] wdata;
+    wire        write;
+    wire        read;
+    wire        update;
+    reg         updateresp;
+    reg         ndone;
+    reg  [31:0] mem [0:255];
+
+    initial
+    begin
+      updateresp = 1'b0;
+      ndone      = 1'b0;
+    end
+
+    assign done[gi] = ndone;
+
+    always @(posedge clk)
+    begin
+      if (write)
+      begin
+        mem[addr[9:2]] <= wdata;
+
+        if (addr == `DONE)
+        begin
+          ndone        <= 1'b1;
+        end
+      end
+    end
+
+    always @(update)
+    begin
+      updateresp <= ~updateresp;
+    end
+
+    VProc vp (
+      .Clk                   (clk),
+
+      .Addr                  (addr),
+
+      .WE                    (write),
+      .WRAck                 (write),
+      .DataOut               (wdata),
+
+      .RD                    (read),
+      .RDAck                 (read),
+      .DataIn                (mem[addr[9:2]]),
+
+      .Interrupt             (3'b000),
+
+      .Update                (update),
+      .UpdateResponse        (updateresp),
+
+      .Node                  (gi[3:0])
+    );
+  end
+endgenerate
+
+endmodule
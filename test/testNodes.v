@@ -0,0 +1,195 @@
+/*
+ * Multi-node test environment for the VProc node features
+ *
+ * Copyright (c) 2024 Simon Southwell.
+ *
+ * This file is part of VProc.
+ *
+ * VProc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * VProc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with VProc. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+`timescale 1ns / 10ps
+
+//--------------------------------------------------------
+// Local definitions
+//--------------------------------------------------------
+
+`define DONE     32'hfffffff0
+`define CYCLE    32'hfffffff8
+`define IRQBASE  32'hffffff00
+`define TIMEOUT  100000
+
+// =======================================================
+// Top level test module. Each node has its own 1K word
+// memory at 0x00000000, with byte enables and bursts, and
+// reads the test bench's cycle count at CYCLE. A write to
+// IRQBASE + 4*n sets node n's interrupt input to the
+// bottom three bits of the data. The simulation finishes
+// when every node has written to DONE.
+// =======================================================
+
+module test
+#(parameter
+            NUM_NODES     = 4,       // Valid range => 1 to 16
+            IDLE_TIMED    = 0,
+            VCD_DUMP      = 0
+);
+
+reg                    clk;
+integer                count;
+
+wire   [NUM_NODES-1:0] done;
+reg  [3*NUM_NODES-1:0] irq;
+
+//--------------------------------------------------------
+// Initial process
+//--------------------------------------------------------
+
+initial
+begin
+    // If enabled, dump all the signals to a VCD file
+    if (VCD_DUMP != 0)
+    begin
+      $dumpfile("waves.vcd");
+      $dumpvars(0, test);
+    end
+
+    clk         = 1'b1;
+    count       = 0;
+    irq         = {3*NUM_NODES{1'b0}};
+
+    forever clk = #5 ~clk;
+end
+
+//--------------------------------------------------------
+// Simulation control process
+//--------------------------------------------------------
+
+always @(posedge clk)
+begin
+  count <= count + 1;
+
+  if (&done)
+  begin
+    $display("All %0d nodes done at cycle %0d", NUM_NODES, count);
+    $finish;
+  end
+
+  if (count == `TIMEOUT-1)
+  begin
+    $display("***ERROR: simulation timed out");
+    $finish;
+  end
+end
+
+//--------------------------------------------------------
+// VProc nodes, each with a local memory
+//--------------------------------------------------------
+
+genvar gi;
+
+generate
+  for (gi = 0; gi < NUM_NODES; gi = gi + 1)
+  begin : node_g
+
+    wire [31:0] addr;
+    wire [31:0] wdata;
+    wire  [3:0] be;
+    wire        write;
+    wire        read;
+    wire        update;
+    reg         updateresp;
+    reg         ndone;
+    reg  [31:0] mem [0:1023];
+
+    wire        memcs    = (addr[31:12] == 20'h00000);
+    wire [31:0] rdata    = (addr == `CYCLE) ? count : mem[addr[11:2]];
+    wire  [3:0] node_num = gi;
+
+`ifndef VPROC_BYTE_ENABLE
+    assign be = 4'hf;
+`endif
+
+    initial
+    begin
+      updateresp = 1'b0;
+      ndone      = 1'b0;
+    end
+
+    assign done[gi] = ndone;
+
+    always @(posedge clk)
+    begin
+      if (write)
+      begin
+        if (memcs)
+        begin
+          mem[addr[11:2]] <= {be[3] ? wdata[31:24] : mem[addr[11:2]][31:24],
+                              be[2] ? wdata[23:16] : mem[addr[11:2]][23:16],
+                              be[1] ? wdata[15:8]  : mem[addr[11:2]][15:8],
+                              be[0] ? wdata[7:0]   : mem[addr[11:2]][7:0]};
+        end
+
+        if (addr[31:8] == `IRQBASE >> 8 && addr[7:2] < NUM_NODES)
+        begin
+          irq[3*addr[7:2] +: 3] <= wdata[2:0];
+        end
+
+        if (addr == `DONE)
+        begin
+          ndone   <= 1'b1;
+        end
+      end
+    end
+
+    always @(update)
+    begin
+      updateresp <= ~updateresp;
+    end
+
+    VProc #(.BURST_ADDR_INCR (4),
+            .IDLE_TIMED      (IDLE_TIMED)
+           ) vp (
+      .Clk                   (clk),
+
+      .Addr                  (addr),
+`ifdef VPROC_BYTE_ENABLE
+      .BE                    (be),
+`endif
+
+      .WE                    (write),
+      .WRAck                 (write),
+      .DataOut               (wdata),
+
+      .RD                    (read),
+      .RDAck                 (read),
+      .DataIn                (rdata),
+
+      .Interrupt             (irq[3*gi +: 3]),
+
+      .Update                (update),
+      .UpdateResponse        (updateresp),
+`ifdef VPROC_BURST_IF
+      .Burst                 (),
+      .BurstFirst            (),
+      .BurstLast             (),
+`endif
+
+      .Node                  (node_num)
+    );
+  end
+endgenerate
+
+endmodule
@@ -0,0 +1,206 @@
+/**************************************************************/
+/* VUserMain0.c                              Date: 2024/07/22 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell.                        */
+/* All rights reserved.                                       */
+/*                                                            */
+/**************************************************************/
+
+// AXI4 BFM test user code for testAxi.v. Node 0 checks single word
+// and byte enabled accesses, then burst writes and reads of lengths
+// from a single beat up to near the VProc maximum, at offsets which
+// split them into AXI bursts at 256 beats and at 4Kbyte boundaries.
+// Each burst is read back whole, and as smaller bursts straddling
+// the AXI burst boundaries, so that the BFM's reassembly of reads
+// issued as several outstanding AXI bursts is checked.
+
+#include "VUser.h"
+
+// ------------------------------------------------------------
+// LOCAL DEFINITIONS
+// ------------------------------------------------------------
+
+#define MEM_BYTES      0x40000
+#define DONE_ADDR      0xfffffff0
+
+// ------------------------------------------------------------
+// LOCAL STATICS
+// ------------------------------------------------------------
+
+static unsigned errors = 0;
+
+static uint32_t wbuf[MAXBURSTLEN];
+static uint32_t rbuf[MAXBURSTLEN];
+
+// Burst start addresses and lengths (in words)
+static const struct {
+    unsigned addr;
+    unsigned len;
+} bursts[] = {
+    {0x00000100,    1},
+    {0x00000200,    2},
+    {0x00000ff8,    4},     // Crosses a 4K boundary
+    {0x00001000,  256},     // A whole AXI burst
+    {0x00002000,  257},     // One beat more than an AXI burst
+    {0x00003c00, 1000},     // Crosses a 4K boundary part way through
+    {0x00005ffc, 1025},     // Crosses a 4K boundary after one beat
+    {0x00008004, 4095}      // Longest VProc burst, over several 4K pages
+};
+
+// ------------------------------------------------------------
+// Data pattern for a word address
+// ------------------------------------------------------------
+
+static uint32_t pattern(const unsigned addr, const unsigned seed)
+{
+    return (addr * 0x9e3779b1) ^ (seed << 24) ^ addr;
+}
+
+// ------------------------------------------------------------
+// Check read back words against the pattern
+// ------------------------------------------------------------
+
+static void checkWords(const char* what, const unsigned addr, const uint32_t* buf, const unsigned len, const unsigned seed)
+{
+    unsigned idx;
+    unsigned bad = 0;
+
+    for (idx = 0; idx < len; idx++)
+    {
+        uint32_t exp = pattern(addr + idx*4, seed);
+
+        if (buf[idx] != exp)
+        {
+            if (bad++ < 4)
+            {
+                VPrint("***ERROR: %s at 0x%08x, word %d of %d, read 0x%08x, expected 0x%08x\n",
+                       what, addr, idx, len, buf[idx], exp);
+            }
+        }
+    }
+
+    errors += bad;
+}
+
+// ------------------------------------------------------------
+// VuserMainX entry point for node 0
+// ------------------------------------------------------------
+
+void VUserMain0()
+{
+    const unsigned node = 0;
+    unsigned       data, exp;
+    unsigned       addr, len, idx, off;
+    int            bdx;
+
+    VPrint("VUserMain0(): node=%d\n", node);
+
+    // Single word writes and reads, including the last word
+    for (addr = 0; addr < MEM_BYTES; addr += 0x3ff4)
+    {
+        VWrite(addr, pattern(addr, 1), 0, node);
+    }
+
+    for (addr = 0; addr < MEM_BYTES; addr += 0x3ff4)
+    {
+        VRead(addr, &data, 0, node);
+
+        if (data != pattern(addr, 1))
+        {
+            VPrint("***ERROR: word read at 0x%08x was 0x%08x, expected 0x%08x\n", addr, data, pattern(addr, 1));
+            errors++;
+        }
+    }
+
+    // Byte and half word writes, over a word of all ones
+    for (idx = 1; idx < 16; idx++)
+    {
+        addr = 0x400 + idx*4;
+
+        VWrite(addr, 0xffffffff, 0, node);
+        VWriteBE(addr, 0x11223344 * idx, idx, 0, node);
+    }
+
+    for (idx = 1; idx < 16; idx++)
+    {
+        addr = 0x400 + idx*4;
+        exp  = 0;
+
+        for (off = 0; off < 4; off++)
+        {
+            exp |= ((idx >> off) & 1) ? ((0x11223344 * idx) & (0xff << off*8)) : (0xff << off*8);
+        }
+
+        VRead(addr, &data, 0, node);
+
+        if (data != exp)
+        {
+            VPrint("***ERROR: byte enable 0x%x write at 0x%08x read 0x%08x, expected 0x%08x\n", idx, addr, data, exp);
+            errors++;
+        }
+    }
+
+    // Bursts, read back whole, and in pieces crossing the AXI bursts they were split into
+    for (bdx = 0; bdx < (int)(sizeof(bursts)/sizeof(bursts[0])); bdx++)
+    {
+        addr = bursts[bdx].addr;
+        len  = bursts[bdx].len;
+
+        for (idx = 0; idx < len; idx++)
+        {
+            wbuf[idx] = pattern(addr + idx*4, 2);
+        }
+
+        VBurstWrite(addr, wbuf, len, node);
+
+        VBurstRead(addr, rbuf, len, node);
+        checkWords("burst read", addr, rbuf, len, 2);
+
+        for (off = 0; off < len; off += 300)
+        {
+            unsigned plen = (len - off > 300) ? 300 : len - off;
+
+            VBurstRead(addr + off*4, rbuf, plen, node);
+            checkWords("part burst read", addr + off*4, rbuf, plen, 2);
+        }
+    }
+
+    // A burst write with partial first and last words
+    addr = 0x00020ffc;
+    len  = 300;
+
+    for (idx = 0; idx < len; idx++)
+    {
+        wbuf[idx] = 0xffffffff;
+    }
+
+    VBurstWrite(addr, wbuf, len, node);
+
+    for (idx = 0; idx < len; idx++)
+    {
+        wbuf[idx] = pattern(addr + idx*4, 3);
+    }
+
+    VBurstWriteBE(addr, wbuf, len, 0xc, 0x3, node);
+    VBurstRead(addr, rbuf, len, node);
+
+    // Only the top half of the first word, and bottom half of the last, are written
+    if (rbuf[0]     != ((pattern(addr, 3)              & 0xffff0000) | 0x0000ffff) ||
+        rbuf[len-1] != ((pattern(addr + (len-1)*4, 3) & 0x0000ffff) | 0xffff0000))
+    {
+        VPrint("***ERROR: byte enabled burst read first word 0x%08x, last word 0x%08x\n", rbuf[0], rbuf[len-1]);
+        errors++;
+    }
+
+    checkWords("byte enabled burst read", addr + 4, rbuf + 1, len - 2, 3);
+
+    VPrint("VUserMain%d(): %s with %d errors\n", node, errors ? "FAIL" : "PASS", errors);
+
+    VWrite(DONE_ADDR, 1, 0, node);
+
+    // Sleep until the simulation finishes
+    while (1)
+    {
+        VTick(GO_TO_SLEEP, node);
+    }
+}
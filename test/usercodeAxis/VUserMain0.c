@@ -0,0 +1,162 @@
+/**************************************************************/
+/* VUserMain0.c                              Date: 2024/07/22 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell.                        */
+/* All rights reserved.                                       */
+/*                                                            */
+/**************************************************************/
+
+// AXI4-Stream BFM test user code for testAxis.v, where node 0's
+// transmit stream is looped back to its receive stream. Frames of
+// lengths from a single byte up to longer than one VStreamSend()
+// burst are each sent and received back, checking their length,
+// tuser and contents. A batch of short frames is then sent before
+// any is received, to check the BFM queues whole frames, and a
+// frame is received into a buffer shorter than it.
+
+#include <string.h>
+#include "VUser.h"
+
+// ------------------------------------------------------------
+// LOCAL DEFINITIONS
+// ------------------------------------------------------------
+
+#define MAX_FRAME      16000
+#define BATCH_FRAMES   12
+#define MAX_POLLS      1000
+#define SHORT_LEN      50
+#define DONE_ADDR      0xfffffff0
+
+// ------------------------------------------------------------
+// LOCAL STATICS
+// ------------------------------------------------------------
+
+static unsigned errors = 0;
+
+static uint8_t  txbuf[MAX_FRAME];
+static uint8_t  rxbuf[MAX_FRAME];
+
+static const unsigned lens[] = {1, 2, 3, 4, 5, 63, 64, 100, 1000, 8191, 8192, 8193, MAX_FRAME};
+
+// ------------------------------------------------------------
+// Fill a frame with a pattern for its sequence number
+// ------------------------------------------------------------
+
+static void fillFrame(uint8_t* buf, const unsigned len, const unsigned seq)
+{
+    unsigned idx;
+
+    for (idx = 0; idx < len; idx++)
+    {
+        buf[idx] = (uint8_t)(idx * 7 + seq * 13 + (idx >> 8));
+    }
+}
+
+// ------------------------------------------------------------
+// Receive a frame, polling until one has arrived, and check
+// it against the pattern for its sequence number
+// ------------------------------------------------------------
+
+static void checkFrame(const unsigned len, const unsigned tuser, const unsigned seq, const unsigned node)
+{
+    unsigned rxuser = 0;
+    int      rxlen  = 0;
+    int      polls;
+
+    for (polls = 0; polls < MAX_POLLS && rxlen == 0; polls++)
+    {
+        rxlen = VStreamRecv(rxbuf, sizeof(rxbuf), &rxuser, node);
+
+        if (rxlen == 0)
+        {
+            VTick(10, node);
+        }
+    }
+
+    fillFrame(txbuf, len, seq);
+
+    if (rxlen != (int)len || rxuser != tuser)
+    {
+        VPrint("***ERROR: frame %d received with length %d and tuser 0x%02x, expected %d and 0x%02x\n",
+               seq, rxlen, rxuser, len, tuser);
+        errors++;
+    }
+    else if (memcmp(rxbuf, txbuf, len))
+    {
+        VPrint("***ERROR: frame %d of length %d received with bad data\n", seq, len);
+        errors++;
+    }
+}
+
+// ------------------------------------------------------------
+// VuserMainX entry point for node 0
+// ------------------------------------------------------------
+
+void VUserMain0()
+{
+    const unsigned node = 0;
+    unsigned       seq  = 0;
+    unsigned       tuser;
+    int            rxlen, idx;
+
+    VPrint("VUserMain0(): node=%d\n", node);
+
+    // Nothing received before anything is sent
+    if (VStreamRecv(rxbuf, sizeof(rxbuf), &tuser, node) != 0)
+    {
+        VPrint("***ERROR: frame received before any sent\n");
+        errors++;
+    }
+
+    // Frames sent and received one at a time
+    for (idx = 0; idx < (int)(sizeof(lens)/sizeof(lens[0])); idx++, seq++)
+    {
+        fillFrame(txbuf, lens[idx], seq);
+        VStreamSend(txbuf, lens[idx], seq & VSTREAM_TUSER_MASK, node);
+
+        checkFrame(lens[idx], seq & VSTREAM_TUSER_MASK, seq, node);
+    }
+
+    // A batch of frames, all sent before any is received
+    for (idx = 0; idx < BATCH_FRAMES; idx++)
+    {
+        fillFrame(txbuf, idx + 1, seq + idx);
+        VStreamSend(txbuf, idx + 1, 0xa0 + idx, node);
+    }
+
+    for (idx = 0; idx < BATCH_FRAMES; idx++)
+    {
+        checkFrame(idx + 1, 0xa0 + idx, seq + idx, node);
+    }
+
+    seq += BATCH_FRAMES;
+
+    // A frame longer than the receive buffer is truncated, with its full length returned
+    fillFrame(txbuf, 100, seq);
+    VStreamSend(txbuf, 100, 0xff, node);
+
+    memset(rxbuf, 0, sizeof(rxbuf));
+
+    do
+    {
+        VTick(10, node);
+        rxlen = VStreamRecv(rxbuf, SHORT_LEN, &tuser, node);
+    }
+    while (rxlen == 0);
+
+    if (rxlen != 100 || tuser != 0xff || memcmp(rxbuf, txbuf, SHORT_LEN) || rxbuf[SHORT_LEN] != 0)
+    {
+        VPrint("***ERROR: truncated frame received with length %d and tuser 0x%02x, or bad data\n", rxlen, tuser);
+        errors++;
+    }
+
+    VPrint("VUserMain%d(): %s with %d errors\n", node, errors ? "FAIL" : "PASS", errors);
+
+    VWrite(DONE_ADDR, 1, 0, node);
+
+    // Sleep until the simulation finishes
+    while (1)
+    {
+        VTick(GO_TO_SLEEP, node);
+    }
+}
@@ -0,0 +1,22 @@
+/**************************************************************/
+/* VUserBridge.h                             Date: 2024/07/22 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell.                        */
+/* All rights reserved.                                       */
+/*                                                            */
+/**************************************************************/
+
+// Definitions shared by the two sides of the bridge test
+
+#ifndef _VUSERBRIDGE_H_
+#define _VUSERBRIDGE_H_
+
+#define BRIDGE_SOCK    "/tmp/vproc_bridge_test.sock"
+#define LOOKAHEAD      20
+
+#define BRIDGE_BASE    0x80000000
+#define BRIDGE_IRQ     0x80001000
+
+#define DONE_ADDR      0xfffffff0
+
+#endif
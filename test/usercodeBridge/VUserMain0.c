@@ -0,0 +1,176 @@
+/**************************************************************/
+/* VUserMain0.c                              Date: 2024/07/22 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell.                        */
+/* All rights reserved.                                       */
+/*                                                            */
+/**************************************************************/
+
+// Bridge test CPU user code, for node 0 of testBridge.v on the master
+// side. Its accesses to BRIDGE_BASE are forwarded over the bridge to
+// the slave side's memory. It writes and reads back words, with and
+// without byte enables, checking the data and that an access completes
+// at the end of the window after the one it was made in. As each access
+// after the first is made as the last completes, at the same point in a
+// window, each of them must take the same number of cycles. It then
+// sets the slave side's interrupt register, and checks the interrupt is
+// reflected back on its own input within a window, as it returns with
+// the write's response, before clearing it again.
+
+#include "VUser.h"
+#include "VUserBridge.h"
+
+// ------------------------------------------------------------
+// LOCAL DEFINITIONS
+// ------------------------------------------------------------
+
+#define NUM_WORDS      32
+#define IRQ_VALUE      3
+
+// Cycles for an access: more than a window, and up to two windows, plus
+// the few cycles the bridge's register accesses may run past their ends
+#define MIN_CYCLES     (LOOKAHEAD + 1)
+#define MAX_CYCLES     (2 * LOOKAHEAD + 4)
+
+// ------------------------------------------------------------
+// LOCAL STATICS
+// ------------------------------------------------------------
+
+static const unsigned node = 0;
+
+static unsigned errors = 0;
+static unsigned irq    = 0;
+static unsigned accs   = 0;
+static uint64_t last   = 0;
+
+// ------------------------------------------------------------
+// Vectored IRQ callback
+// ------------------------------------------------------------
+
+static int irqCb(int irqIn)
+{
+    irq = irqIn;
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Check that an access starting at the given cycle took from
+// MIN_CYCLES to MAX_CYCLES, and, after the second, as many as
+// the last (the first is made at a different point in a window)
+// ------------------------------------------------------------
+
+static void checkLatency(const char* what, const unsigned addr, const uint64_t start)
+{
+    uint64_t cycles = VGetCycle(node) - start;
+
+    if (cycles < MIN_CYCLES || cycles > MAX_CYCLES)
+    {
+        VPrint("***ERROR: %s at %08x took %d cycles, expected %d to %d\n", what, addr, (int)cycles, MIN_CYCLES, MAX_CYCLES);
+        errors++;
+    }
+    else if (accs > 1 && cycles != last)
+    {
+        VPrint("***ERROR: %s at %08x took %d cycles, the last access %d\n", what, addr, (int)cycles, (int)last);
+        errors++;
+    }
+
+    last = cycles;
+    accs++;
+}
+
+// ------------------------------------------------------------
+// Wait for the reflected interrupt to reach a value, within
+// a window of the write setting it
+// ------------------------------------------------------------
+
+static void waitIrq(const unsigned value)
+{
+    uint64_t start = VGetCycle(node);
+
+    while (irq != value && VGetCycle(node) - start < LOOKAHEAD)
+    {
+        VTickIrq(start + LOOKAHEAD - VGetCycle(node), node);
+    }
+
+    if (irq != value)
+    {
+        VPrint("***ERROR: interrupt is %d after %d cycles, expected %d\n", irq, (int)(VGetCycle(node) - start), value);
+        errors++;
+    }
+}
+
+// ------------------------------------------------------------
+// VuserMainX entry point for node 0
+// ------------------------------------------------------------
+
+void VUserMain0()
+{
+    unsigned addr, data, expected;
+    uint64_t start;
+    int      idx;
+
+    VPrint("VUserMain0(): node=%d\n", node);
+
+    VRegIrq(irqCb, node);
+
+    for (idx = 0; idx < NUM_WORDS; idx++)
+    {
+        addr  = BRIDGE_BASE + (idx << 2);
+        start = VGetCycle(node);
+
+        VWrite(addr, 0x6000 + idx, 0, node);
+
+        checkLatency("write", addr, start);
+    }
+
+    // Overwrite a byte of each word
+    for (idx = 0; idx < NUM_WORDS; idx += 2)
+    {
+        addr  = BRIDGE_BASE + (idx << 2);
+        start = VGetCycle(node);
+
+        VWriteBE(addr, 0xa5 << ((idx & 3) * 8), 1 << (idx & 3), 0, node);
+
+        checkLatency("byte write", addr, start);
+    }
+
+    for (idx = 0; idx < NUM_WORDS; idx++)
+    {
+        addr     = BRIDGE_BASE + (idx << 2);
+        expected = 0x6000 + idx;
+
+        if ((idx & 1) == 0)
+        {
+            expected = (expected & ~(0xff << ((idx & 3) * 8))) | (0xa5 << ((idx & 3) * 8));
+        }
+
+        start = VGetCycle(node);
+
+        VRead(addr, &data, 0, node);
+
+        checkLatency("read", addr, start);
+
+        if (data != expected)
+        {
+            VPrint("***ERROR: read %08x at %08x, expected %08x\n", data, addr, expected);
+            errors++;
+        }
+    }
+
+    // Interrupt round trip
+    VWrite(BRIDGE_IRQ, IRQ_VALUE, 0, node);
+    waitIrq(IRQ_VALUE);
+
+    VWrite(BRIDGE_IRQ, 0, 0, node);
+    waitIrq(0);
+
+    VPrint("VUserMain0(): %s with %d errors\n", errors ? "FAIL" : "PASS", errors);
+
+    VWrite(DONE_ADDR, 1, 0, node);
+
+    while (1)
+    {
+        VTick(GO_TO_SLEEP, node);
+    }
+}
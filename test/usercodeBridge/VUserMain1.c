@@ -0,0 +1,36 @@
+/**************************************************************/
+/* VUserMain1.c                              Date: 2024/07/22 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell.                        */
+/* All rights reserved.                                       */
+/*                                                            */
+/**************************************************************/
+
+// Bridge test user code for node 1 of testBridge.v on the master side,
+// the bridgetgt component's node, running the master side of the
+// bridge
+
+#include "VUser.h"
+#include "VBridge.h"
+#include "VUserBridge.h"
+
+// ------------------------------------------------------------
+// VuserMainX entry point for node 1
+// ------------------------------------------------------------
+
+void VUserMain1()
+{
+    const unsigned node = 1;
+
+    VPrint("VUserMain1(): node=%d\n", node);
+
+    if (VBridgeMaster(BRIDGE_SOCK, LOOKAHEAD, node))
+    {
+        VPrint("***ERROR: VBridgeMaster() failed\n");
+    }
+
+    while (1)
+    {
+        VTick(GO_TO_SLEEP, node);
+    }
+}
@@ -0,0 +1,38 @@
+/**************************************************************/
+/* VUserSlave.c                              Date: 2024/07/22 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell.                        */
+/* All rights reserved.                                       */
+/*                                                            */
+/**************************************************************/
+
+// Bridge test user code for node 0 of testBridge.v on the slave side,
+// replaying the master side's accesses on its bus until the master
+// side's simulation exits, when it finishes its own
+
+#include "VUser.h"
+#include "VBridge.h"
+#include "VUserBridge.h"
+
+// ------------------------------------------------------------
+// VuserMainX entry point for node 0
+// ------------------------------------------------------------
+
+void VUserMain0()
+{
+    const unsigned node = 0;
+
+    VPrint("VUserMain0(): node=%d, slave side\n", node);
+
+    if (VBridgeSlave(BRIDGE_SOCK, LOOKAHEAD, node))
+    {
+        VPrint("***ERROR: VBridgeSlave() failed\n");
+    }
+
+    VWrite(DONE_ADDR, 1, 0, node);
+
+    while (1)
+    {
+        VTick(GO_TO_SLEEP, node);
+    }
+}
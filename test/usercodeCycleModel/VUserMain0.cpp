@@ -0,0 +1,209 @@
+/**************************************************************/
+/* VUserMain0.cpp                            Date: 2024/07/22 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell.                        */
+/* All rights reserved.                                       */
+/*                                                            */
+/**************************************************************/
+
+// Cycle model test user code for testNodes.v, with two nodes. Node 0
+// is a VProcCycleModel, with no user thread, which writes and reads
+// back its memory with word and burst accesses, and then waits in an
+// interruptible tick. Node 1 is a normal user thread which, once the
+// model is waiting, sets and clears node 0's interrupt, ending the
+// tick, after which the model finishes. Each of the model's commands
+// must complete in the cycles it takes after the last, as called on
+// the simulation thread with no gap between them, and the tick must
+// end, with a single level interrupt, as soon as the interrupt is set.
+
+#include "VProcClass.h"
+
+// ------------------------------------------------------------
+// DEFINITIONS
+// ------------------------------------------------------------
+
+#define NUM_WORDS      32
+#define BURST_LEN      16
+#define BURST_ADDR     0x200
+
+#define IRQ_CYCLE      500
+
+#define IRQ_ADDR0      0xffffff00
+#define DONE_ADDR      0xfffffff0
+
+// ------------------------------------------------------------
+// Test cycle model for node 0, stepping through its tests a
+// command at a time
+// ------------------------------------------------------------
+
+class TestModel : public VProcCycleModel
+{
+public:
+         TestModel (const unsigned nodeIn) : VProcCycleModel(nodeIn), state(ST_WRITE), idx(0), errors(0), irqs(0), cycles(0), last(0) {};
+
+    virtual void nextCommand (const unsigned data_in, const unsigned interrupt);
+
+private:
+
+    static unsigned pattern (const unsigned word) {return 0x3000 + word * 0x11;};
+
+    enum {ST_WRITE, ST_READ, ST_BURST_WRITE, ST_BURST_READ, ST_BURST_CHECK, ST_WAIT_IRQ, ST_SLEEP} state;
+
+    unsigned idx;
+    unsigned errors;
+    unsigned irqs;
+    unsigned cycles;
+    uint64_t last;
+    uint32_t wbuf[BURST_LEN];
+    uint32_t rbuf[BURST_LEN];
+};
+
+// ------------------------------------------------------------
+// Set the next command, from the result of the last
+// ------------------------------------------------------------
+
+void TestModel::nextCommand (const unsigned data_in, const unsigned interrupt)
+{
+    // On a level interrupt, count it and leave the current command
+    if (interrupt)
+    {
+        irqs++;
+        return;
+    }
+
+    // The last command completed the cycles it takes after the one before
+    if (cycles && VGetCycle(node) - last != cycles)
+    {
+        VPrint("***ERROR: node %d command completed in cycle %d, %d cycles after the last, expected %d\n",
+               node, (int)VGetCycle(node), (int)(VGetCycle(node) - last), cycles);
+        errors++;
+    }
+
+    last   = VGetCycle(node);
+    cycles = 1;
+
+    switch (state)
+    {
+    case ST_WRITE:
+        write(idx << 2, pattern(idx));
+
+        if (++idx == NUM_WORDS)
+        {
+            state = ST_READ;
+            idx   = 0;
+        }
+        break;
+
+    case ST_READ:
+        // Check the data of the last read, before issuing the next
+        if (idx > 0 && data_in != pattern(idx-1))
+        {
+            VPrint("***ERROR: node %d read %08x at %08x, expected %08x\n", node, data_in, (idx-1) << 2, pattern(idx-1));
+            errors++;
+        }
+
+        if (idx < NUM_WORDS)
+        {
+            read(idx << 2);
+            idx++;
+            break;
+        }
+
+        state = ST_BURST_WRITE;
+        // fall through
+
+    case ST_BURST_WRITE:
+        for (idx = 0; idx < BURST_LEN; idx++)
+        {
+            wbuf[idx] = pattern(NUM_WORDS + idx);
+        }
+
+        burstWrite(BURST_ADDR, wbuf, BURST_LEN);
+        cycles = BURST_LEN;
+        state  = ST_BURST_READ;
+        break;
+
+    case ST_BURST_READ:
+        burstRead(BURST_ADDR, rbuf, BURST_LEN);
+        cycles = BURST_LEN;
+        state  = ST_BURST_CHECK;
+        break;
+
+    case ST_BURST_CHECK:
+        for (idx = 0; idx < BURST_LEN; idx++)
+        {
+            if (rbuf[idx] != pattern(NUM_WORDS + idx))
+            {
+                VPrint("***ERROR: node %d burst read %08x at %08x, expected %08x\n",
+                       node, rbuf[idx], BURST_ADDR + (idx << 2), pattern(NUM_WORDS + idx));
+                errors++;
+            }
+        }
+
+        // Wait for node 1 to interrupt
+        tickIrq(GO_TO_SLEEP);
+        cycles = 0;
+        state  = ST_WAIT_IRQ;
+        break;
+
+    case ST_WAIT_IRQ:
+        // Node 1's write in IRQ_CYCLE sets the interrupt at the next edge,
+        // and the model sees it at the edge after that
+        if (VGetCycle(node) != IRQ_CYCLE + 2 || irqs != 1)
+        {
+            VPrint("***ERROR: node %d woken in cycle %d with %d interrupts, expected cycle %d with 1\n",
+                   node, (int)VGetCycle(node), irqs, IRQ_CYCLE + 2);
+            errors++;
+        }
+
+        VPrint("VUserMain%d(): %s with %d errors\n", node, errors ? "FAIL" : "PASS", errors);
+
+        write(DONE_ADDR, 1);
+        state = ST_SLEEP;
+        break;
+
+    case ST_SLEEP:
+        tick(GO_TO_SLEEP);
+        break;
+    }
+}
+
+// ------------------------------------------------------------
+// LOCAL STATICS
+// ------------------------------------------------------------
+
+static TestModel model(0);
+
+// ------------------------------------------------------------
+// VuserMainX entry point for node 0, registering the model
+// ------------------------------------------------------------
+
+extern "C" void VUserMain0()
+{
+    VPrint("VUserMain0(): node=0, registering cycle model\n");
+
+    model.regModel();
+}
+
+// ------------------------------------------------------------
+// VuserMainX entry point for node 1, interrupting node 0
+// ------------------------------------------------------------
+
+extern "C" void VUserMain1()
+{
+    VProc vp1(1);
+
+    VPrint("VUserMain1(): node=1\n");
+
+    // Interrupt node 0 once it is waiting
+    vp1.waitUntil(IRQ_CYCLE);
+    vp1.write(IRQ_ADDR0, 1);
+    vp1.write(IRQ_ADDR0, 0);
+
+    vp1.write(DONE_ADDR, 1);
+
+    while (1)
+    {
+        vp1.tick(GO_TO_SLEEP);
+    }
+}
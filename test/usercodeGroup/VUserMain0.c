@@ -0,0 +1,200 @@
+/**************************************************************/
+/* VUserMain0.c                              Date: 2024/07/22 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell.                        */
+/* All rights reserved.                                       */
+/*                                                            */
+/**************************************************************/
+
+// Node group test user code for testNodes.v, with three nodes. Nodes 1
+// and 2 join group 0 and return, and node 0's thread drives all three
+// nodes, issuing writes and reads of each node's memory, with idle
+// commands of different lengths. It checks the read data, that each
+// issue takes as many cycles as its longest command, and that every
+// node of an issue starts in the same cycle, by all reading the test
+// bench's cycle count, which must advance with the group's VGetCycle()
+// between reads. Needs VPROC_TWO_PHASE defined.
+
+#include "VUser.h"
+
+// ------------------------------------------------------------
+// LOCAL DEFINITIONS
+// ------------------------------------------------------------
+
+#define GROUP          0
+#define NUM_NODES      3
+
+#define ITERATIONS     20
+
+#define CYCLE_ADDR     0xfffffff8
+#define DONE_ADDR      0xfffffff0
+
+// ------------------------------------------------------------
+// LOCAL STATICS
+// ------------------------------------------------------------
+
+static unsigned errors = 0;
+
+static int      counted = 0;
+static unsigned lastcount;
+static uint64_t lastcycle;
+
+// ------------------------------------------------------------
+// Set the group's commands to the same access on every node,
+// with node dependent data
+// ------------------------------------------------------------
+
+static void setCmds(VGroupCmd_t cmds[], const int rw, const unsigned addr, const unsigned data)
+{
+    unsigned idx;
+
+    for (idx = 0; idx < NUM_NODES; idx++)
+    {
+        cmds[idx].node  = idx;
+        cmds[idx].rw    = rw;
+        cmds[idx].addr  = addr;
+        cmds[idx].data  = data + (idx << 24);
+        cmds[idx].ticks = 0;
+    }
+}
+
+// ------------------------------------------------------------
+// Issue the commands, and check that the issue took the
+// expected number of cycles
+// ------------------------------------------------------------
+
+static void issue(VGroupCmd_t cmds[], const unsigned cycles)
+{
+    uint64_t start = VGetCycle(0);
+
+    VGroupIssue(GROUP, cmds, NUM_NODES);
+
+    if (VGetCycle(0) - start != cycles)
+    {
+        VPrint("***ERROR: group issue took %d cycles, expected %d\n", (int)(VGetCycle(0) - start), cycles);
+        errors++;
+    }
+}
+
+// ------------------------------------------------------------
+// Check that all the nodes of an issue read the same cycle
+// count, having started in the same cycle, and that it has
+// advanced by as many cycles as VGetCycle() since last read
+// ------------------------------------------------------------
+
+static void checkSameCycle(VGroupCmd_t cmds[])
+{
+    unsigned idx;
+
+    setCmds(cmds, V_READ, CYCLE_ADDR, 0);
+    issue(cmds, 1);
+
+    for (idx = 1; idx < NUM_NODES; idx++)
+    {
+        if (cmds[idx].data != cmds[0].data)
+        {
+            VPrint("***ERROR: node %d read cycle %d, node 0 read %d\n", idx, cmds[idx].data, cmds[0].data);
+            errors++;
+        }
+    }
+
+    if (counted && cmds[0].data - lastcount != VGetCycle(0) - lastcycle)
+    {
+        VPrint("***ERROR: test bench count advanced %d cycles, VGetCycle() %d\n",
+               cmds[0].data - lastcount, (int)(VGetCycle(0) - lastcycle));
+        errors++;
+    }
+
+    counted   = 1;
+    lastcount = cmds[0].data;
+    lastcycle = VGetCycle(0);
+}
+
+// ------------------------------------------------------------
+// VuserMainX entry points for nodes 1 and 2, which just join
+// the group
+// ------------------------------------------------------------
+
+void VUserMain1() { VGroupJoin(GROUP, 1); }
+void VUserMain2() { VGroupJoin(GROUP, 2); }
+
+// ------------------------------------------------------------
+// VuserMainX entry point for node 0, driving the group
+// ------------------------------------------------------------
+
+void VUserMain0()
+{
+    VGroupCmd_t cmds[NUM_NODES];
+    unsigned    addr, idx, longest;
+    int         iter;
+
+    VPrint("VUserMain0(): node=0, driving group %d\n", GROUP);
+
+    VGroupJoin(GROUP, 0);
+
+    // Line up the nodes, which may have been scheduled from different
+    // cycles before joining
+    setCmds(cmds, V_IDLE, 0, 0);
+    VGroupIssue(GROUP, cmds, NUM_NODES);
+
+    checkSameCycle(cmds);
+
+    for (iter = 0; iter < ITERATIONS; iter++)
+    {
+        addr = iter << 2;
+
+        // Write every node's memory
+        setCmds(cmds, V_WRITE, addr, 0x5a000 + iter);
+        issue(cmds, 1);
+
+        // Idle for different lengths on each node
+        setCmds(cmds, V_IDLE, 0, 0);
+
+        longest = 0;
+
+        for (idx = 0; idx < NUM_NODES; idx++)
+        {
+            cmds[idx].ticks = 1 + ((iter + idx) % 5);
+            longest         = (cmds[idx].ticks > longest) ? cmds[idx].ticks : longest;
+        }
+
+        issue(cmds, longest);
+
+        checkSameCycle(cmds);
+
+        // Read back the writes, with one node idling longer
+        setCmds(cmds, V_READ, addr, 0);
+        cmds[iter % NUM_NODES].rw    = V_IDLE;
+        cmds[iter % NUM_NODES].ticks = 3;
+        issue(cmds, 3);
+
+        for (idx = 0; idx < NUM_NODES; idx++)
+        {
+            if (idx != iter % NUM_NODES && cmds[idx].data != 0x5a000 + iter + (idx << 24))
+            {
+                VPrint("***ERROR: node %d read %08x at %08x, expected %08x\n", idx, cmds[idx].data, addr, 0x5a000 + iter + (idx << 24));
+                errors++;
+            }
+        }
+    }
+
+    checkSameCycle(cmds);
+
+    VPrint("VUserMain0(): %s with %d errors\n", errors ? "FAIL" : "PASS", errors);
+
+    setCmds(cmds, V_WRITE, DONE_ADDR, 1);
+    VGroupIssue(GROUP, cmds, NUM_NODES);
+
+    // Sleep until the simulation finishes, when all nodes are done
+    while (1)
+    {
+        setCmds(cmds, V_IDLE, 0, 0);
+
+        for (idx = 0; idx < NUM_NODES; idx++)
+        {
+            cmds[idx].ticks = GO_TO_SLEEP;
+        }
+
+        VGroupIssue(GROUP, cmds, NUM_NODES);
+    }
+}
@@ -0,0 +1,174 @@
+/**************************************************************/
+/* VUserMain0.c                              Date: 2024/07/22 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell.                        */
+/* All rights reserved.                                       */
+/*                                                            */
+/**************************************************************/
+
+// Timed idle test user code for testNodes.v, with two nodes, run with
+// the IDLE_TIMED parameter set. Node 0 checks that ticks of various
+// lengths, and waits until a given cycle, take the expected number of
+// cycles, both by VGetCycle() and by the test bench's cycle count. It
+// then waits in a long interruptible tick, which node 1 cuts short by
+// setting node 0's interrupt from its own timed wait. The tick must
+// end at the edge after the interrupt is set, with the cycles it had
+// left returned, rather than run out its timed wait.
+
+#include "VUser.h"
+
+// ------------------------------------------------------------
+// LOCAL DEFINITIONS
+// ------------------------------------------------------------
+
+#define IRQ_CYCLE      5000
+#define IRQ_TICKS      20000
+#define WAIT_TICKS     777
+
+#define IRQ_ADDR0      0xffffff00
+#define CYCLE_ADDR     0xfffffff8
+#define DONE_ADDR      0xfffffff0
+
+// ------------------------------------------------------------
+// LOCAL STATICS
+// ------------------------------------------------------------
+
+static unsigned errors = 0;
+static int      irqs   = 0;
+
+static const unsigned ticks[] = {1, 2, 3, 4, 10, 123, 1000};
+
+// ------------------------------------------------------------
+// Vectored IRQ callback for node 0
+// ------------------------------------------------------------
+
+static int irqCb(int irq)
+{
+    if (irq)
+    {
+        irqs++;
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Check a number of cycles elapsed, by VGetCycle() and by the
+// test bench's cycle count
+// ------------------------------------------------------------
+
+static void checkCycles(const char* what, const uint64_t start, const unsigned startcnt, const unsigned expected, const unsigned node)
+{
+    unsigned count;
+
+    VRead(CYCLE_ADDR, &count, 0, node);
+
+    // The read of the count itself takes a cycle
+    if (VGetCycle(node) - start != expected + 1 || count - startcnt != expected + 1)
+    {
+        VPrint("***ERROR: node %d %s took %d cycles by VGetCycle() and %d by the test bench, expected %d\n",
+               node, what, (int)(VGetCycle(node) - start) - 1, count - startcnt - 1, expected);
+        errors++;
+    }
+}
+
+// ------------------------------------------------------------
+// VuserMainX entry point for node 0
+// ------------------------------------------------------------
+
+void VUserMain0()
+{
+    const unsigned node = 0;
+    uint64_t       start;
+    unsigned       count, remaining;
+    int            idx;
+
+    VPrint("VUserMain0(): node=%d\n", node);
+
+    VRegIrq(irqCb, node);
+
+    // Ticks of various lengths, short and long
+    for (idx = 0; idx < (int)(sizeof(ticks)/sizeof(ticks[0])); idx++)
+    {
+        VRead(CYCLE_ADDR, &count, 0, node);
+        start = VGetCycle(node);
+
+        VTick(ticks[idx], node);
+
+        checkCycles("tick", start, count, ticks[idx], node);
+    }
+
+    // Wait until an absolute cycle
+    VRead(CYCLE_ADDR, &count, 0, node);
+    start = VGetCycle(node);
+
+    VWaitUntil(start + WAIT_TICKS, node);
+
+    if (VGetCycle(node) != start + WAIT_TICKS)
+    {
+        VPrint("***ERROR: node %d waited until cycle %d, expected %d\n", node, (int)VGetCycle(node), (int)(start + WAIT_TICKS));
+        errors++;
+    }
+
+    checkCycles("wait", start, count, WAIT_TICKS, node);
+
+    // Wait in an interruptible tick, until node 1 sets the interrupt
+    start     = VGetCycle(node);
+    remaining = VTickIrq(IRQ_TICKS, node);
+
+    // Node 1's write in IRQ_CYCLE sets the interrupt at the next edge, and
+    // node 0 samples it, ending the tick, at the edge after that
+    if (irqs != 1 || VGetCycle(node) != IRQ_CYCLE + 2)
+    {
+        VPrint("***ERROR: node %d woken in cycle %d with %d interrupts, expected cycle %d\n",
+               node, (int)VGetCycle(node), irqs, IRQ_CYCLE + 2);
+        errors++;
+    }
+
+    // The cycles left are those of the tick not yet run
+    if (remaining + (VGetCycle(node) - start) != IRQ_TICKS)
+    {
+        VPrint("***ERROR: node %d woken after %d cycles with %d remaining, of %d\n",
+               node, (int)(VGetCycle(node) - start), remaining, IRQ_TICKS);
+        errors++;
+    }
+
+    VPrint("VUserMain%d(): %s with %d errors\n", node, errors ? "FAIL" : "PASS", errors);
+
+    VWrite(DONE_ADDR, 1, 0, node);
+
+    // Sleep until the simulation finishes, when all nodes are done
+    while (1)
+    {
+        VTick(GO_TO_SLEEP, node);
+    }
+}
+
+// ------------------------------------------------------------
+// VuserMainX entry point for node 1, interrupting node 0
+// ------------------------------------------------------------
+
+void VUserMain1()
+{
+    const unsigned node = 1;
+
+    VPrint("VUserMain1(): node=%d\n", node);
+
+    VWaitUntil(IRQ_CYCLE, node);
+
+    if (VGetCycle(node) != IRQ_CYCLE)
+    {
+        VPrint("***ERROR: node %d waited until cycle %d, expected %d\n", node, (int)VGetCycle(node), IRQ_CYCLE);
+    }
+
+    VWrite(IRQ_ADDR0, 1, 0, node);
+    VTick(5, node);
+    VWrite(IRQ_ADDR0, 0, 0, node);
+
+    VWrite(DONE_ADDR, 1, 0, node);
+
+    while (1)
+    {
+        VTick(GO_TO_SLEEP, node);
+    }
+}
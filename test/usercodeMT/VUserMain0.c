@@ -0,0 +1,95 @@
+/**************************************************************/
+/* VUserMain0.c                              Date: 2024/07/15 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell.                        */
+/* All rights reserved.                                       */
+/*                                                            */
+/**************************************************************/
+
+// Multi-node stress test user code for testMT.v. Every node runs the
+// same code: a compute-heavy loop between each write and read back
+// of its own memory, so that the run time is dominated by the user
+// threads, which overlap when the simulator calls into the nodes from
+// different threads (Verilator with --threads).
+
+#include "VUser.h"
+
+// ------------------------------------------------------------
+// LOCAL DEFINITIONS
+// ------------------------------------------------------------
+
+#define NUM_NODES      16
+
+#define ITERATIONS     2000
+#define WORK_ROUNDS    20000
+#define MEM_WORDS      256
+
+#define DONE_ADDR      0xfffffff0
+
+// ------------------------------------------------------------
+// Stand-in for model work between bus accesses
+// ------------------------------------------------------------
+
+static uint32_t work(uint32_t x)
+{
+    int idx;
+
+    for (idx = 0; idx < WORK_ROUNDS; idx++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+
+    return x;
+}
+
+// ------------------------------------------------------------
+// Test run by each node
+// ------------------------------------------------------------
+
+static void runTest(const unsigned node)
+{
+    uint32_t  x      = 0x250864 + node;
+    unsigned  errors = 0;
+    unsigned  addr, data;
+    int       idx;
+
+    VPrint("VUserMain%d(): node=%d\n", node, node);
+
+    for (idx = 0; idx < ITERATIONS; idx++)
+    {
+        x    = work(x);
+        addr = (idx % MEM_WORDS) << 2;
+
+        VWrite(addr, x, 0, node);
+        VRead(addr, &data, 0, node);
+
+        if (data != x)
+        {
+            VPrint("***ERROR: node %d read %08x at %08x, expected %08x\n", node, data, addr, x);
+            errors++;
+        }
+    }
+
+    VPrint("VUserMain%d(): %s with %d errors\n", node, errors ? "FAIL" : "PASS", errors);
+
+    VWrite(DONE_ADDR, 1, 0, node);
+
+    // Sleep until the simulation finishes, when all nodes are done
+    while (1)
+    {
+        VTick(GO_TO_SLEEP, node);
+    }
+}
+
+// ------------------------------------------------------------
+// VuserMainX entry points for nodes 0 to NUM_NODES-1
+// ------------------------------------------------------------
+
+#define VUSERMAIN(_n) void VUserMain##_n() { runTest(_n); }
+
+VUSERMAIN(0)  VUSERMAIN(1)  VUSERMAIN(2)  VUSERMAIN(3)
+VUSERMAIN(4)  VUSERMAIN(5)  VUSERMAIN(6)  VUSERMAIN(7)
+VUSERMAIN(8)  VUSERMAIN(9)  VUSERMAIN(10) VUSERMAIN(11)
+VUSERMAIN(12) VUSERMAIN(13) VUSERMAIN(14) VUSERMAIN(15)
@@ -0,0 +1,258 @@
+/**************************************************************/
+/* VUserMain0.c                              Date: 2024/07/22 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell.                        */
+/* All rights reserved.                                       */
+/*                                                            */
+/**************************************************************/
+
+// Mailbox and barrier test user code for testNodes.v, with four nodes.
+// Node 0 sends a sequence of messages to node 1, which echoes each one
+// back, and node 2 sends messages of varying length to node 3, with
+// the receivers checking the messages' order and contents, and that
+// each is received at the first clock edge after it was sent, or at
+// once if that has passed. All four nodes then meet at a barrier, after
+// idling for different times, and send node 0 the cycles they arrived
+// at and left it in. All must leave at the edge after the last arrived.
+
+#include <stddef.h>
+#include "VUser.h"
+#include "VMbox.h"
+
+// ------------------------------------------------------------
+// LOCAL DEFINITIONS
+// ------------------------------------------------------------
+
+#define NUM_NODES      4
+
+#define NUM_MSGS       50
+#define NUM_ROUNDS     10
+#define MAX_WORDS      16
+
+#define MBOX_PING      0
+#define MBOX_ECHO      1
+#define MBOX_DATA      2
+#define MBOX_CYCLE     3
+
+#define BARRIER        0
+
+#define DONE_ADDR      0xfffffff0
+
+typedef struct {
+    uint32_t seq;
+    uint64_t cycle;
+    uint32_t words[MAX_WORDS];
+} msg_t;
+
+typedef struct {
+    uint64_t arrived;
+    uint64_t left;
+} barrier_msg_t;
+
+// ------------------------------------------------------------
+// Check a received message against the expected sequence
+// number and length, and that it was received in the cycle
+// after it was sent, or the cycle VMboxRecv() was called if
+// later, returning the number of errors
+// ------------------------------------------------------------
+
+static unsigned checkMsg(const msg_t* msg, const int len, const uint32_t seq, const int explen, const uint64_t called, const unsigned node)
+{
+    unsigned errors = 0;
+    uint64_t expcycle = (called > msg->cycle) ? called : msg->cycle + 1;
+    int      idx;
+
+    if (len != explen || msg->seq != seq)
+    {
+        VPrint("***ERROR: node %d received message %d of %d bytes, expected %d of %d bytes\n", node, msg->seq, len, seq, explen);
+        return 1;
+    }
+
+    if (VGetCycle(node) != expcycle)
+    {
+        VPrint("***ERROR: node %d received message %d in cycle %d, sent in cycle %d, expected in cycle %d\n",
+               node, seq, (int)VGetCycle(node), (int)msg->cycle, (int)expcycle);
+        errors++;
+    }
+
+    for (idx = 0; idx < (int)((len - offsetof(msg_t, words)) / sizeof(uint32_t)); idx++)
+    {
+        if (msg->words[idx] != seq * MAX_WORDS + idx)
+        {
+            VPrint("***ERROR: node %d received word %d of message %d as %08x\n", node, idx, seq, msg->words[idx]);
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+// ------------------------------------------------------------
+// Send a message with the given sequence number and number
+// of words
+// ------------------------------------------------------------
+
+static void sendMsg(const unsigned mbox, const uint32_t seq, const int numwords, const unsigned node)
+{
+    msg_t msg;
+    int   idx;
+
+    msg.seq   = seq;
+    msg.cycle = VGetCycle(node);
+
+    for (idx = 0; idx < numwords; idx++)
+    {
+        msg.words[idx] = seq * MAX_WORDS + idx;
+    }
+
+    VMboxSend(mbox, &msg, offsetof(msg_t, words) + numwords * sizeof(uint32_t), node);
+}
+
+// ------------------------------------------------------------
+// Message passing between pairs of nodes
+// ------------------------------------------------------------
+
+static unsigned runMsgs(const unsigned node)
+{
+    unsigned errors = 0;
+    uint64_t called;
+    msg_t    msg;
+    int      len;
+    int      seq;
+
+    for (seq = 0; seq < NUM_MSGS; seq++)
+    {
+        switch (node)
+        {
+        case 0:
+            sendMsg(MBOX_PING, seq, 1, node);
+
+            // Let a few messages queue up before waiting for the echoes
+            if (seq >= 3)
+            {
+                called  = VGetCycle(node);
+                len     = VMboxRecv(MBOX_ECHO, &msg, sizeof(msg), node);
+                errors += checkMsg(&msg, len, seq - 3, offsetof(msg_t, words) + sizeof(uint32_t), called, node);
+            }
+
+            VTick(1 + seq % 3, node);
+            break;
+
+        case 1:
+            called  = VGetCycle(node);
+            len     = VMboxRecv(MBOX_PING, &msg, sizeof(msg), node);
+            errors += checkMsg(&msg, len, seq, offsetof(msg_t, words) + sizeof(uint32_t), called, node);
+            sendMsg(MBOX_ECHO, seq, 1, node);
+            break;
+
+        case 2:
+            sendMsg(MBOX_DATA, seq, seq % (MAX_WORDS + 1), node);
+            VTick(1 + seq % 7, node);
+            break;
+
+        case 3:
+            // Receive in bursts, with the sender running ahead in between
+            if (seq % 5 == 0)
+            {
+                VTick(20, node);
+            }
+
+            called  = VGetCycle(node);
+            len     = VMboxRecv(MBOX_DATA, &msg, sizeof(msg), node);
+            errors += checkMsg(&msg, len, seq, offsetof(msg_t, words) + (seq % (MAX_WORDS + 1)) * sizeof(uint32_t), called, node);
+            break;
+        }
+    }
+
+    // Collect the last of the echoes
+    for (seq = NUM_MSGS - 3; node == 0 && seq < NUM_MSGS; seq++)
+    {
+        called  = VGetCycle(node);
+        len     = VMboxRecv(MBOX_ECHO, &msg, sizeof(msg), node);
+        errors += checkMsg(&msg, len, seq, offsetof(msg_t, words) + sizeof(uint32_t), called, node);
+    }
+
+    return errors;
+}
+
+// ------------------------------------------------------------
+// All nodes meet at a barrier, and check they all leave it in
+// the cycle after the last arrived
+// ------------------------------------------------------------
+
+static unsigned runBarriers(const unsigned node)
+{
+    unsigned      errors = 0;
+    barrier_msg_t cycles[NUM_NODES];
+    uint64_t      last;
+    unsigned      idx;
+    int           round;
+
+    for (round = 0; round < NUM_ROUNDS; round++)
+    {
+        VTick(1 + (node * 3 + round) % 7, node);
+
+        cycles[node].arrived = VGetCycle(node);
+        VBarrier(BARRIER, NUM_NODES, node);
+        cycles[node].left    = VGetCycle(node);
+
+        if (node != 0)
+        {
+            VMboxSend(MBOX_CYCLE, &cycles[node], sizeof(barrier_msg_t), node);
+        }
+        else
+        {
+            last = cycles[0].arrived;
+
+            for (idx = 1; idx < NUM_NODES; idx++)
+            {
+                VMboxRecv(MBOX_CYCLE, &cycles[idx], sizeof(barrier_msg_t), node);
+                last = (cycles[idx].arrived > last) ? cycles[idx].arrived : last;
+            }
+
+            for (idx = 0; idx < NUM_NODES; idx++)
+            {
+                if (cycles[idx].left != last + 1)
+                {
+                    VPrint("***ERROR: a node left barrier round %d in cycle %d, with the last arriving in cycle %d\n",
+                           round, (int)cycles[idx].left, (int)last);
+                    errors++;
+                }
+            }
+        }
+    }
+
+    return errors;
+}
+
+// ------------------------------------------------------------
+// Test run by each node
+// ------------------------------------------------------------
+
+static void runTest(const unsigned node)
+{
+    unsigned errors;
+
+    VPrint("VUserMain%d(): node=%d\n", node, node);
+
+    errors  = runMsgs(node);
+    errors += runBarriers(node);
+
+    VPrint("VUserMain%d(): %s with %d errors\n", node, errors ? "FAIL" : "PASS", errors);
+
+    VWrite(DONE_ADDR, 1, 0, node);
+
+    // Sleep until the simulation finishes, when all nodes are done
+    while (1)
+    {
+        VTick(GO_TO_SLEEP, node);
+    }
+}
+
+// ------------------------------------------------------------
+// VuserMainX entry points for nodes 0 to NUM_NODES-1
+// ------------------------------------------------------------
+
+#define VUSERMAIN(_n) void VUserMain##_n() { runTest(_n); }
+
+VUSERMAIN(0)  VUSERMAIN(1)  VUSERMAIN(2)  VUSERMAIN(3)
@@ -0,0 +1,156 @@
+/**************************************************************/
+/* VUserMain0.c                              Date: 2024/07/22 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell.                        */
+/* All rights reserved.                                       */
+/*                                                            */
+/**************************************************************/
+
+// Out-of-process user code test for testNodes.v, with two nodes. Node
+// 0's user code is run in a separate process, linked with the client
+// library, and connected over shared memory (VPROC_SHM set, with
+// VPROC_SHM_NODES=1), while node 1's runs in-process as normal. Node 0
+// writes and reads back its memory with word and burst accesses, and
+// then waits in an interruptible tick until node 1 sets its interrupt,
+// checking that its IRQ callback is called. The accesses must take the
+// same cycles as in-process, and the tick must end at the edge after
+// the interrupt is set. Its user code then returns, ending the user
+// process, and the simulation puts the node to sleep.
+
+#include <string.h>
+#include "VUser.h"
+
+// ------------------------------------------------------------
+// LOCAL DEFINITIONS
+// ------------------------------------------------------------
+
+#define NUM_WORDS      64
+#define BURST_LEN      256
+#define BURST_ADDR     0x400
+
+#define IRQ_CYCLE      1000
+#define IRQ_VALUE      5
+
+#define IRQ_ADDR0      0xffffff00
+#define DONE_ADDR      0xfffffff0
+
+// ------------------------------------------------------------
+// LOCAL STATICS
+// ------------------------------------------------------------
+
+static unsigned lastirq = 0;
+static int      irqs    = 0;
+
+// ------------------------------------------------------------
+// Vectored IRQ callback for node 0, called in its process
+// ------------------------------------------------------------
+
+static int irqCb(int irq)
+{
+    lastirq = irq;
+    irqs++;
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// VuserMainX entry point for node 0, run out-of-process
+// ------------------------------------------------------------
+
+void VUserMain0()
+{
+    const unsigned node = 0;
+    unsigned       errors = 0;
+    uint32_t       buf[BURST_LEN];
+    uint64_t       start;
+    unsigned       data;
+    int            idx;
+
+    VPrint("VUserMain0(): node=%d\n", node);
+
+    VRegIrq(irqCb, node);
+
+    start = VGetCycle(node);
+
+    for (idx = 0; idx < NUM_WORDS; idx++)
+    {
+        VWrite(idx << 2, 0x4000 + idx, 0, node);
+    }
+
+    for (idx = 0; idx < NUM_WORDS; idx++)
+    {
+        VRead(idx << 2, &data, 0, node);
+
+        if (data != 0x4000 + idx)
+        {
+            VPrint("***ERROR: node %d read %08x at %08x, expected %08x\n", node, data, idx << 2, 0x4000 + idx);
+            errors++;
+        }
+    }
+
+    // Burst data is passed through the shared memory segment
+    for (idx = 0; idx < BURST_LEN; idx++)
+    {
+        buf[idx] = 0x5000 + idx;
+    }
+
+    VBurstWrite(BURST_ADDR, buf, BURST_LEN, node);
+
+    memset(buf, 0, sizeof(buf));
+    VBurstRead(BURST_ADDR, buf, BURST_LEN, node);
+
+    for (idx = 0; idx < BURST_LEN; idx++)
+    {
+        if (buf[idx] != 0x5000 + idx)
+        {
+            VPrint("***ERROR: node %d burst read %08x at %08x, expected %08x\n", node, buf[idx], BURST_ADDR + (idx << 2), 0x5000 + idx);
+            errors++;
+        }
+    }
+
+    // Each word access takes a cycle, and each burst a cycle per word
+    if (VGetCycle(node) - start != 2*NUM_WORDS + 2*BURST_LEN)
+    {
+        VPrint("***ERROR: node %d accesses took %d cycles, expected %d\n",
+               node, (int)(VGetCycle(node) - start), 2*NUM_WORDS + 2*BURST_LEN);
+        errors++;
+    }
+
+    // Wait for node 1 to interrupt. Its write in IRQ_CYCLE sets the
+    // interrupt at the next edge, which node 0 samples at the one after.
+    VTickIrq(GO_TO_SLEEP, node);
+
+    if (irqs != 1 || lastirq != IRQ_VALUE || VGetCycle(node) != IRQ_CYCLE + 2)
+    {
+        VPrint("***ERROR: node %d woken in cycle %d with %d IRQ callbacks (last %d), expected cycle %d with one of %d\n",
+               node, (int)VGetCycle(node), irqs, lastirq, IRQ_CYCLE + 2, IRQ_VALUE);
+        errors++;
+    }
+
+    VPrint("VUserMain%d(): %s with %d errors\n", node, errors ? "FAIL" : "PASS", errors);
+
+    VWrite(DONE_ADDR, 1, 0, node);
+}
+
+// ------------------------------------------------------------
+// VuserMainX entry point for node 1, run in-process
+// ------------------------------------------------------------
+
+void VUserMain1()
+{
+    const unsigned node = 1;
+
+    VPrint("VUserMain1(): node=%d\n", node);
+
+    VWaitUntil(IRQ_CYCLE, node);
+
+    VWrite(IRQ_ADDR0, IRQ_VALUE, 0, node);
+    VWrite(IRQ_ADDR0, 0,         0, node);
+
+    VWrite(DONE_ADDR, 1, 0, node);
+
+    while (1)
+    {
+        VTick(GO_TO_SLEEP, node);
+    }
+}
@@ -0,0 +1,138 @@
+/**************************************************************/
+/* VUserMain0.c                              Date: 2024/07/22 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell.                        */
+/* All rights reserved.                                       */
+/*                                                            */
+/**************************************************************/
+
+// Tracing test user code for testNodes.v, with two nodes, run with
+// VPROC_TRACE set. Node 0 makes a known number of each kind of
+// transaction, and then interrupts node 1, which is waiting in an
+// interruptible tick. The trace written at exit is checked against
+// these by checktrace.py.
+
+#include "VUser.h"
+
+// ------------------------------------------------------------
+// LOCAL DEFINITIONS
+// ------------------------------------------------------------
+
+#define NUM_WRITES     20
+#define NUM_READS      10
+#define NUM_TICKS      5
+#define BURST_LEN      16
+
+#define IRQ_ADDR1      0xffffff04
+#define DONE_ADDR      0xfffffff0
+
+// ------------------------------------------------------------
+// LOCAL STATICS
+// ------------------------------------------------------------
+
+static volatile int irqs = 0;
+
+// ------------------------------------------------------------
+// Vectored IRQ callback for node 1
+// ------------------------------------------------------------
+
+static int irqCb(int irq)
+{
+    if (irq)
+    {
+        irqs++;
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// VuserMainX entry point for node 0, making the transactions
+// ------------------------------------------------------------
+
+void VUserMain0()
+{
+    const unsigned node = 0;
+    unsigned       errors = 0;
+    uint32_t       wbuf[BURST_LEN], rbuf[BURST_LEN];
+    unsigned       data;
+    int            idx;
+
+    VPrint("VUserMain0(): node=%d\n", node);
+
+    for (idx = 0; idx < NUM_WRITES; idx++)
+    {
+        VWrite(idx << 2, 0x1000 + idx, 0, node);
+    }
+
+    for (idx = 0; idx < NUM_READS; idx++)
+    {
+        VRead(idx << 2, &data, 0, node);
+
+        if (data != 0x1000 + idx)
+        {
+            VPrint("***ERROR: node %d read %08x at %08x, expected %08x\n", node, data, idx << 2, 0x1000 + idx);
+            errors++;
+        }
+    }
+
+    for (idx = 0; idx < BURST_LEN; idx++)
+    {
+        wbuf[idx] = 0x2000 + idx;
+    }
+
+    VBurstWrite(0x100, wbuf, BURST_LEN, node);
+    VBurstRead(0x100, rbuf, BURST_LEN, node);
+
+    for (idx = 0; idx < BURST_LEN; idx++)
+    {
+        if (rbuf[idx] != 0x2000 + idx)
+        {
+            VPrint("***ERROR: node %d burst read %08x at %08x, expected %08x\n", node, rbuf[idx], 0x100 + (idx << 2), 0x2000 + idx);
+            errors++;
+        }
+    }
+
+    for (idx = 0; idx < NUM_TICKS; idx++)
+    {
+        VTick(10, node);
+    }
+
+    // Interrupt node 1, and clear the interrupt
+    VWrite(IRQ_ADDR1, 1, 0, node);
+    VWrite(IRQ_ADDR1, 0, 0, node);
+
+    VPrint("VUserMain0(): %s with %d errors\n", errors ? "FAIL" : "PASS", errors);
+
+    VWrite(DONE_ADDR, 1, 0, node);
+
+    // Sleep until the simulation finishes, when all nodes are done
+    while (1)
+    {
+        VTick(GO_TO_SLEEP, node);
+    }
+}
+
+// ------------------------------------------------------------
+// VuserMainX entry point for node 1, waiting for an interrupt
+// ------------------------------------------------------------
+
+void VUserMain1()
+{
+    const unsigned node = 1;
+
+    VPrint("VUserMain1(): node=%d\n", node);
+
+    VRegIrq(irqCb, node);
+
+    VTickIrq(GO_TO_SLEEP, node);
+
+    VPrint("VUserMain1(): %s with %d interrupts\n", irqs == 1 ? "PASS" : "***ERROR: FAIL", irqs);
+
+    VWrite(DONE_ADDR, 1, 0, node);
+
+    while (1)
+    {
+        VTick(GO_TO_SLEEP, node);
+    }
+}
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+###################################################################
+# Trace check for the usercodeTrace test
+#
+# Copyright (c) 2024 Simon Southwell.
+#
+# This file is part of VProc.
+#
+# VProc is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# VProc is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with VProc. If not, see <http://www.gnu.org/licenses/>.
+#
+###################################################################
+
+# Checks the trace written with VPROC_TRACE by the usercodeTrace test
+# against the transactions made by its user code, in order, with their
+# addresses or tick counts, and the clock cycle each completed in.
+# Usage:
+#
+#   python3 checktrace.py trace.json
+
+import json
+import sys
+
+# Transactions made by node 0 (see VUserMain0.c)
+NUM_WRITES  = 20
+NUM_READS   = 10
+NUM_TICKS   = 5
+TICK_CYCLES = 10
+BURST_LEN   = 16
+BURST_ADDR  = 0x100
+
+IRQ_ADDR1   = 0xffffff04
+DONE_ADDR   = 0xfffffff0
+GO_TO_SLEEP = 0x7fffffff
+
+PID_SIM     = 0
+PID_USER    = 1
+
+# Node 0's transactions as (name, argument name, argument, cycles taken).
+# testNodes.v acknowledges each access in the cycle after it's made.
+NODE0_TRANS = ([("write", "addr", idx << 2, 1) for idx in range(NUM_WRITES)] +
+               [("read",  "addr", idx << 2, 1) for idx in range(NUM_READS)]  +
+               [("burst write", "addr", BURST_ADDR, BURST_LEN),
+                ("burst read",  "addr", BURST_ADDR, BURST_LEN)]               +
+               [("tick", "ticks", TICK_CYCLES, TICK_CYCLES)] * NUM_TICKS      +
+               [("write", "addr", IRQ_ADDR1, 1)] * 2                          +
+               [("write", "addr", DONE_ADDR, 1)])
+
+def select(events, pid, node, names = None) :
+    return [ev for ev in events if ev["pid"] == pid and ev["tid"] == node and (names is None or ev["name"] in names)]
+
+def transactions(events, node) :
+    return [ev for ev in select(events, PID_USER, node) if ev["ph"] == "X" and ev["cat"] != "user"]
+
+# Check a node's transactions against those expected, as (name, argument
+# name, argument, cycle completed)
+def checkTrans(errors, events, node, expected) :
+    trans = transactions(events, node)
+
+    if len(trans) != len(expected) :
+        errors.append("node %d has %d transactions, expected %d" % (node, len(trans), len(expected)))
+
+    for ev, (name, argname, arg, cycle) in zip(trans, expected) :
+        if ev["name"] != name or ev["args"].get(argname) != arg or ev["args"]["cycle"] != cycle :
+            errors.append("node %d has %s %s, expected %s with %s %d in cycle %d" % (node, ev["name"], ev["args"], name, argname, arg, cycle))
+            break
+
+def check(events) :
+    errors = []
+
+    # Both nodes' user code, and the simulator's waits for it, are traced,
+    # with the node's first command issued in cycle 1
+    for node in (0, 1) :
+        for pid, name in ((PID_USER, "user"), (PID_SIM, "wait user")) :
+            if not select(events, pid, node, (name,)) :
+                errors.append("node %d has no %s events" % (node, name))
+
+        user = select(events, PID_USER, node, ("user",))
+
+        if user and user[0]["args"]["cycle"] != 1 :
+            errors.append("node %d user code started in cycle %d, expected 1" % (node, user[0]["args"]["cycle"]))
+
+        spans = transactions(events, node)
+
+        for prev, ev in zip(spans, spans[1:]) :
+            if ev["ts"] < prev["ts"] :
+                errors.append("node %d %s event out of time order" % (node, ev["name"]))
+                break
+
+    # Node 0's transactions, each completing the cycles it takes after
+    # the last
+    expected = []
+    cycle    = 1
+
+    for name, argname, arg, cycles in NODE0_TRANS :
+        cycle += cycles
+        expected.append((name, argname, arg, cycle))
+
+    checkTrans(errors, events, 0, expected)
+
+    # Node 1's sleeping interruptible tick ends in the cycle after node 0's
+    # write setting its interrupt completes, when the new interrupt value
+    # is first sampled, before it writes to DONE
+    irqset = [ev for ev in transactions(events, 0) if ev["args"].get("addr") == IRQ_ADDR1]
+
+    if irqset :
+        woken = irqset[0]["args"]["cycle"] + 1
+        checkTrans(errors, events, 1, [("tick irq", "ticks", GO_TO_SLEEP, woken),
+                                       ("write",    "addr",  DONE_ADDR,   woken + 1)])
+
+    # The simulator calls node 1's vectored IRQ callback as the interrupt
+    # is set and then cleared
+    vectors = [ev["args"]["vector"] for ev in select(events, PID_SIM, 1, ("irq",))]
+
+    if vectors != [1, 0] :
+        errors.append("node 1 has irq events with vectors %s, expected [1, 0]" % vectors)
+
+    if select(events, PID_SIM, 0, ("irq",)) :
+        errors.append("node 0 has irq events, expected none")
+
+    return errors
+
+if __name__ == "__main__" :
+
+    try :
+        with open(sys.argv[1]) as fp :
+            trace = json.load(fp)
+    except (OSError, ValueError) as err :
+        print("***ERROR: can't read trace %s: %s" % (sys.argv[1], err))
+        sys.exit(1)
+
+    errors = check([ev for ev in trace["traceEvents"] if ev["ph"] != "M"])
+
+    for err in errors :
+        print("***ERROR: %s" % err)
+
+    print("checktrace.py: %s with %d errors" % ("FAIL" if errors else "PASS", len(errors)))
+
+    sys.exit(1 if errors else 0)
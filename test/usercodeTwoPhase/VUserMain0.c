@@ -0,0 +1,141 @@
+/**************************************************************/
+/* VUserMain0.c                              Date: 2024/07/22 */
+/*                                                            */
+/* Copyright (c) 2024 Simon Southwell.                        */
+/* All rights reserved.                                       */
+/*                                                            */
+/**************************************************************/
+
+// Two-phase scheduling test user code for testNodes.v. Every node runs
+// the same accesses, so that all are scheduled on the same clock edges,
+// and between each access waits at a rendezvous for all the other nodes'
+// user threads to arrive. This can only complete when the threads of
+// the nodes scheduled in a time step run concurrently, as they do with
+// VPROC_TWO_PHASE defined. Otherwise the first node's thread times out
+// waiting, as the simulator waits for its command before releasing the
+// next node. At each rendezvous, every node also checks that all the
+// others completed their last access on the same cycle as it did.
+
+#include <time.h>
+#include "VUser.h"
+
+// ------------------------------------------------------------
+// LOCAL DEFINITIONS
+// ------------------------------------------------------------
+
+#define NUM_NODES      4
+
+#define ITERATIONS     100
+#define MEM_WORDS      1024
+#define TIMEOUT_SECS   5
+
+#define DONE_ADDR      0xfffffff0
+
+// ------------------------------------------------------------
+// LOCAL STATICS
+// ------------------------------------------------------------
+
+// Count of arrivals at the rendezvous, by all nodes
+static unsigned arrived = 0;
+
+// Cycle on which each node's last access completed
+static uint64_t cycles[NUM_NODES];
+
+// ------------------------------------------------------------
+// Wait for all the nodes to arrive at the rendezvous for the
+// given round. Returns non-zero if they didn't within the
+// (wall clock) timeout.
+// ------------------------------------------------------------
+
+static int rendezvous(const unsigned round)
+{
+    struct timespec start, now;
+
+    __atomic_add_fetch(&arrived, 1, __ATOMIC_SEQ_CST);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (__atomic_load_n(&arrived, __ATOMIC_SEQ_CST) < NUM_NODES * (round + 1))
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        if (now.tv_sec - start.tv_sec > TIMEOUT_SECS)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Test run by each node
+// ------------------------------------------------------------
+
+static void runTest(const unsigned node)
+{
+    unsigned  errors = 0;
+    unsigned  addr, data, wdata;
+    unsigned  other;
+    int       idx;
+
+    VPrint("VUserMain%d(): node=%d\n", node, node);
+
+    // Start all the nodes on the same clock edge
+    VWrite(0, 0, 0, node);
+
+    __atomic_store_n(&cycles[node], VGetCycle(node), __ATOMIC_SEQ_CST);
+
+    for (idx = 0; idx < ITERATIONS; idx++)
+    {
+        if (rendezvous(idx))
+        {
+            VPrint("***ERROR: node %d timed out at rendezvous %d, with user threads not run concurrently\n", node, idx);
+            errors++;
+            break;
+        }
+
+        // No node can update its cycle again until all have issued their next access
+        for (other = 0; other < NUM_NODES; other++)
+        {
+            if (__atomic_load_n(&cycles[other], __ATOMIC_SEQ_CST) != cycles[node])
+            {
+                VPrint("***ERROR: node %d at cycle %lld at rendezvous %d, but node %d at cycle %lld\n", node,
+                       (long long)cycles[node], idx, other, (long long)__atomic_load_n(&cycles[other], __ATOMIC_SEQ_CST));
+                errors++;
+            }
+        }
+
+        addr  = (idx % MEM_WORDS) << 2;
+        wdata = (node << 24) | idx;
+
+        VWrite(addr, wdata, 0, node);
+        VRead(addr, &data, 0, node);
+
+        if (data != wdata)
+        {
+            VPrint("***ERROR: node %d read %08x at %08x, expected %08x\n", node, data, addr, wdata);
+            errors++;
+        }
+
+        __atomic_store_n(&cycles[node], VGetCycle(node), __ATOMIC_SEQ_CST);
+    }
+
+    VPrint("VUserMain%d(): %s with %d errors\n", node, errors ? "FAIL" : "PASS", errors);
+
+    VWrite(DONE_ADDR, 1, 0, node);
+
+    // Sleep until the simulation finishes, when all nodes are done
+    while (1)
+    {
+        VTick(GO_TO_SLEEP, node);
+    }
+}
+
+// ------------------------------------------------------------
+// VuserMainX entry points for nodes 0 to NUM_NODES-1
+// ------------------------------------------------------------
+
+#define VUSERMAIN(_n) void VUserMain##_n() { runTest(_n); }
+
+VUSERMAIN(0)  VUSERMAIN(1)  VUSERMAIN(2)  VUSERMAIN(3)
@@ -31,6 +31,7 @@
 `define BLKBITS                 13:2
 `define BEBITS                  17:14
 `define LBEBITS                 21:18
+`define IRQBRKBIT               22
 
 `define DELTACYCLE              -1
 `define DONTCARE                 0
@@ -51,6 +52,8 @@
 `define VAccess                  VAccess
 `define VInit                    VInit
 `define VSched                   VSched
+`define VSchedPost               VSchedPost
+`define VSchedCollect            VSchedCollect
 `define VIrq                     VIrq
 `define VProcUser                VProcUser
 
@@ -60,6 +63,8 @@
 `define VAccess                  $vaccess
 `define VInit                    $vinit
 `define VSched                   $vsched
+`define VSchedPost               $vschedpost
+`define VSchedCollect            $vschedcollect
 `define VIrq                     $virq
 `define VProcUser                $vprocuser
 
@@ -22,18 +22,35 @@
 //
 // ====================================================================
 
-// Import DPI-C fuctions
+// Import DPI-C fuctions. Those that may wake a parked node, by calling
+// the VProc module's exported VWake function, are context imports.
 
-import "DPI-C" function void VInit     (input  int node);
+import "DPI-C" context function void VInit     (input  int node);
 
-import "DPI-C" function void VSched    (input  int node, 
-                                        input  int Interrupt,
-                                        input  int VPDataIn, 
-                                        output int VPDataOut,
-                                        output int VPAddr, 
-                                        output int VPRw,
-                                        output int VPTicks);
+import "DPI-C" context function void VSched    (input  int node, 
+                                                input  int Interrupt,
+                                                input  int VPDataIn, 
+                                                output int VPDataOut,
+                                                output int VPAddr, 
+                                                output int VPRw,
+                                                output int VPTicks,
+                                                input  int VPCycle,
+                                                input  int VPTimeLo,
+                                                input  int VPTimeHi);
                                         
+import "DPI-C" function void VSchedPost    (input  int node,
+                                            input  int Interrupt,
+                                            input  int VPDataIn,
+                                            input  int VPCycle,
+                                            input  int VPTimeLo,
+                                            input  int VPTimeHi);
+
+import "DPI-C" context function void VSchedCollect (input  int node,
+                                                    output int VPDataOut,
+                                                    output int VPAddr,
+                                                    output int VPRw,
+                                                    output int VPTicks);
+
 import "DPI-C" function void VAccess   (input  int node,
                                         input  int idx,
                                         input  int VPDataIn,